@@ -28,6 +28,44 @@
 uint32 get_compressed_size(const PB_SequenceInfo* info,
 						   PB_CodeSet* codeset);
 
+/**
+ * get_stream_offset()
+ * 		Returns the offset of the stream of a sequence compressed with a
+ * 		code set, which is the aligned size of header, codewords, index
+ * 		and composition summary.
+ *
+ * 	uint32 sequence_length : length of the sequence
+ * 	const PB_CodeSet* codeset : code used for compression
+ * 	bool with_composition : whether the composition is stored
+ * 	uint8 index_shift : density of the index, see PB_INDEX_PART_SIZE_OF()
+ */
+uint32 get_stream_offset(uint32 sequence_length,
+						 const PB_CodeSet* codeset,
+						 bool with_composition,
+						 uint8 index_shift);
+
+/**
+ * get_index_shift()
+ * 		Parses an index density type modifier, which is the number of
+ * 		characters per index part, given as a number or as "index=<n>".
+ * 		Returns the index shift or (-1), if the type modifier is not an
+ * 		index density.
+ *
+ * 	const char* modifier : type modifier
+ */
+int get_index_shift(const char* modifier);
+
+/**
+ * get_summary_word_map()
+ * 		Maps every symbol to the index of the codeword, that encodes it,
+ * 		or to (-1), if the code set can not express it.
+ *
+ * 	const PB_CodeSet* codeset : code used for compression
+ * 	bool ignore_case : whether lower case symbols are encoded as upper case
+ * 	int16* words : output, PB_SOURCE_ALPHABET_SIZE elements
+ */
+void get_summary_word_map(const PB_CodeSet* codeset, bool ignore_case, int16* words);
+
 /**
  * encode()
  * 		Encode a sequence.
@@ -44,6 +82,26 @@ PB_CompressedSequence* encode(uint8* input,
 							  PB_CodeSet* codeset,
 							  PB_SequenceInfo* info);
 
+/**
+ * encode_fixed()
+ * 		Encode a sequence with a fixed code set of equal length codes in
+ * 		a single pass, validating every symbol against the code set.
+ * 		Returns NULL if the code set can not express the sequence.
+ *
+ * 	uint8* input : input sequence, not null-terminated
+ * 	uint32 length : length of the input sequence
+ * 	PB_CodeSet* codeset : fixed codeset with codes of equal length
+ * 	bool ignore_case : whether lower case symbols are encoded as upper case
+ * 	bool with_composition : whether the composition is stored
+ * 	uint8 index_shift : density of the index, see PB_INDEX_PART_SIZE_OF()
+ */
+PB_CompressedSequence* encode_fixed(uint8* input,
+									uint32 length,
+									PB_CodeSet* codeset,
+									bool ignore_case,
+									bool with_composition,
+									uint8 index_shift);
+
 /**
  * decode()
  * 		Decode a compressed sequence.
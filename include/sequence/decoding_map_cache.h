@@ -0,0 +1,208 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   include/sequence/decoding_map_cache.h
+*
+*-------------------------------------------------------------------------
+*/
+
+#ifndef SEQUENCE_DECODING_MAP_CACHE_H_
+#define SEQUENCE_DECODING_MAP_CACHE_H_
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "sequence/sequence.h"
+
+/**
+ * Type for decoding map elements, so the symbol and the length
+ * of the code can be stored close to each other in one data
+ * structure. An actual decoding map would be an array of
+ * PB_DecodingMap of size PB_DECODE_MAP_SIZE (256 if PB_PrefixCode is
+ * uint8)
+ */
+typedef struct {
+	uint8 symbol;
+	uint8 code_length;
+} PB_DecodingMap;
+
+#define PB_DECODE_MAP_SIZE (1 << PB_PREFIX_CODE_BIT_SIZE)
+
+/**
+ * Selects the symbols of a code set, that are put into a map.
+ */
+#define PB_NO_SWAP_MAP		0
+#define PB_SWAP_MAP			1
+
+/**
+ * Number of bits looked up at once by a multi symbol decoding map.
+ */
+#define PB_MULTI_DECODE_BIT_SIZE		12
+#define PB_MULTI_DECODE_MAP_SIZE		(1 << PB_MULTI_DECODE_BIT_SIZE)
+
+/**
+ * Maximum number of symbols returned by one multi symbol lookup.
+ */
+#define PB_MULTI_DECODE_MAX_SYMBOLS		6
+
+/**
+ * Element of a multi symbol decoding map. For every possible value of
+ * the next PB_MULTI_DECODE_BIT_SIZE bits it holds the symbols of all
+ * codewords completely contained in these bits, and the number of bits
+ * they take.
+ *
+ * The run-length symbol ends an element, so does the limit of
+ * PB_MULTI_DECODE_MAX_SYMBOLS. Elements without symbols must be
+ * decoded with a PB_DecodingMap. The number of contained master
+ * symbols of a swapped code is stored, so that swap run-lengths can
+ * be checked before an element is used.
+ */
+typedef struct {
+	uint8 symbols[PB_MULTI_DECODE_MAX_SYMBOLS];
+	uint8 counts;
+	uint8 n_bits;
+} PB_MultiDecodingMap;
+
+#define PB_MULTI_DECODE_N_SYMBOLS(element)	((element).counts & 0x0F)
+#define PB_MULTI_DECODE_N_MASTER(element)	((element).counts >> 4)
+
+/**
+ * True if building a multi symbol decoding map pays off for decoding
+ * the given number of symbols. Maps of fixed code sets are built only
+ * once per backend.
+ */
+#define PB_USE_MULTI_DECODING_MAP(codeset, length) \
+	((codeset)->is_fixed || (length) >= PB_MULTI_DECODE_MAP_SIZE)
+
+/**
+ * This macro peeks at the next PB_MULTI_DECODE_BIT_SIZE bits of a
+ * compressed stream without consuming them. It never reads at or
+ * beyond input_end; missing bits are read as zeros.
+ *
+ * Parameters:
+ * 	PB_CompressionBuffer* input_pointer : compressed sequence
+ * 	PB_CompressionBuffer* input_end : end of compressed sequence
+ * 	PB_CompressionBuffer buffer : compression buffer
+ * 	int bits_in_buffer : bits in compression buffer
+ * 	int val : where to write to
+ */
+#define PEEK_MULTI(input_pointer, input_end, buffer, bits_in_buffer, val) { \
+	if (bits_in_buffer >= PB_MULTI_DECODE_BIT_SIZE || input_pointer >= input_end) \
+		val = buffer >> (PB_COMPRESSION_BUFFER_BIT_SIZE - PB_MULTI_DECODE_BIT_SIZE); \
+	else \
+		val = (buffer | (*input_pointer >> bits_in_buffer)) >> (PB_COMPRESSION_BUFFER_BIT_SIZE - PB_MULTI_DECODE_BIT_SIZE); \
+}
+
+/**
+ * This macro consumes bits after a PEEK_MULTI.
+ *
+ * Parameters:
+ * 	PB_CompressionBuffer* input_pointer : compressed sequence
+ * 	PB_CompressionBuffer buffer : compression buffer
+ * 	int bits_in_buffer : bits in compression buffer
+ * 	int n_bits : number of bits to consume, at most PB_MULTI_DECODE_BIT_SIZE
+ */
+#define SKIP_BITS(input_pointer, buffer, bits_in_buffer, n_bits) { \
+	if ((n_bits) <= bits_in_buffer) { \
+		bits_in_buffer -= (n_bits); \
+		buffer = buffer << (n_bits); \
+	} else { \
+		PB_CompressionBuffer next = *input_pointer; \
+		bits_in_buffer -= (n_bits); \
+		buffer = next << (-bits_in_buffer); \
+		bits_in_buffer += PB_COMPRESSION_BUFFER_BIT_SIZE; \
+		input_pointer++; \
+	} \
+}
+
+/**
+ * Number of symbols held by an element of a byte decoding map.
+ */
+#define PB_BYTE_DECODE_MAX_SYMBOLS		8
+
+/**
+ * Element of a byte decoding map. For codes of equal length, that
+ * divides 8, it holds the symbols of all codewords contained in one
+ * byte of a compressed stream. Unused symbols are undefined.
+ */
+typedef struct {
+	uint8 symbols[PB_BYTE_DECODE_MAX_SYMBOLS];
+} PB_ByteDecodingMap;
+
+/**
+ * True if a code set can be unpacked a byte at a time.
+ */
+#define PB_USE_BYTE_DECODING_MAP(codeset) \
+	((codeset)->has_equal_length && \
+	 (codeset)->n_swapped_symbols == 0 && \
+	 !(codeset)->uses_rle && \
+	 (codeset)->words[0].code_length > 0 && \
+	 8 % (codeset)->words[0].code_length == 0)
+
+/**
+ * Maximum number of decoding maps of sequence specific code sets
+ * kept per backend. Maps of fixed code sets are never evicted, the
+ * least recently looked up maps of sequence specific code sets are.
+ */
+#define PB_DECODING_MAP_CACHE_SIZE		128
+
+/**
+ * get_decoding_maps()
+ * 		Returns the decoding maps of a code set from the per backend
+ * 		cache. Missing maps are created and stored in the cache.
+ *
+ * 	The maps are owned by the cache and must not be pfreed. Maps of
+ * 	fixed code sets stay valid for the lifetime of the backend. Maps of
+ * 	sequence specific code sets stay valid until PB_DECODING_MAP_CACHE_SIZE
+ * 	other sequence specific code sets have been looked up since the last
+ * 	lookup of this code set. Callers holding maps may therefore look up
+ * 	a few other code sets, e.g. to decode a second sequence, but must
+ * 	not keep maps across function calls or loops over arbitrary many
+ * 	sequences; they have to look them up again instead.
+ *
+ * 	const PB_CodeSet* codeset : code set to get the maps for
+ * 	const PB_DecodingMap** map : output for the map without swapped symbols
+ * 	const PB_DecodingMap** swap_map : output for the map of swapped symbols
+ */
+void get_decoding_maps(const PB_CodeSet* codeset,
+					   const PB_DecodingMap** map,
+					   const PB_DecodingMap** swap_map);
+
+/**
+ * get_multi_decoding_map()
+ * 		Returns the multi symbol decoding map of a code set from the per
+ * 		backend cache. It is created on first use.
+ *
+ * 	The map is owned by the cache, the same lifetime rules as for
+ * 	get_decoding_maps() apply.
+ *
+ * 	const PB_CodeSet* codeset : code set to get the map for
+ */
+const PB_MultiDecodingMap* get_multi_decoding_map(const PB_CodeSet* codeset);
+
+/**
+ * get_byte_decoding_map()
+ * 		Returns the byte decoding map of a code set from the per backend
+ * 		cache. It is created on first use. The code set must satisfy
+ * 		PB_USE_BYTE_DECODING_MAP.
+ *
+ * 	The map is owned by the cache, the same lifetime rules as for
+ * 	get_decoding_maps() apply.
+ *
+ * 	const PB_CodeSet* codeset : code set to get the map for
+ */
+const PB_ByteDecodingMap* get_byte_decoding_map(const PB_CodeSet* codeset);
+
+/**
+ * decoding_map_cache_stats()
+ * 		Returns hits, misses, evictions and number of cached maps.
+ */
+Datum decoding_map_cache_stats(PG_FUNCTION_ARGS);
+
+#endif /* SEQUENCE_DECODING_MAP_CACHE_H_ */
@@ -21,16 +21,10 @@
 
 #include "sequence/sequence.h"
 #include "sequence/compression.h"
+#include "sequence/decoding_map_cache.h"
 
 #include "utils/debug.h"
 
-typedef struct {
-	uint8 symbol;
-	uint8 code_length;
-} PB_DecodingMap;
-
-#define PB_DECODE_MAP_SIZE (1 << PB_PREFIX_CODE_BIT_SIZE)
-
 #define DECODE(input_pointer, buffer, bits_in_buffer, val, length, map) { \
 	val = buffer >> (PB_COMPRESSION_BUFFER_BIT_SIZE - PB_PREFIX_CODE_BIT_SIZE); \
 	length = map[val].code_length; \
@@ -74,51 +68,6 @@ typedef struct {
 	} \
 }
 
-#define PB_NO_SWAP_MAP		0
-#define PB_SWAP_MAP			1
-
-/**
- * get_decoding_map()
- * 		Creates a decoding map for a prefix code set.
- */
-static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
-{
-	PB_DecodingMap* map;
-	int i,j;
-	int from = 0;
-	int to = 0;
-
-	if (mode == PB_NO_SWAP_MAP)
-	{
-		from = 0;
-		to = codeset->n_symbols - codeset->n_swapped_symbols;
-	}
-	else if (mode == PB_SWAP_MAP)
-	{
-		from = codeset->n_symbols - codeset->n_swapped_symbols;
-		to = codeset->n_symbols;
-	}
-
-	map = (PB_DecodingMap*) palloc(PB_DECODE_MAP_SIZE * sizeof(PB_DecodingMap));
-	memset(map, 0xFF, PB_DECODE_MAP_SIZE * sizeof(PB_DecodingMap));
-
-	for (i = from; i < to; i++)
-	{
-		const int lower_bound = codeset->words[i].code;
-		const int upper_bound = lower_bound + (1 << (PB_PREFIX_CODE_BIT_SIZE - codeset->words[i].code_length));
-
-		for (j = lower_bound; j < upper_bound; j++)
-		{
-			map[j].symbol = codeset->words[i].symbol;
-			map[j].code_length = codeset->words[i].code_length;
-		}
-
-		PB_DEBUG3(errmsg("get_decoding_map(): i:%d lower_bound:%u upper_bound:%u symbol:%c code:%u length:%u/%ld",i,lower_bound,upper_bound,codeset->words[i].symbol,codeset->words[i].code,codeset->words[i].code_length, PB_PREFIX_CODE_BIT_SIZE));
-	}
-
-	return map;
-}
-
 /*
  * Iterate over a compressed sequence.
  *
@@ -137,8 +86,11 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 #define PB_BEGIN_DECODE(__pb_decode_input, __pb_decode_start_position, __pb_decode_output_length, __pb_decode_fixed_codesets, __pb_decode_output) {\
 	PB_CompressedSequence* __pb_decode_input_header;\
 	PB_CodeSet* __pb_decode_codeset;\
-	PB_DecodingMap* __pb_decode_map;\
-	PB_DecodingMap* __pb_decode_swap_map;\
+	const PB_DecodingMap* __pb_decode_map;\
+	const PB_DecodingMap* __pb_decode_swap_map;\
+	const PB_MultiDecodingMap* __pb_decode_multi_map = NULL;\
+	const uint8* __pb_decode_pending = NULL;\
+	int __pb_decode_n_pending = 0;\
 	PB_IndexEntry* __pb_decode_start_entry = NULL;\
 	PB_CompressionBuffer __pb_decode_buffer;\
 	int __pb_decode_bits_in_buffer;\
@@ -147,6 +99,7 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 	int __pb_decode_stream_offset;\
 	Varlena* __pb_decode_input_slice;\
 	PB_CompressionBuffer* __pb_decode_input_pointer;\
+	PB_CompressionBuffer* __pb_decode_input_end;\
 	uint8 __pb_decode_current = 0;\
 	int __pb_decode_n_rle_out = 0;\
 	uint8 __pb_decode_master_symbol = 0;\
@@ -187,8 +140,9 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 		PB_DEBUG1(errmsg("PB_BEGIN_DECODE():Sequence specific code copied"));\
 	}\
 \
-	__pb_decode_map = get_decoding_map(__pb_decode_codeset, PB_NO_SWAP_MAP);\
-	__pb_decode_swap_map = get_decoding_map(__pb_decode_codeset, PB_SWAP_MAP);\
+	get_decoding_maps(__pb_decode_codeset, &__pb_decode_map, &__pb_decode_swap_map);\
+	if (PB_USE_MULTI_DECODING_MAP(__pb_decode_codeset, __pb_decode_output_length))\
+		__pb_decode_multi_map = get_multi_decoding_map(__pb_decode_codeset);\
 \
 	if (__pb_decode_codeset->n_swapped_symbols > 0) {\
 		__pb_decode_master_symbol = __pb_decode_codeset->words[__pb_decode_codeset->n_symbols - __pb_decode_codeset->n_swapped_symbols].symbol;\
@@ -202,12 +156,11 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 	if (__pb_decode_input_header->has_index) {\
 		int __pb_decode_start_entry_no;\
 \
-		__pb_decode_start_entry_no = (__pb_decode_start_position + 1) / PB_INDEX_PART_SIZE - 1;\
+		__pb_decode_start_entry_no = (__pb_decode_start_position + 1) / PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(__pb_decode_input_header) - 1;\
 		if (__pb_decode_start_entry_no >= 0) {\
 			Varlena* __pb_decode_data_slice = (Varlena*)\
 				PG_DETOAST_DATUM_SLICE(__pb_decode_input,\
-									   sizeof(PB_CompressedSequence) - VARHDRSZ +\
-									   sizeof(PB_Codeword) * __pb_decode_input_header->n_symbols +\
+									   PB_COMPRESSED_SEQUENCE_INDEX_OFFSET(__pb_decode_input_header) - VARHDRSZ +\
 									   sizeof(PB_IndexEntry) * __pb_decode_start_entry_no,\
 									   sizeof(PB_IndexEntry));\
 \
@@ -223,7 +176,38 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 \
 	PB_DEBUG1(errmsg("PB_BEGIN_DECODE():calculated stream offset:%u", __pb_decode_stream_offset));\
 \
-	if (__pb_decode_start_entry == NULL) {\
+	if (__pb_decode_start_entry == NULL &&\
+		__pb_decode_output_length > 0 &&\
+		__pb_decode_codeset->has_equal_length &&\
+		__pb_decode_codeset->n_swapped_symbols == 0 &&\
+		!__pb_decode_codeset->uses_rle) {\
+		int __pb_decode_code_length = __pb_decode_codeset->words[0].code_length;\
+		int64 __pb_decode_bits_to_skip = (int64) (__pb_decode_start_position) * __pb_decode_code_length;\
+		int64 __pb_decode_slice_start = __pb_decode_bits_to_skip / PB_COMPRESSION_BUFFER_BIT_SIZE;\
+		int64 __pb_decode_slice_size = (__pb_decode_bits_to_skip + (int64) (__pb_decode_output_length) * __pb_decode_code_length)\
+									   / PB_COMPRESSION_BUFFER_BIT_SIZE + 1 - __pb_decode_slice_start;\
+\
+		__pb_decode_slice_start = __pb_decode_slice_start * PB_COMPRESSION_BUFFER_BYTE_SIZE + __pb_decode_stream_offset;\
+		__pb_decode_slice_size *= PB_COMPRESSION_BUFFER_BYTE_SIZE;\
+\
+		if (__pb_decode_slice_size + __pb_decode_slice_start > __pb_decode_raw_size)\
+			__pb_decode_slice_size = __pb_decode_raw_size - __pb_decode_slice_start;\
+\
+		__pb_decode_input_slice = (Varlena*)\
+				PG_DETOAST_DATUM_SLICE(__pb_decode_input,\
+									   __pb_decode_slice_start,\
+									   __pb_decode_slice_size);\
+\
+		PB_DEBUG1(errmsg("PB_BEGIN_DECODE(): all codes have equal length\n\tskipping %ld bits\n\tslice starts at byte %ld\n\tslice size is %ld bytes", __pb_decode_bits_to_skip, __pb_decode_slice_start, __pb_decode_slice_size));\
+\
+		__pb_decode_i = -1;\
+		__pb_decode_input_pointer = (PB_CompressionBuffer*) VARDATA_ANY(__pb_decode_input_slice);\
+		__pb_decode_bits_in_buffer = __pb_decode_bits_to_skip % PB_COMPRESSION_BUFFER_BIT_SIZE;\
+		__pb_decode_buffer = *__pb_decode_input_pointer << __pb_decode_bits_in_buffer;\
+		__pb_decode_bits_in_buffer = PB_COMPRESSION_BUFFER_BIT_SIZE - __pb_decode_bits_in_buffer;\
+		__pb_decode_input_pointer++;\
+		__pb_decode_swap_counter = __pb_decode_input_header->sequence_length + 1;\
+	} else if (__pb_decode_start_entry == NULL) {\
 		int __pb_decode_slice_size = (__pb_decode_start_position + __pb_decode_output_length) *\
 									  __pb_decode_max_codeword_length;\
 \
@@ -262,7 +246,8 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 	} else {\
 		int __pb_decode_slice_start = __pb_decode_stream_offset +\
 									  __pb_decode_start_entry->block * PB_COMPRESSION_BUFFER_BYTE_SIZE;\
-		int __pb_decode_slice_size = (__pb_decode_output_length + (__pb_decode_start_position % PB_INDEX_PART_SIZE)) *\
+		int __pb_decode_slice_size = __pb_decode_start_entry->bit +\
+									 (__pb_decode_output_length + (__pb_decode_start_position % PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(__pb_decode_input_header))) *\
 									  __pb_decode_max_codeword_length;\
 \
 		if (__pb_decode_codeset->uses_rle)\
@@ -286,12 +271,15 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 		__pb_decode_bits_in_buffer = PB_COMPRESSION_BUFFER_BIT_SIZE - __pb_decode_start_entry->bit;\
 		__pb_decode_buffer = *(__pb_decode_input_pointer) << __pb_decode_start_entry->bit;\
 		__pb_decode_input_pointer++;\
-		__pb_decode_i = ((__pb_decode_start_position + 1) % PB_INDEX_PART_SIZE) - 1 + __pb_decode_start_entry->rle_shift;\
+		__pb_decode_i = ((__pb_decode_start_position + 1) % PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(__pb_decode_input_header)) - 1 + __pb_decode_start_entry->rle_shift;\
 		if (__pb_decode_codeset->n_swapped_symbols > 0)\
 			__pb_decode_swap_counter = __pb_decode_start_entry->swap_shift;\
 		else\
 			__pb_decode_swap_counter = __pb_decode_input_header->sequence_length + 1;\
 	}\
+\
+	__pb_decode_input_end = ((PB_CompressionBuffer*) VARDATA_ANY(__pb_decode_input_slice)) +\
+							VARSIZE_ANY_EXHDR(__pb_decode_input_slice) / PB_COMPRESSION_BUFFER_BYTE_SIZE;\
 \
 	if (__pb_decode_input_header->is_fixed == false)\
 		pfree(__pb_decode_codeset);\
@@ -373,33 +361,38 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 		__pb_decode_i--;\
 		__pb_decode_n_rle_out--;\
 \
-		if (__pb_decode_n_rle_out < 0) {\
+		if (__pb_decode_n_rle_out < 0 && __pb_decode_n_pending > 0) {\
+			__pb_decode_current = *__pb_decode_pending;\
+			__pb_decode_pending++;\
+			__pb_decode_n_pending--;\
+		} else if (__pb_decode_n_rle_out < 0) {\
 			PB_PrefixCode __pb_decode_val;\
 			int __pb_decode_length;\
+			int __pb_decode_n_multi = 0;\
 \
-			DECODE(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_val, __pb_decode_length, __pb_decode_map);\
-			__pb_decode_current = __pb_decode_map[__pb_decode_val].symbol;\
+			if (__pb_decode_multi_map != NULL) {\
+				const PB_MultiDecodingMap* __pb_decode_element;\
+				int __pb_decode_peek;\
 \
-			if (__pb_decode_current == __pb_decode_master_symbol) {\
-				__pb_decode_swap_counter--;\
-				if (__pb_decode_swap_counter < 0) {\
-					PB_PrefixCode __pb_decode_val;\
-					int __pb_decode_length;\
+				PEEK_MULTI(__pb_decode_input_pointer, __pb_decode_input_end, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_peek);\
+				__pb_decode_element = &__pb_decode_multi_map[__pb_decode_peek];\
 \
-					DECODE(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_val, __pb_decode_length, __pb_decode_swap_map);\
-					__pb_decode_current = __pb_decode_swap_map[__pb_decode_val].symbol;\
+				if (PB_MULTI_DECODE_N_SYMBOLS(*__pb_decode_element) <= __pb_decode_i + 2 &&\
+					PB_MULTI_DECODE_N_MASTER(*__pb_decode_element) <= __pb_decode_swap_counter) {\
+					__pb_decode_n_multi = PB_MULTI_DECODE_N_SYMBOLS(*__pb_decode_element);\
+				}\
 \
-					READ_N_BITS(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_swap_counter, PB_SWAP_RUN_LENGTH_BIT_SIZE);\
+				if (__pb_decode_n_multi > 0) {\
+					SKIP_BITS(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_element->n_bits);\
+					__pb_decode_swap_counter -= PB_MULTI_DECODE_N_MASTER(*__pb_decode_element);\
+					__pb_decode_current = __pb_decode_element->symbols[0];\
+					__pb_decode_pending = __pb_decode_element->symbols + 1;\
+					__pb_decode_n_pending = __pb_decode_n_multi - 1;\
 				}\
 			}\
 \
-			if (__pb_decode_current == PB_RUN_LENGTH_SYMBOL) {\
-				PB_CompressionBuffer __pb_decode_repeated_chars = 0;\
-\
-				READ_N_BITS(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_repeated_chars, PB_RUN_LENGTH_BIT_SIZE);\
-\
+			if (__pb_decode_n_multi == 0) {\
 				DECODE(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_val, __pb_decode_length, __pb_decode_map);\
-				__pb_decode_repeated_chars += PB_MIN_RUN_LENGTH;\
 				__pb_decode_current = __pb_decode_map[__pb_decode_val].symbol;\
 \
 				if (__pb_decode_current == __pb_decode_master_symbol) {\
@@ -415,11 +408,34 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 					}\
 				}\
 \
-				PB_DEBUG3(errmsg("SRLE %c (%d) code:%u len:%u i:%d swap_counter:%lu bitsInBuffer:%d buffer:%08X%08X",\
-								__pb_decode_current, __pb_decode_current, __pb_decode_val, __pb_decode_length, __pb_decode_i,\
-								__pb_decode_repeated_chars, __pb_decode_bits_in_buffer, (uint32) (__pb_decode_buffer >> 32), (uint32) __pb_decode_buffer));\
+				if (__pb_decode_current == PB_RUN_LENGTH_SYMBOL) {\
+					PB_CompressionBuffer __pb_decode_repeated_chars = 0;\
 \
-				__pb_decode_n_rle_out = __pb_decode_repeated_chars - 1;\
+					READ_N_BITS(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_repeated_chars, PB_RUN_LENGTH_BIT_SIZE);\
+\
+					DECODE(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_val, __pb_decode_length, __pb_decode_map);\
+					__pb_decode_repeated_chars += PB_MIN_RUN_LENGTH;\
+					__pb_decode_current = __pb_decode_map[__pb_decode_val].symbol;\
+\
+					if (__pb_decode_current == __pb_decode_master_symbol) {\
+						__pb_decode_swap_counter--;\
+						if (__pb_decode_swap_counter < 0) {\
+							PB_PrefixCode __pb_decode_val;\
+							int __pb_decode_length;\
+\
+							DECODE(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_val, __pb_decode_length, __pb_decode_swap_map);\
+							__pb_decode_current = __pb_decode_swap_map[__pb_decode_val].symbol;\
+\
+							READ_N_BITS(__pb_decode_input_pointer, __pb_decode_buffer, __pb_decode_bits_in_buffer, __pb_decode_swap_counter, PB_SWAP_RUN_LENGTH_BIT_SIZE);\
+						}\
+					}\
+\
+					PB_DEBUG3(errmsg("SRLE %c (%d) code:%u len:%u i:%d swap_counter:%lu bitsInBuffer:%d buffer:%08X%08X",\
+									__pb_decode_current, __pb_decode_current, __pb_decode_val, __pb_decode_length, __pb_decode_i,\
+									__pb_decode_repeated_chars, __pb_decode_bits_in_buffer, (uint32) (__pb_decode_buffer >> 32), (uint32) __pb_decode_buffer));\
+\
+					__pb_decode_n_rle_out = __pb_decode_repeated_chars - 1;\
+				}\
 			}\
 		}\
 \
@@ -428,9 +444,6 @@ static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
 
 #define PB_END_DECODE\
 	}\
-\
-	pfree((PB_DecodingMap*) __pb_decode_map);\
-	pfree((PB_DecodingMap*) __pb_decode_swap_map);\
 \
 	PB_TRACE(errmsg("<-PB_BEGIN_DECODE()"))\
 }
@@ -0,0 +1,144 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   include/sequence/fm_index.h
+*
+*-------------------------------------------------------------------------
+*/
+
+#ifndef SEQUENCE_FM_INDEX_H_
+#define SEQUENCE_FM_INDEX_H_
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "sequence/sequence.h"
+
+/**
+ * Number of BWT rows per block. Each block starts with the
+ * occurrences of all symbols before the block.
+ */
+#define PB_FM_INDEX_BLOCK_SIZE		256
+
+/**
+ * Every PB_FM_INDEX_SAMPLE_RATE-th text position is stored in the
+ * suffix array sample.
+ */
+#define PB_FM_INDEX_SAMPLE_RATE		32
+
+/**
+ * Maximum number of symbols. Sequences are restricted to ASCII.
+ */
+#define PB_FM_INDEX_MAX_SYMBOLS		128
+
+/**
+ * BWT symbol of the row of the sentinel.
+ */
+#define PB_FM_INDEX_SENTINEL		0xFF
+
+/**
+ * Stores an FM-index of a sequence.
+ *
+ *	uint32 _vl_len			:	pgsql specific 4-byte length field
+ *	uint32 sequence_length	:	number of characters n of the indexed sequence
+ *	uint32 primary_index	:	BWT row of the sentinel
+ *	uint32 n_blocks			:	number of blocks
+ *	uint32 n_samples		:	number of suffix array samples
+ *	uint8 n_symbols			:	number of distinct symbols
+ *	uint8 ranks[]			:	rank + 1 of each symbol, 0 if the symbol does not occur
+ *	uint32 c[]				:	BWT row of the first suffix starting with each rank
+ *
+ * The n + 1 BWT rows include the sentinel, which is smaller than all
+ * symbols. The layout of the variable part in 'data' member is:
+ * 	Variable member					|	size
+ * ----------------------------------------------------------------------------
+ *	blocks[]						|	n_blocks * PB_FM_INDEX_BLOCK_BYTES(n_symbols)
+ *	uint32 samples[]				|	n_samples * sizeof(uint32)
+ *
+ * A block consists of
+ *	uint32 occurrences[n_symbols]	:	occurrences of each rank before the block
+ *	uint32 n_sampled				:	sampled rows before the block
+ *	uint32 sampled[]				:	bitmap of sampled rows of the block
+ *	uint8 bwt[]						:	ranks of the BWT symbols of the block
+ *
+ * All members are 4-byte aligned, so that blocks can be read from
+ * detoasted slices.
+ */
+typedef struct {
+	uint32 _vl_len;
+	uint32 sequence_length;
+	uint32 primary_index;
+	uint32 n_blocks;
+	uint32 n_samples;
+	uint8 n_symbols;
+	uint8 _align[3];
+	uint8 ranks[PB_SOURCE_ALPHABET_SIZE];
+	uint32 c[PB_FM_INDEX_MAX_SYMBOLS];
+	uint8 data[];
+} PB_FMIndex;
+
+/**
+ * Size of the bitmap of sampled rows of a block in uint32.
+ */
+#define PB_FM_INDEX_SAMPLED_WORDS	(PB_FM_INDEX_BLOCK_SIZE / 32)
+
+/**
+ * Offsets of the members of a block and its size in bytes.
+ */
+#define PB_FM_INDEX_N_SAMPLED_OFFSET(n_symbols)	((n_symbols) * sizeof(uint32))
+#define PB_FM_INDEX_SAMPLED_OFFSET(n_symbols)	(((n_symbols) + 1) * sizeof(uint32))
+#define PB_FM_INDEX_BWT_OFFSET(n_symbols) \
+	(((n_symbols) + 1 + PB_FM_INDEX_SAMPLED_WORDS) * sizeof(uint32))
+#define PB_FM_INDEX_BLOCK_BYTES(n_symbols) \
+	(PB_FM_INDEX_BWT_OFFSET(n_symbols) + PB_FM_INDEX_BLOCK_SIZE)
+
+/**
+ * Offsets of the blocks and samples from the start of an FM-index.
+ */
+#define PB_FM_INDEX_BLOCK_OFFSET(index, block) \
+	(offsetof(PB_FMIndex, data) + \
+	 (uint64) (block) * PB_FM_INDEX_BLOCK_BYTES(((PB_FMIndex*) (index))->n_symbols))
+#define PB_FM_INDEX_SAMPLE_OFFSET(index, sample) \
+	(PB_FM_INDEX_BLOCK_OFFSET(index, ((PB_FMIndex*) (index))->n_blocks) + \
+	 (uint64) (sample) * sizeof(uint32))
+
+/**
+ * fm_index_create()
+ * 		Builds the FM-index of a sequence. The suffix array is sorted by
+ * 		prefix doubling, which needs 16 bytes of temporary memory per
+ * 		symbol.
+ *
+ * 	uint8* input : sequence, must only contain ASCII symbols
+ * 	uint32 length : length of the sequence
+ */
+PB_FMIndex* fm_index_create(uint8* input, uint32 length);
+
+/**
+ * fm_index_to_cstring()
+ * 		Restores the indexed sequence by inverting the BWT.
+ *
+ * 	PB_FMIndex* index : detoasted FM-index
+ */
+char* fm_index_to_cstring(PB_FMIndex* index);
+
+/**
+ * fm_index_find()
+ * 		Counts the occurrences of a pattern by backward search. Reads
+ * 		only the blocks needed from a toasted index, so the cost is
+ * 		independent of the length of the sequence. Positions are located
+ * 		with the suffix array sample, if requested.
+ *
+ * 	Varlena* raw_index : possibly toasted FM-index
+ * 	text* pattern : pattern to search for
+ * 	uint32** positions : output for ascending 1-based positions of all
+ * 						 occurrences, or NULL to only count
+ */
+uint32 fm_index_find(Varlena* raw_index, text* pattern, uint32** positions);
+
+#endif /* SEQUENCE_FM_INDEX_H_ */
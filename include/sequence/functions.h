@@ -14,6 +14,9 @@
 #ifndef SEQUENCE_FUNCTIONS_H_
 #define SEQUENCE_FUNCTIONS_H_
 
+#include "fmgr.h"
+#include "utils/sortsupport.h"
+
 #include "sequence/sequence.h"
 
 /**
@@ -41,6 +44,26 @@ bool sequence_equal(Varlena* raw_seq1, Varlena* raw_seq2, PB_CodeSet** fixed_cod
  */
 int sequence_compare(Varlena* seq_a, Varlena* seq_b, PB_CodeSet** fixed_codesets);
 
+/**
+ * sequence_sortsupport()
+ * 		Sets up sort support for a sequence type. Abbreviated keys
+ * 		hold the first symbols of a sequence, as many as fit into a
+ * 		Datum using the given key alphabet.
+ *
+ * 	SortSupport ssup : sort support to set up
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	const char* key_alphabet : sorted symbols, which are abbreviated
+ * 							   exactly, NULL for all bytes
+ */
+void sequence_sortsupport(SortSupport ssup, PB_CodeSet** fixed_codesets, const char* key_alphabet);
+
+/**
+ * Version of the hash values returned by sequence_crc32(). Hash indexes
+ * store these values, so it must be increased whenever they change.
+ * Hash indexes built with another version have to be reindexed.
+ */
+#define PB_HASH_VERSION		1
+
 /*
  * sequence_crc32()
  *		Compute CRC32 of a compressed sequence.
@@ -53,6 +76,12 @@ int sequence_compare(Varlena* seq_a, Varlena* seq_b, PB_CodeSet** fixed_codesets
  */
 uint32 sequence_crc32(PB_CompressedSequence* seq, PB_CodeSet** fixed_codesets);
 
+/**
+ * sequence_hash_version()
+ * 		Returns the version of the hash values of all sequence types.
+ */
+Datum sequence_hash_version(PG_FUNCTION_ARGS);
+
 /*
  * sequence_strpos()
  * 		Find position of given string.
@@ -63,4 +92,113 @@ uint32 sequence_crc32(PB_CompressedSequence* seq, PB_CodeSet** fixed_codesets);
  */
 uint32 sequence_strpos(PB_CompressedSequence* seq, text* search, PB_CodeSet** fixed_codesets);
 
+/**
+ * sequence_find_all()
+ * 		Finds all, possibly overlapping, occurrences of a pattern, that
+ * 		lie completely within a window of a sequence. Returns the number
+ * 		of occurrences.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence to search in
+ * 	text* search : detoasted text to search for
+ * 	uint32 from : first position of window, first is 1
+ * 	uint32 to : last position of window
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	uint32** positions : output for palloc'd positions, NULL to count only
+ */
+uint32 sequence_find_all(Varlena* raw_seq,
+						 text* search,
+						 uint32 from,
+						 uint32 to,
+						 PB_CodeSet** fixed_codesets,
+						 uint32** positions);
+
+/**
+ * sequence_count_symbols()
+ * 		Counts the symbols of a range of a sequence. Complete index parts
+ * 		are counted from the composition summary, the rest is counted on
+ * 		the packed words of codes of equal length 1, 2, 4 or 8 without
+ * 		swapping and RLE, or decoded without storing symbols.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	uint32 start : first symbol, first is 0
+ * 	uint32 length : number of symbols
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	uint64* counts : output for counts of each symbol, PB_SOURCE_ALPHABET_SIZE elements
+ */
+void sequence_count_symbols(Varlena* raw_seq,
+							uint32 start,
+							uint32 length,
+							PB_CodeSet** fixed_codesets,
+							uint64* counts);
+
+/**
+ * sequence_range_args()
+ * 		Reads optional start and length arguments, that follow the
+ * 		semantics of substr(), as a range with first position 0. Without
+ * 		these arguments, the range covers the whole sequence.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the calling function
+ * 	int start_arg : number of the start argument
+ * 	uint32* start : output for the first symbol
+ * 	uint32* length : output for the number of symbols
+ */
+void sequence_range_args(FunctionCallInfo fcinfo, int start_arg, uint32* start, uint32* length);
+
+/**
+ * sequence_gc_content()
+ * 		Returns the fraction of G and C in a range of a sequence.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	uint32 start : first symbol, first is 0
+ * 	uint32 length : number of symbols
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+float4 sequence_gc_content(Varlena* raw_seq, uint32 start, uint32 length, PB_CodeSet** fixed_codesets);
+
+/**
+ * sequence_entropy()
+ * 		Returns the Shannon entropy of the symbols of a sequence in bits.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+float4 sequence_entropy(Varlena* raw_seq, PB_CodeSet** fixed_codesets);
+
+/**
+ * sequence_symbol_counts()
+ * 		Set returning function, that returns each symbol of a sequence
+ * 		with its number of occurrences in ascending symbol order. Takes
+ * 		optional start and length arguments like substr().
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the calling function
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+Datum sequence_symbol_counts(FunctionCallInfo fcinfo, PB_CodeSet** fixed_codesets);
+
+/**
+ * sequence_concat()
+ * 		Appends a sequence to another one without decoding the first one,
+ * 		if both were compressed with the same fixed code. Returns NULL
+ * 		otherwise.
+ *
+ * 	Varlena* raw_seq1 : possibly toasted first sequence
+ * 	Varlena* raw_seq2 : possibly toasted second sequence
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+PB_CompressedSequence* sequence_concat(Varlena* raw_seq1, Varlena* raw_seq2, PB_CodeSet** fixed_codesets);
+
+/**
+ * sequence_concat_decoded()
+ * 		Decodes two sequences into a single null-terminated buffer.
+ *
+ * 	Varlena* raw_seq1 : possibly toasted first sequence
+ * 	Varlena* raw_seq2 : possibly toasted second sequence
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	uint32* length : output for the length of the concatenation
+ */
+uint8* sequence_concat_decoded(Varlena* raw_seq1,
+							   Varlena* raw_seq2,
+							   PB_CodeSet** fixed_codesets,
+							   uint32* length);
+
 #endif /* SEQUENCE_FUNCTIONS_H_ */
@@ -0,0 +1,68 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   include/sequence/kmer_index.h
+*
+*-------------------------------------------------------------------------
+*/
+
+#ifndef SEQUENCE_KMER_INDEX_H_
+#define SEQUENCE_KMER_INDEX_H_
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "sequence/sequence.h"
+
+/**
+ * Strategy number of the containment operator @> in k-mer
+ * operator classes.
+ */
+#define PB_KMER_CONTAINS_STRATEGY	1
+
+/**
+ * Maximum k-mer length. k-mers are packed into int4 keys
+ * using 2 bits per nucleotide.
+ */
+#define PB_KMER_MAX_LENGTH			15
+
+/**
+ * kmer_gin_extract_value()
+ * 		GIN extractValue support for nucleotide sequences. Returns the
+ * 		distinct k-mers of a possibly toasted sequence, that consist of
+ * 		A, C, G and T (ignoring case) only. The sequence is decoded in
+ * 		one pass. Sequences of at least 4^k / 8 symbols mark their
+ * 		k-mers in a bitmap of all 4^k k-mers, shorter ones sort them.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the support function
+ * 	int k : k-mer length, at most PB_KMER_MAX_LENGTH
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+Datum kmer_gin_extract_value(FunctionCallInfo fcinfo, int k, PB_CodeSet** fixed_codesets);
+
+/**
+ * kmer_gin_extract_query()
+ * 		GIN extractQuery support for nucleotide sequences. Returns the
+ * 		distinct k-mers of a search pattern. Patterns without k-mers
+ * 		require a full index scan.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the support function
+ * 	int k : k-mer length, at most PB_KMER_MAX_LENGTH
+ */
+Datum kmer_gin_extract_query(FunctionCallInfo fcinfo, int k);
+
+/**
+ * gin_consistent_kmer()
+ * 		GIN consistent support for k-mer operator classes. A sequence
+ * 		can only contain a pattern, if it contains all k-mers of the
+ * 		pattern. Matches always have to be rechecked.
+ */
+Datum gin_consistent_kmer(PG_FUNCTION_ARGS);
+
+#endif /* SEQUENCE_KMER_INDEX_H_ */
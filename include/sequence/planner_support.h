@@ -0,0 +1,72 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   include/sequence/planner_support.h
+*
+*-------------------------------------------------------------------------
+*/
+
+#ifndef SEQUENCE_PLANNER_SUPPORT_H_
+#define SEQUENCE_PLANNER_SUPPORT_H_
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "sequence/sequence.h"
+
+/**
+ * Sequence length assumed for selectivity and cost estimation, if
+ * the planner has no width statistics of a column.
+ */
+#define PB_DEFAULT_ESTIMATED_LENGTH		1000
+
+/**
+ * Average compressed size of nucleotides and amino acids in bits.
+ */
+#define PB_NUCLEOTIDE_BITS_PER_SYMBOL	2.0
+#define PB_AMINO_ACID_BITS_PER_SYMBOL	4.3
+
+/**
+ * Number of symbols searched per cpu_operator_cost.
+ */
+#define PB_SYMBOLS_PER_OPERATOR_COST	16
+
+/**
+ * sequence_planner_support()
+ * 		Planner support for strpos() and contains() of a sequence type.
+ *
+ * 	Estimates the cost of a search from the average width of the
+ * 	sequence column and the length of the pattern. For contains() it
+ * 	also estimates the selectivity and turns calls on an indexed column
+ * 	into a @> index condition, if the operator family of the
+ * 	index provides @> for the sequence type. Requires PostgreSQL 12,
+ * 	returns NULL for older versions.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the support function
+ * 	int alphabet_size : number of distinct symbols of the type
+ * 	double bits_per_symbol : average compressed size of a symbol
+ */
+Datum sequence_planner_support(FunctionCallInfo fcinfo,
+							   int alphabet_size,
+							   double bits_per_symbol);
+
+/**
+ * sequence_contains_sel()
+ * 		Restriction selectivity of a @> operator of a sequence type.
+ * 		Uses the same estimate as sequence_planner_support().
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the estimator
+ * 	int alphabet_size : number of distinct symbols of the type
+ * 	double bits_per_symbol : average compressed size of a symbol
+ */
+Datum sequence_contains_sel(FunctionCallInfo fcinfo,
+							int alphabet_size,
+							double bits_per_symbol);
+
+#endif /* SEQUENCE_PLANNER_SUPPORT_H_ */
@@ -42,8 +42,20 @@
  * 									+ larger sequence in total
  * Larger number -> sparser index -> slower substring access
  * 										+ smaller sequence in total
+ *
+ * This is the default and the largest part size. A sequence may use
+ * a denser index of PB_INDEX_PART_SIZE >> index_shift characters per
+ * part, with index_shift up to PB_MAX_INDEX_SHIFT.
  */
 #define PB_INDEX_PART_SIZE 65536
+#define PB_MAX_INDEX_SHIFT 7
+
+/**
+ * Number of characters between substring-index entries for an
+ * index shift.
+ */
+#define PB_INDEX_PART_SIZE_OF(index_shift) \
+	(PB_INDEX_PART_SIZE >> (index_shift))
 
 /**
  * Type to buffer compressed data
@@ -168,6 +180,8 @@ typedef struct {
  * 		-bitmaps of occuring ASCII symbols
  * 		-list of symbols in order of frequency
  * 		-rle info
+ * 		-whether the composition is stored with the compressed sequence
+ * 		-the density of the substring-index
  */
 typedef struct {
 	uint32 sequence_length;
@@ -177,6 +191,8 @@ typedef struct {
 	uint64 ascii_bitmap_high;
 	uint8 n_symbols;
 	bool ignore_case : 1;
+	bool with_composition : 1;
+	uint8 index_shift;
 	uint8* symbols;
 } PB_SequenceInfo;
 
@@ -247,24 +263,45 @@ typedef struct {
  *	bool has_index			:	true if index is included
  *	bool is_fixed			:	true if fixed code was used
  *	bool uses_rle			:	true if rle was used
- *	uint8 _align2			:	data alignment
+ *	bool has_composition	:	true if the composition is included
+ *	uint8 index_shift		:	index parts have PB_INDEX_PART_SIZE >> index_shift
+ *								characters
+ *	uint8 n_summary_symbols	:	number of codewords counted in the composition
+ *								and the composition summary, 0 if there is none
  *
  * The layout of the variable part in 'data' member of this struct is:
  * 	Variable member					|	size
  * ----------------------------------------------------------------------------
  * 	PB_Codeword symbols[];				|	a = sizeof(PB_Codeword) * (n_symbols - n_swapped_symbols)
  *	PB_Codeword swapped_symbols[];		|	b = sizeof(PB_Codeword) * (n_swapped_symbols)
- *	PB_IndexEntry index[];				|	c = has_index == true ? sizeof(PB_IndexEntry) * (sequence_length / PB_INDEX_PART_SIZE) : 0
- *	PB_CompressionBuffer stream[];		|	d = VARSIZE(_vl_len) - roundupto8(12 + a + b + c)
+ *	uint32 composition[];				|	c = has_composition == true ? sizeof(uint32) * n_summary_symbols : 0
+ *	PB_IndexEntry index[];				|	d = has_index == true ? sizeof(PB_IndexEntry) * (sequence_length / part_size) : 0
+ *	uint32 summary[][];					|	e = has_composition == true ? sizeof(uint32) * n_summary_symbols * (sequence_length / PB_INDEX_PART_SIZE) : 0
+ *	PB_CompressionBuffer stream[];		|	f = VARSIZE(_vl_len) - roundupto8(12 + a + b + c + d + e)
+ *
+ * with part_size = PB_INDEX_PART_SIZE >> index_shift.
  *
  * Pointers to the variable members can be obtained by the following functions:
  * 	Variable member					|	function
  * ----------------------------------------------------------------------------
  * 	PB_Codeword symbols[];				|	PB_COMPRESSED_SEQUENCE_SYMBOL_POINTER(seq)
  *	PB_Codeword swapped_symbols[];		|	PB_COMPRESSED_SEQUENCE_SWAPPED_SYMBOL_POINTER(seq)
+ *	uint32 composition[];				|	PB_COMPRESSED_SEQUENCE_COMPOSITION_OFFSET(seq)
  *	PB_IndexEntry index[];				|	PB_COMPRESSED_SEQUENCE_INDEX_POINTER(seq)
+ *	uint32 summary[][];					|	PB_COMPRESSED_SEQUENCE_SUMMARY_OFFSET(seq)
  *	PB_CompressionBuffer stream[];		|	PB_COMPRESSED_SEQUENCE_STREAM_POINTER(seq)
  *
+ * The composition holds the number of occurrences of each codeword of
+ * the code set in the whole sequence. It directly follows the
+ * codewords, so that it can be read with the header. Both the
+ * composition and the composition summary are optional and only stored
+ * along with each other. The composition summary has a row for every
+ * PB_INDEX_PART_SIZE symbols, whatever the density of the index. Row i
+ * holds the number of occurrences of each codeword of the code set in
+ * the first (i + 1) * PB_INDEX_PART_SIZE symbols, in the order of the
+ * codewords. Since both refer to codewords instead of symbols, they stay
+ * valid if a sequence is complemented by relabeling its code. Both are
+ * not aligned, they must be read with memcpy() or from a detoasted slice.
  */
 typedef struct {
 	uint32 _vl_len;
@@ -275,16 +312,25 @@ typedef struct {
 	bool has_index : 1;
 	bool is_fixed : 1;
 	bool uses_rle : 1;
-	uint8 _align2;
+	bool has_composition : 1;
+	uint8 index_shift : 3;
+	uint8 n_summary_symbols;
 	uint8 data[];
 } PB_CompressedSequence;
 
+/**
+ * Number of characters between index entries.
+ */
+#define PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(seq) \
+	PB_INDEX_PART_SIZE_OF(((PB_CompressedSequence*)seq)->index_shift)
+
 /**
  * Number of elements in index table
  */
 #define PB_COMPRESSED_SEQUENCE_INDEX_N_ELEMENTS(seq) \
 	(((PB_CompressedSequence*)seq)->has_index ? \
-	(((PB_CompressedSequence*)seq)->sequence_length / PB_INDEX_PART_SIZE) : 0)
+	(((PB_CompressedSequence*)seq)->sequence_length / \
+	 PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(seq)) : 0)
 
 /**
  * Returns the identifier of the employed fixed code. If
@@ -315,6 +361,27 @@ typedef struct {
 	(((PB_Codeword*)(((PB_CompressedSequence*)seq)->data)) \
 	+ (((PB_CompressedSequence*)seq)->n_symbols - ((PB_CompressedSequence*)seq)->n_swapped_symbols)))
 
+/**
+ * Returns the offset of the composition.
+ */
+#define PB_COMPRESSED_SEQUENCE_COMPOSITION_OFFSET(seq) \
+	(sizeof(PB_CompressedSequence) + \
+	((PB_CompressedSequence*)seq)->n_symbols * sizeof(PB_Codeword))
+
+/**
+ * Size of the composition in bytes.
+ */
+#define PB_COMPRESSED_SEQUENCE_COMPOSITION_SIZE(seq) \
+	(((PB_CompressedSequence*)seq)->has_composition ? \
+	((PB_CompressedSequence*)seq)->n_summary_symbols * sizeof(uint32) : 0)
+
+/**
+ * Returns the offset of the index.
+ */
+#define PB_COMPRESSED_SEQUENCE_INDEX_OFFSET(seq) \
+	(PB_COMPRESSED_SEQUENCE_COMPOSITION_OFFSET(seq) + \
+	PB_COMPRESSED_SEQUENCE_COMPOSITION_SIZE(seq))
+
 /**
  * Returns a (PB_IndexEntry*) pointer to the first index
  * entry. Returns NULL if there is no index.
@@ -322,17 +389,38 @@ typedef struct {
 #define PB_COMPRESSED_SEQUENCE_INDEX_POINTER(seq) \
 	(((((PB_CompressedSequence*)seq)->has_index) == false) ? \
 	NULL : \
-	((PB_IndexEntry*)(((PB_Codeword*)(((PB_CompressedSequence*)seq)->data)) \
-	+ ((PB_CompressedSequence*)seq)->n_symbols)))
+	((PB_IndexEntry*)(((uint8*) seq) + \
+	PB_COMPRESSED_SEQUENCE_INDEX_OFFSET(seq))))
+
+/**
+ * Size of a composition summary in bytes.
+ */
+#define PB_SUMMARY_SIZE(sequence_length,n_summary_symbols) \
+	(((sequence_length) / PB_INDEX_PART_SIZE) * (n_summary_symbols) * sizeof(uint32))
+
+/**
+ * Number of codewords counted in the composition and the composition
+ * summary of a sequence compressed with a code set. Sequences without
+ * a composition have no summary either.
+ */
+#define PB_SUMMARY_N_SYMBOLS(codeset,with_composition) \
+	((with_composition) ? (codeset)->n_symbols : 0)
+
+/**
+ * Returns the offset of the composition summary.
+ */
+#define PB_COMPRESSED_SEQUENCE_SUMMARY_OFFSET(seq) \
+	(PB_COMPRESSED_SEQUENCE_INDEX_OFFSET(seq) + \
+	PB_COMPRESSED_SEQUENCE_INDEX_N_ELEMENTS(seq) * sizeof(PB_IndexEntry))
 
 /**
  * Returns the offset of the stream.
  */
 #define PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(seq) \
 	(PB_ALIGN_BYTE_SIZE(( \
-	sizeof(PB_CompressedSequence) + \
-	((PB_CompressedSequence*)seq)->n_symbols * sizeof(PB_Codeword) + \
-	PB_COMPRESSED_SEQUENCE_INDEX_N_ELEMENTS(seq) * sizeof(PB_IndexEntry))))
+	PB_COMPRESSED_SEQUENCE_SUMMARY_OFFSET(seq) + \
+	PB_SUMMARY_SIZE(((PB_CompressedSequence*)seq)->sequence_length, \
+					((PB_CompressedSequence*)seq)->n_summary_symbols))))
 
 /**
  * Returns a (PB_CompressionBuffer*) to the beginning of
@@ -0,0 +1,112 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   include/sequence/stream_encoder.h
+*
+*-------------------------------------------------------------------------
+*/
+
+#ifndef SEQUENCE_STREAM_ENCODER_H_
+#define SEQUENCE_STREAM_ENCODER_H_
+
+#include "postgres.h"
+
+#include "sequence/sequence.h"
+
+/**
+ * Maximum number of candidate code sets of a stream encoder.
+ */
+#define PB_STREAM_ENCODER_MAX_CANDIDATES	4
+
+/**
+ * Initial number of stream words allocated by a stream encoder.
+ */
+#define PB_STREAM_ENCODER_INITIAL_WORDS		1024
+
+/**
+ * State of a streaming encoder.
+ *
+ * A stream encoder compresses a sequence, that is handed over in chunks,
+ * with fixed code sets. Since no statistics of the whole sequence are
+ * available in advance, it starts with the first of a list of candidate
+ * code sets. Whenever a symbol occurs, that the current code set can not
+ * express, the stream encoded so far is re-encoded with the next
+ * candidate, that can. Candidates must be ordered from cheapest to most
+ * expressive, and every candidate must be able to express all symbols
+ * of its predecessors.
+ *
+ * Only the compressed stream, the index and the state of the compression
+ * buffer are kept, so the working set is bounded by the size of the
+ * compressed sequence plus one chunk. The result stores no composition.
+ */
+typedef struct {
+	MemoryContext context;
+
+	PB_CodeSet* candidates[PB_STREAM_ENCODER_MAX_CANDIDATES];
+	int n_candidates;
+	int current_candidate;
+	bool ignore_case;
+
+	/*
+	 * right-aligned codes of the current code set, -1 for symbols it can
+	 * not express
+	 */
+	int16 codes[PB_SOURCE_ALPHABET_SIZE];
+	uint8 code_lengths[PB_SOURCE_ALPHABET_SIZE];
+
+	uint64 sequence_length;
+
+	PB_CompressionBuffer buffer;
+	int bits_free;
+
+	PB_CompressionBuffer* stream;
+	uint32 n_words;
+	uint32 max_words;
+
+	PB_IndexEntry* index;
+	uint32 n_entries;
+	uint32 max_entries;
+	int index_counter;
+} PB_StreamEncoder;
+
+/**
+ * stream_encoder_create()
+ * 		Creates a stream encoder in the current memory context.
+ *
+ * 	PB_CodeSet** candidates : fixed code sets, cheapest first
+ * 	int n_candidates : number of candidates
+ * 	bool ignore_case : whether lower case symbols are encoded as upper case
+ */
+PB_StreamEncoder* stream_encoder_create(PB_CodeSet** candidates,
+										int n_candidates,
+										bool ignore_case);
+
+/**
+ * stream_encoder_append()
+ * 		Appends a chunk of a sequence to a stream encoder. Memory is
+ * 		allocated in the memory context the encoder was created in.
+ *
+ * 	PB_StreamEncoder* encoder : stream encoder
+ * 	const uint8* input : chunk, not null-terminated
+ * 	uint32 length : length of the chunk
+ */
+void stream_encoder_append(PB_StreamEncoder* encoder,
+						   const uint8* input,
+						   uint32 length);
+
+/**
+ * stream_encoder_finish()
+ * 		Returns the compressed sequence of all chunks appended so far.
+ * 		The encoder is not modified and can still be appended to.
+ *
+ * 	const PB_StreamEncoder* encoder : stream encoder
+ */
+PB_CompressedSequence* stream_encoder_finish(const PB_StreamEncoder* encoder);
+
+#endif /* SEQUENCE_STREAM_ENCODER_H_ */
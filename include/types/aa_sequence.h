@@ -31,6 +31,8 @@
 typedef struct {
 	uint32 case_sensitive : 1;
 	uint32 restricting_alphabet : 2;
+	uint32 composition : 1;
+	uint32 index_shift : 3;
 } PB_AaSequenceTypMod;
 
 #define PB_AA_TYPMOD_CASE_INSENSITIVE 0
@@ -39,6 +41,9 @@ typedef struct {
 #define PB_AA_TYPMOD_IUPAC			0
 #define PB_AA_TYPMOD_ASCII			1
 
+#define PB_AA_TYPMOD_NO_COMPOSITION	0
+#define PB_AA_TYPMOD_COMPOSITION		1
+
 /*
  * Section 2 - public functions
  */
@@ -254,6 +259,13 @@ Datum aa_sequence_reverse(PG_FUNCTION_ARGS);
  */
 Datum get_alphabet_aa_sequence(PG_FUNCTION_ARGS);
 
+/**
+ * entropy_aa()
+ * 		Returns the Shannon entropy of the symbols of an amino acid
+ * 		sequence in bits.
+ */
+Datum entropy_aa(PG_FUNCTION_ARGS);
+
 /**
  * equal_aa()
  * 		Compares two AA sequence for equality
@@ -308,6 +320,14 @@ Datum compare_aa_ge(PG_FUNCTION_ARGS);
  */
 Datum compare_aa(PG_FUNCTION_ARGS);
 
+/**
+ * sortsupport_aa()
+ * 		Sets up sort support for amino acid sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+Datum sortsupport_aa(PG_FUNCTION_ARGS);
+
 /**
  * hash_aa()
  * 		Returns a CRC32 for a AA sequence.
@@ -322,6 +342,32 @@ Datum hash_aa(PG_FUNCTION_ARGS);
  */
 Datum strpos_aa(PG_FUNCTION_ARGS);
 
+/**
+ * contains_aa()
+ * 		Returns true if an amino acid sequence contains a pattern.
+ */
+Datum contains_aa(PG_FUNCTION_ARGS);
+
+/**
+ * planner_support_aa()
+ * 		Planner support for strpos() and contains() of amino acid sequences.
+ */
+Datum planner_support_aa(PG_FUNCTION_ARGS);
+
+/**
+ * strpos_all_aa()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern, optionally within a window.
+ */
+Datum strpos_all_aa(PG_FUNCTION_ARGS);
+
+/**
+ * count_occurrences_aa()
+ * 		Counts all, possibly overlapping, occurrences of a pattern,
+ * 		optionally within a window.
+ */
+Datum count_occurrences_aa(PG_FUNCTION_ARGS);
+
 /**
  * octet_length_aa()
  * 		Returns byte size of datum.
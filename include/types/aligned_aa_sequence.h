@@ -290,6 +290,14 @@ Datum compare_aligned_aa_ge(PG_FUNCTION_ARGS);
  */
 Datum compare_aligned_aa(PG_FUNCTION_ARGS);
 
+/**
+ * sortsupport_aligned_aa()
+ * 		Sets up sort support for aligned amino acid sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+Datum sortsupport_aligned_aa(PG_FUNCTION_ARGS);
+
 /**
  * hash_aligned_aa()
  * 		Returns a CRC32 for a aligned AA sequence.
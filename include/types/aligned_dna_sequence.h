@@ -312,6 +312,14 @@ Datum compare_aligned_dna_ge(PG_FUNCTION_ARGS);
  */
 Datum compare_aligned_dna(PG_FUNCTION_ARGS);
 
+/**
+ * sortsupport_aligned_dna()
+ * 		Sets up sort support for aligned DNA sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+Datum sortsupport_aligned_dna(PG_FUNCTION_ARGS);
+
 /**
  * hash_aligned_dna()
  * 		Returns a CRC32 for a aligned DNA sequence.
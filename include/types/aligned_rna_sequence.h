@@ -310,6 +310,14 @@ Datum compare_aligned_rna_ge(PG_FUNCTION_ARGS);
  */
 Datum compare_aligned_rna(PG_FUNCTION_ARGS);
 
+/**
+ * sortsupport_aligned_rna()
+ * 		Sets up sort support for aligned RNA sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+Datum sortsupport_aligned_rna(PG_FUNCTION_ARGS);
+
 /**
  * hash_aligned_rna()
  * 		Returns a CRC32 for a aligned RNA sequence.
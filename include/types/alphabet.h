@@ -211,8 +211,8 @@ Datum get_alphabet_text_sequence (PG_FUNCTION_ARGS);
 /**
  * Creates an alphabet from compressed sequence.
  *
- * PB_CompressedSequence* input : the input sequence
+ * Varlena* raw_input : the possibly toasted input sequence
  */
-PB_Alphabet* get_alphabet_compressed_sequence (PB_CompressedSequence* input, PB_CodeSet** fixed_codesets);
+PB_Alphabet* get_alphabet_compressed_sequence (Varlena* raw_input, PB_CodeSet** fixed_codesets);
 
 #endif /* TYPES_ALPHABET_H_ */
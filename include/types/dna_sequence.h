@@ -36,6 +36,8 @@ typedef struct {
 	uint32 case_sensitive : 1;
 	uint32 restricting_alphabet : 2;
 	uint32 compression_strategy : 2;
+	uint32 composition : 1;
+	uint32 index_shift : 3;
 } PB_DnaSequenceTypMod;
 
 #define PB_DNA_TYPMOD_CASE_INSENSITIVE 0
@@ -49,6 +51,9 @@ typedef struct {
 #define PB_DNA_TYPMOD_SHORT			1
 #define PB_DNA_TYPMOD_REFERENCE		2
 
+#define PB_DNA_TYPMOD_NO_COMPOSITION	0
+#define PB_DNA_TYPMOD_COMPOSITION		1
+
 /*
  * Section 2 - public functions
  */
@@ -124,6 +129,21 @@ PB_CompressedSequence* compress_dna_sequence(uint8* input,
 											 PB_DnaSequenceTypMod typmod,
 											 PB_SequenceInfo* info);
 
+/**
+ * compress_dna_sequence_single_pass()
+ * 		Compress a DNA sequence with the four-letter code without
+ * 		collecting sequence info first. Returns NULL if the type modifier
+ * 		or the sequence does not qualify; compress_dna_sequence() has to
+ * 		be used then.
+ *
+ * 	uint8* input : unterminated or null-terminated input sequence
+ * 	int64 length : length of the input sequence
+ * 	PB_DnaSequenceTypMod typmod : target type modifier
+ */
+PB_CompressedSequence* compress_dna_sequence_single_pass(uint8* input,
+														 int64 length,
+														 PB_DnaSequenceTypMod typmod);
+
 /**
  * decompress_dna_sequence()
  * 		Decompress a DNA sequence
@@ -195,6 +215,24 @@ Datum dna_sequence_in (PG_FUNCTION_ARGS);
  */
 Datum dna_sequence_in_varlena (PG_FUNCTION_ARGS);
 
+/**
+ * dna_sequence_agg_transfn()
+ * 		Appends a chunk of a sequence to the stream encoder of
+ * 		dna_sequence_agg().
+ *
+ * 	PB_StreamEncoder* state : stream encoder, NULL on first call
+ * 	text* chunk : next chunk of the sequence
+ */
+Datum dna_sequence_agg_transfn (PG_FUNCTION_ARGS);
+
+/**
+ * dna_sequence_agg_finalfn()
+ * 		Returns the sequence compressed by dna_sequence_agg().
+ *
+ * 	PB_StreamEncoder* state : stream encoder
+ */
+Datum dna_sequence_agg_finalfn (PG_FUNCTION_ARGS);
+
 /**
  * dna_sequence_cast()
  * 		Decompress a given sequence and compress it again
@@ -286,6 +324,27 @@ Datum dna_sequence_reverse_complement(PG_FUNCTION_ARGS);
  */
 Datum get_alphabet_dna_sequence(PG_FUNCTION_ARGS);
 
+/**
+ * gc_content_dna()
+ * 		Returns the fraction of G and C in a DNA sequence or in
+ * 		a range of it, given by start and length like substr().
+ */
+Datum gc_content_dna(PG_FUNCTION_ARGS);
+
+/**
+ * base_counts_dna()
+ * 		Returns each symbol of a DNA sequence or of a range of it
+ * 		with its number of occurrences.
+ */
+Datum base_counts_dna(PG_FUNCTION_ARGS);
+
+/**
+ * entropy_dna()
+ * 		Returns the Shannon entropy of the symbols of a DNA
+ * 		sequence in bits.
+ */
+Datum entropy_dna(PG_FUNCTION_ARGS);
+
 /**
  * equal_dna()
  * 		Compares two DNA sequences for equality
@@ -340,6 +399,14 @@ Datum compare_dna_ge(PG_FUNCTION_ARGS);
  */
 Datum compare_dna(PG_FUNCTION_ARGS);
 
+/**
+ * sortsupport_dna()
+ * 		Sets up sort support for DNA sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+Datum sortsupport_dna(PG_FUNCTION_ARGS);
+
 /**
  * hash_dna()
  * 		Returns a CRC32 for a DNA sequence.
@@ -354,6 +421,62 @@ Datum hash_dna(PG_FUNCTION_ARGS);
  */
 Datum strpos_dna(PG_FUNCTION_ARGS);
 
+/**
+ * strpos_all_dna()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern, optionally within a window.
+ */
+Datum strpos_all_dna(PG_FUNCTION_ARGS);
+
+/**
+ * count_occurrences_dna()
+ * 		Counts all, possibly overlapping, occurrences of a pattern,
+ * 		optionally within a window.
+ */
+Datum count_occurrences_dna(PG_FUNCTION_ARGS);
+
+/**
+ * contains_dna()
+ * 		Returns true if a DNA sequence contains a pattern.
+ */
+Datum contains_dna(PG_FUNCTION_ARGS);
+
+/**
+ * planner_support_dna()
+ * 		Planner support for strpos() and contains() of DNA sequences.
+ */
+Datum planner_support_dna(PG_FUNCTION_ARGS);
+
+/**
+ * contains_sel_dna()
+ * 		Restriction selectivity of the @> operator of DNA sequences.
+ */
+Datum contains_sel_dna(PG_FUNCTION_ARGS);
+
+/**
+ * gin_extract_value_dna_k8()
+ * 		Extracts the 8-mers of a DNA sequence for a GIN index.
+ */
+Datum gin_extract_value_dna_k8(PG_FUNCTION_ARGS);
+
+/**
+ * gin_extract_query_dna_k8()
+ * 		Extracts the 8-mers of a pattern for a GIN index scan.
+ */
+Datum gin_extract_query_dna_k8(PG_FUNCTION_ARGS);
+
+/**
+ * gin_extract_value_dna_k12()
+ * 		Extracts the 12-mers of a DNA sequence for a GIN index.
+ */
+Datum gin_extract_value_dna_k12(PG_FUNCTION_ARGS);
+
+/**
+ * gin_extract_query_dna_k12()
+ * 		Extracts the 12-mers of a pattern for a GIN index scan.
+ */
+Datum gin_extract_query_dna_k12(PG_FUNCTION_ARGS);
+
 /**
  * octet_length_dna()
  * 		Returns byte size of datum.
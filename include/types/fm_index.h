@@ -0,0 +1,60 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   include/types/fm_index.h
+*
+*-------------------------------------------------------------------------
+*/
+
+#ifndef TYPES_FM_INDEX_H_
+#define TYPES_FM_INDEX_H_
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "sequence/fm_index.h"
+
+/**
+ * fm_index_in()
+ * 		Builds an FM-index from a cstring.
+ */
+Datum fm_index_in(PG_FUNCTION_ARGS);
+
+/**
+ * fm_index_out()
+ * 		Restores the indexed sequence.
+ */
+Datum fm_index_out(PG_FUNCTION_ARGS);
+
+/**
+ * fm_index_dna()
+ * 		Builds an FM-index from a DNA sequence.
+ */
+Datum fm_index_dna(PG_FUNCTION_ARGS);
+
+/**
+ * count_fm_index()
+ * 		Counts all, possibly overlapping, occurrences of a pattern.
+ */
+Datum count_fm_index(PG_FUNCTION_ARGS);
+
+/**
+ * locate_fm_index()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern in ascending order.
+ */
+Datum locate_fm_index(PG_FUNCTION_ARGS);
+
+/**
+ * length_fm_index()
+ * 		Returns the length of the indexed sequence.
+ */
+Datum length_fm_index(PG_FUNCTION_ARGS);
+
+#endif /* TYPES_FM_INDEX_H_ */
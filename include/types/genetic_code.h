@@ -0,0 +1,105 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   include/types/genetic_code.h
+*
+*-------------------------------------------------------------------------
+*/
+
+#ifndef TYPES_GENETIC_CODE_H_
+#define TYPES_GENETIC_CODE_H_
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "sequence/sequence.h"
+
+/**
+ * Nucleotides as bits of a nucleotide set. The bit of a nucleotide is
+ * 1 << its position in the order U, C, A, G of translation tables.
+ * IUPAC symbols are the sets of the nucleotides they stand for, other
+ * symbols are the empty set.
+ */
+#define PB_NUCLEOTIDE_SET_U		0x1
+#define PB_NUCLEOTIDE_SET_C		0x2
+#define PB_NUCLEOTIDE_SET_A		0x4
+#define PB_NUCLEOTIDE_SET_G		0x8
+
+/**
+ * Complement of a nucleotide set, swaps U and A as well as C and G.
+ */
+#define PB_COMPLEMENT_NUCLEOTIDE_SET(set)	((((set) << 2) | ((set) >> 2)) & 0xF)
+
+/**
+ * Index of a codon of three nucleotide sets.
+ */
+#define PB_CODON_INDEX(first, second, third)	(((first) << 8) | ((second) << 4) | (third))
+
+/**
+ * Number of codons of nucleotide sets.
+ */
+#define PB_GENETIC_CODE_N_CODONS	4096
+
+/**
+ * A genetic code in a form, that translates codons with a single lookup.
+ *
+ *	int32 id					:	NCBI translation table id, 0 for custom tables
+ *	uint8 amino_acids[]			:	translation table in the order of NCBI
+ *	uint8 packed_codons[]		:	amino acids of codons of 2-bit FLC codes,
+ *									where A, C, G, T/U are 0 to 3
+ *	uint8 codons[]				:	amino acids of codons of nucleotide sets,
+ *									indexed by PB_CODON_INDEX
+ *
+ * Codons of IUPAC symbols translate to the amino acid, that all codons
+ * they stand for translate to, or to X if they are ambiguous.
+ */
+typedef struct {
+	int32 id;
+	uint8 amino_acids[64];
+	uint8 packed_codons[64];
+	uint8 codons[PB_GENETIC_CODE_N_CODONS];
+} PB_GeneticCode;
+
+/**
+ * get_nucleotide_sets()
+ * 		Returns the nucleotide set of every symbol. Case is ignored and
+ * 		T is the same as U.
+ */
+const uint8* get_nucleotide_sets(void);
+
+/**
+ * get_genetic_code()
+ * 		Returns the genetic code of an NCBI translation table id. The
+ * 		code is built once per backend.
+ *
+ * 	int32 id : NCBI translation table id
+ */
+const PB_GeneticCode* get_genetic_code(int32 id);
+
+/**
+ * get_genetic_code_from_table()
+ * 		Returns the genetic code of a 64 chars long translation table.
+ * 		Tables of the registry are looked up, other tables are built in
+ * 		the current memory context.
+ *
+ * 	text* table_input : translation table
+ */
+const PB_GeneticCode* get_genetic_code_from_table(text* table_input);
+
+/*
+ * SQL functions
+ */
+
+/**
+ * get_transl_table()
+ * 		Returns the translation table of an NCBI translation table id.
+ */
+Datum get_transl_table(PG_FUNCTION_ARGS);
+
+#endif /* TYPES_GENETIC_CODE_H_ */
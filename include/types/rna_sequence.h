@@ -32,6 +32,8 @@
 typedef struct {
 	uint32 case_sensitive : 1;
 	uint32 restricting_alphabet : 2;
+	uint32 composition : 1;
+	uint32 index_shift : 3;
 } PB_RnaSequenceTypMod;
 
 #define PB_RNA_TYPMOD_CASE_INSENSITIVE 0
@@ -41,6 +43,9 @@ typedef struct {
 #define PB_RNA_TYPMOD_FLC				1
 #define PB_RNA_TYPMOD_ASCII			2
 
+#define PB_RNA_TYPMOD_NO_COMPOSITION	0
+#define PB_RNA_TYPMOD_COMPOSITION		1
+
 /*
  * Section 2 - public functions
  */
@@ -263,6 +268,15 @@ Datum rna_sequence_reverse(PG_FUNCTION_ARGS);
  */
 Datum rna_sequence_reverse_complement(PG_FUNCTION_ARGS);
 
+/**
+ * rna_sequence_six_frame()
+ * 		Returns the three reading frames of a RNA sequence and of its
+ * 		reverse complement.
+ *
+ * 	PB_CompressedSequence* input : compressed input sequence
+ */
+Datum rna_sequence_six_frame(PG_FUNCTION_ARGS);
+
 /**
  * get_alphabet_rna_sequence()
  * 		Calculates alphabet from rna sequence.
@@ -271,6 +285,27 @@ Datum rna_sequence_reverse_complement(PG_FUNCTION_ARGS);
  */
 Datum get_alphabet_rna_sequence(PG_FUNCTION_ARGS);
 
+/**
+ * gc_content_rna()
+ * 		Returns the fraction of G and C in an RNA sequence or in
+ * 		a range of it, given by start and length like substr().
+ */
+Datum gc_content_rna(PG_FUNCTION_ARGS);
+
+/**
+ * base_counts_rna()
+ * 		Returns each symbol of an RNA sequence or of a range of it
+ * 		with its number of occurrences.
+ */
+Datum base_counts_rna(PG_FUNCTION_ARGS);
+
+/**
+ * entropy_rna()
+ * 		Returns the Shannon entropy of the symbols of an RNA
+ * 		sequence in bits.
+ */
+Datum entropy_rna(PG_FUNCTION_ARGS);
+
 /**
  * equal_rna()
  * 		Compares two RNA sequences for equality
@@ -325,6 +360,14 @@ Datum compare_rna_ge(PG_FUNCTION_ARGS);
  */
 Datum compare_rna(PG_FUNCTION_ARGS);
 
+/**
+ * sortsupport_rna()
+ * 		Sets up sort support for RNA sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+Datum sortsupport_rna(PG_FUNCTION_ARGS);
+
 /**
  * hash_rna()
  * 		Returns a CRC32 for a RNA sequence.
@@ -339,6 +382,32 @@ Datum hash_rna(PG_FUNCTION_ARGS);
  */
 Datum strpos_rna(PG_FUNCTION_ARGS);
 
+/**
+ * contains_rna()
+ * 		Returns true if an RNA sequence contains a pattern.
+ */
+Datum contains_rna(PG_FUNCTION_ARGS);
+
+/**
+ * planner_support_rna()
+ * 		Planner support for strpos() and contains() of RNA sequences.
+ */
+Datum planner_support_rna(PG_FUNCTION_ARGS);
+
+/**
+ * strpos_all_rna()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern, optionally within a window.
+ */
+Datum strpos_all_rna(PG_FUNCTION_ARGS);
+
+/**
+ * count_occurrences_rna()
+ * 		Counts all, possibly overlapping, occurrences of a pattern,
+ * 		optionally within a window.
+ */
+Datum count_occurrences_rna(PG_FUNCTION_ARGS);
+
 /**
  * octet_length_rna()
  * 		Returns byte size of datum.
@@ -229,6 +229,11 @@ CREATE FUNCTION compare_dna(dna_sequence, dna_sequence)
   '$libdir/postbis', 'compare_dna'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION sortsupport_dna(internal)
+  RETURNS void AS
+  '$libdir/postbis', 'sortsupport_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE OPERATOR CLASS dna_sequence_btree_ops
   DEFAULT FOR TYPE dna_sequence USING btree AS
     OPERATOR 1 < (dna_sequence, dna_sequence),
@@ -236,7 +241,8 @@ CREATE OPERATOR CLASS dna_sequence_btree_ops
     OPERATOR 3 = (dna_sequence, dna_sequence),
     OPERATOR 4 >= (dna_sequence, dna_sequence),
     OPERATOR 5 > (dna_sequence, dna_sequence),
-    FUNCTION 1 compare_dna(dna_sequence, dna_sequence);
+    FUNCTION 1 compare_dna(dna_sequence, dna_sequence),
+    FUNCTION 2 sortsupport_dna(internal);
 
 CREATE FUNCTION hash_dna(dna_sequence)
   RETURNS integer AS
@@ -249,9 +255,9 @@ CREATE OPERATOR CLASS dna_sequence_hash_ops
     FUNCTION 1 hash_dna(dna_sequence);
 
 CREATE FUNCTION concat_dna(dna_sequence, dna_sequence)
-  RETURNS dna_sequence AS $$
-    SELECT ($1::text || $2::text)::dna_sequence;
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS dna_sequence AS
+  '$libdir/postbis', 'concat_dna'
+  LANGUAGE c IMMUTABLE STRICT;
 
 CREATE OPERATOR || (
   leftarg = dna_sequence,
@@ -270,11 +276,118 @@ CREATE FUNCTION strpos(dna_sequence, dna_sequence)
     SELECT strpos($1, $2::text);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
+CREATE FUNCTION strpos_all(dna_sequence, text)
+  RETURNS SETOF int4 AS
+  '$libdir/postbis', 'strpos_all_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION strpos_all(dna_sequence, text, int4, int4)
+  RETURNS SETOF int4 AS
+  '$libdir/postbis', 'strpos_all_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION count_occurrences(dna_sequence, text)
+  RETURNS int8 AS
+  '$libdir/postbis', 'count_occurrences_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION count_occurrences(dna_sequence, text, int4, int4)
+  RETURNS int8 AS
+  '$libdir/postbis', 'count_occurrences_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE FUNCTION octet_length(dna_sequence)
   RETURNS int4 AS
   '$libdir/postbis', 'octet_length_dna'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION contains_dna(dna_sequence, text)
+  RETURNS bool AS
+  '$libdir/postbis', 'contains_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION contains(dna_sequence, text)
+  RETURNS bool AS
+  '$libdir/postbis', 'contains_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION planner_support_dna(internal)
+  RETURNS internal AS
+  '$libdir/postbis', 'planner_support_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION contains_sel_dna(internal, oid, internal, int4)
+  RETURNS float8 AS
+  '$libdir/postbis', 'contains_sel_dna'
+  LANGUAGE c STABLE STRICT;
+
+CREATE OPERATOR @> (
+  leftarg = dna_sequence,
+  rightarg = text,
+  procedure = contains_dna,
+  restrict = contains_sel_dna,
+  join = contjoinsel
+);
+
+CREATE FUNCTION gin_consistent_kmer(internal, int2, text, int4, internal, internal, internal, internal)
+  RETURNS bool AS
+  '$libdir/postbis', 'gin_consistent_kmer'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION gin_extract_value_dna_k8(dna_sequence, internal)
+  RETURNS internal AS
+  '$libdir/postbis', 'gin_extract_value_dna_k8'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION gin_extract_query_dna_k8(text, internal, int2, internal, internal, internal, internal)
+  RETURNS internal AS
+  '$libdir/postbis', 'gin_extract_query_dna_k8'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS dna_sequence_kmer8_ops
+  DEFAULT FOR TYPE dna_sequence USING gin AS
+    OPERATOR 1 @> (dna_sequence, text),
+    FUNCTION 1 btint4cmp(int4, int4),
+    FUNCTION 2 gin_extract_value_dna_k8(dna_sequence, internal),
+    FUNCTION 3 gin_extract_query_dna_k8(text, internal, int2, internal, internal, internal, internal),
+    FUNCTION 4 gin_consistent_kmer(internal, int2, text, int4, internal, internal, internal, internal),
+    STORAGE int4;
+
+CREATE FUNCTION gin_extract_value_dna_k12(dna_sequence, internal)
+  RETURNS internal AS
+  '$libdir/postbis', 'gin_extract_value_dna_k12'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION gin_extract_query_dna_k12(text, internal, int2, internal, internal, internal, internal)
+  RETURNS internal AS
+  '$libdir/postbis', 'gin_extract_query_dna_k12'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE OPERATOR CLASS dna_sequence_kmer12_ops
+  FOR TYPE dna_sequence USING gin AS
+    OPERATOR 1 @> (dna_sequence, text),
+    FUNCTION 1 btint4cmp(int4, int4),
+    FUNCTION 2 gin_extract_value_dna_k12(dna_sequence, internal),
+    FUNCTION 3 gin_extract_query_dna_k12(text, internal, int2, internal, internal, internal, internal),
+    FUNCTION 4 gin_consistent_kmer(internal, int2, text, int4, internal, internal, internal, internal),
+    STORAGE int4;
+
+CREATE FUNCTION dna_sequence_agg_transfn(internal, text)
+  RETURNS internal AS
+  '$libdir/postbis', 'dna_sequence_agg_transfn'
+  LANGUAGE c IMMUTABLE;
+
+CREATE FUNCTION dna_sequence_agg_finalfn(internal)
+  RETURNS dna_sequence AS
+  '$libdir/postbis', 'dna_sequence_agg_finalfn'
+  LANGUAGE c IMMUTABLE;
+
+CREATE AGGREGATE dna_sequence_agg(text) (
+  sfunc = dna_sequence_agg_transfn,
+  stype = internal,
+  finalfunc = dna_sequence_agg_finalfn
+);
+
 /*
 *	Type: rna_sequence
 */
@@ -502,6 +615,11 @@ CREATE FUNCTION compare_rna(rna_sequence, rna_sequence)
   '$libdir/postbis', 'compare_rna'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION sortsupport_rna(internal)
+  RETURNS void AS
+  '$libdir/postbis', 'sortsupport_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE OPERATOR CLASS rna_sequence_btree_ops
   DEFAULT FOR TYPE rna_sequence USING btree AS
     OPERATOR 1 < (rna_sequence, rna_sequence),
@@ -509,7 +627,8 @@ CREATE OPERATOR CLASS rna_sequence_btree_ops
     OPERATOR 3 = (rna_sequence, rna_sequence),
     OPERATOR 4 >= (rna_sequence, rna_sequence),
     OPERATOR 5 > (rna_sequence, rna_sequence),
-    FUNCTION 1 compare_rna(rna_sequence, rna_sequence);
+    FUNCTION 1 compare_rna(rna_sequence, rna_sequence),
+    FUNCTION 2 sortsupport_rna(internal);
 
 CREATE FUNCTION hash_rna(rna_sequence)
   RETURNS integer AS
@@ -522,9 +641,9 @@ CREATE OPERATOR CLASS rna_sequence_hash_ops
     FUNCTION 1 hash_rna(rna_sequence);
 
 CREATE FUNCTION concat_rna(rna_sequence, rna_sequence)
-  RETURNS rna_sequence AS $$
-    SELECT ($1::text || $2::text)::rna_sequence;
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS rna_sequence AS
+  '$libdir/postbis', 'concat_rna'
+  LANGUAGE c IMMUTABLE STRICT;
 
 CREATE OPERATOR || (
   leftarg = rna_sequence,
@@ -543,6 +662,36 @@ CREATE FUNCTION strpos(rna_sequence, rna_sequence)
     SELECT strpos($1, $2::text);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
+CREATE FUNCTION contains(rna_sequence, text)
+  RETURNS bool AS
+  '$libdir/postbis', 'contains_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION planner_support_rna(internal)
+  RETURNS internal AS
+  '$libdir/postbis', 'planner_support_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION strpos_all(rna_sequence, text)
+  RETURNS SETOF int4 AS
+  '$libdir/postbis', 'strpos_all_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION strpos_all(rna_sequence, text, int4, int4)
+  RETURNS SETOF int4 AS
+  '$libdir/postbis', 'strpos_all_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION count_occurrences(rna_sequence, text)
+  RETURNS int8 AS
+  '$libdir/postbis', 'count_occurrences_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION count_occurrences(rna_sequence, text, int4, int4)
+  RETURNS int8 AS
+  '$libdir/postbis', 'count_occurrences_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE FUNCTION octet_length(rna_sequence)
   RETURNS int4 AS
   '$libdir/postbis', 'octet_length_rna'
@@ -755,6 +904,11 @@ CREATE FUNCTION compare_aa(aa_sequence, aa_sequence)
   '$libdir/postbis', 'compare_aa'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION sortsupport_aa(internal)
+  RETURNS void AS
+  '$libdir/postbis', 'sortsupport_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE OPERATOR CLASS aa_sequence_btree_ops
   DEFAULT FOR TYPE aa_sequence USING btree AS
     OPERATOR 1 < (aa_sequence, aa_sequence),
@@ -762,7 +916,8 @@ CREATE OPERATOR CLASS aa_sequence_btree_ops
     OPERATOR 3 = (aa_sequence, aa_sequence),
     OPERATOR 4 >= (aa_sequence, aa_sequence),
     OPERATOR 5 > (aa_sequence, aa_sequence),
-    FUNCTION 1 compare_aa(aa_sequence, aa_sequence);
+    FUNCTION 1 compare_aa(aa_sequence, aa_sequence),
+    FUNCTION 2 sortsupport_aa(internal);
 
 CREATE FUNCTION hash_aa(aa_sequence)
   RETURNS integer AS
@@ -775,9 +930,9 @@ CREATE OPERATOR CLASS aa_sequence_hash_ops
     FUNCTION 1 hash_aa(aa_sequence);
 
 CREATE FUNCTION concat_aa(aa_sequence, aa_sequence)
-  RETURNS aa_sequence AS $$
-    SELECT ($1::text || $2::text)::aa_sequence;
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS aa_sequence AS
+  '$libdir/postbis', 'concat_aa'
+  LANGUAGE c IMMUTABLE STRICT;
 
 CREATE OPERATOR || (
   leftarg = aa_sequence,
@@ -796,6 +951,36 @@ CREATE FUNCTION strpos(aa_sequence, aa_sequence)
     SELECT strpos($1, $2::text);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
+CREATE FUNCTION contains(aa_sequence, text)
+  RETURNS bool AS
+  '$libdir/postbis', 'contains_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION planner_support_aa(internal)
+  RETURNS internal AS
+  '$libdir/postbis', 'planner_support_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION strpos_all(aa_sequence, text)
+  RETURNS SETOF int4 AS
+  '$libdir/postbis', 'strpos_all_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION strpos_all(aa_sequence, text, int4, int4)
+  RETURNS SETOF int4 AS
+  '$libdir/postbis', 'strpos_all_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION count_occurrences(aa_sequence, text)
+  RETURNS int8 AS
+  '$libdir/postbis', 'count_occurrences_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION count_occurrences(aa_sequence, text, int4, int4)
+  RETURNS int8 AS
+  '$libdir/postbis', 'count_occurrences_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE FUNCTION octet_length(aa_sequence)
   RETURNS int4 AS
   '$libdir/postbis', 'octet_length_aa'
@@ -806,173 +991,151 @@ CREATE FUNCTION translate(rna_sequence, text)
   '$libdir/postbis', 'translate_rna'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION translate(rna_sequence, int)
+  RETURNS aa_sequence AS
+  '$libdir/postbis', 'translate_rna_by_id'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION translate(dna_sequence, text)
+  RETURNS aa_sequence AS
+  '$libdir/postbis', 'translate_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION translate(dna_sequence, int)
+  RETURNS aa_sequence AS
+  '$libdir/postbis', 'translate_dna_by_id'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION get_transl_table(int)
+  RETURNS text AS
+  '$libdir/postbis', 'get_transl_table'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE FUNCTION standard_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(1);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION vertebrate_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(2);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION yeast_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(3);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION mold_protozoan_coelenterate_mitochondrial_and_mycoplasma_spiroplasma_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(4);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION invertebrate_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(5);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION ciliate_dasycladacean_hexamita_nuclear_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(6);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION echinodem_flatworm_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(9);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION euplotid_nuclear_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCCWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(10);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION bacterial_archaeal_plant_plastid_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(11);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION alternative_yeast_nuclear_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CC*WLLLSPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(12);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION ascidian_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSGGVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(13);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION alternative_flatworm_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(14);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION blepharisma_nuclear_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY*QCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(15);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION chlorophycean_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(16);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION trematode_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNNKSSSSVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(21);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION scenedesmus_obliquus_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSS*SYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(22);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION thraustochytrium_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FF*LSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(23);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION pterobranchia_mitochondrial_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(24);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
 CREATE FUNCTION candidate_division_sr1_gracilibacteria_code()
   RETURNS text AS $$
-    SELECT 'FFLLSSSSYY**CCGWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG'::TEXT;
+    SELECT get_transl_table(25);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
-CREATE FUNCTION get_transl_table(int)
-  RETURNS text AS $$
-  DECLARE
-    result text;
-  BEGIN
-    CASE $1
-      WHEN 1 THEN
-        result := standard_code();
-      WHEN 2 THEN
-        result := vertebrate_mitochondrial_code();
-      WHEN 3 THEN
-        result := yeast_mitochondrial_code();
-      WHEN 4 THEN
-        result := mold_protozoan_coelenterate_mitochondrial_and_mycoplasma_spiroplasma_code();
-      WHEN 5 THEN
-        result := invertebrate_mitochondrial_code();
-      WHEN 6 THEN
-        result := ciliate_dasycladacean_hexamita_nuclear_code();
-      WHEN 9 THEN
-        result := echinodem_flatworm_mitochondrial_code();
-      WHEN 10 THEN
-        result := euplotid_nuclear_code();
-      WHEN 11 THEN
-        result := bacterial_archaeal_plant_plastid_code();
-      WHEN 12 THEN
-        result := alternative_yeast_nuclear_code();
-      WHEN 13 THEN
-        result := ascidian_mitochondrial_code();
-      WHEN 14 THEN
-        result := alternative_flatworm_mitochondrial_code();
-      WHEN 15 THEN
-        result := blepharisma_nuclear_code();
-      WHEN 16 THEN
-        result := chlorophycean_mitochondrial_code();
-      WHEN 21 THEN
-        result := trematode_mitochondrial_code();
-      WHEN 22 THEN
-        result := scenedesmus_obliquus_mitochondrial_code();
-      WHEN 23 THEN
-        result := thraustochytrium_mitochondrial_code();
-      WHEN 24 THEN
-        result := pterobranchia_mitochondrial_code();
-      WHEN 25 THEN
-        result := candidate_division_sr1_gracilibacteria_code();
-      ELSE
-        RAISE EXCEPTION 'translation table % does not exists', $1;
-      END CASE;
-    RETURN result;
-  END;
-  $$ LANGUAGE plpgsql IMMUTABLE STRICT;
-
 CREATE FUNCTION translate(rna_sequence)
   RETURNS aa_sequence AS $$
-    SELECT translate($1, standard_code());
+    SELECT translate($1, 1);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
-CREATE FUNCTION six_frame(rna_sequence)
-  RETURNS SETOF rna_sequence AS $$
-    SELECT ($1::rna_sequence)
-    UNION ALL
-    SELECT (reverse_complement($1)::rna_sequence)
-    UNION ALL
-    SELECT (substr($1, 2, char_length($1) - 1)::rna_sequence )
-    UNION ALL
-    SELECT (reverse_complement(substr($1, 2, char_length($1) - 1)::rna_sequence ))
-    UNION ALL
-    SELECT (substr($1, 3, char_length($1) - 2)::rna_sequence )
-    UNION ALL
-    SELECT (reverse_complement(substr($1, 3, char_length($1) - 2)::rna_sequence ))
-    ;
+CREATE FUNCTION translate(dna_sequence)
+  RETURNS aa_sequence AS $$
+    SELECT translate($1, 1);
   $$ LANGUAGE sql IMMUTABLE STRICT;
 
+CREATE FUNCTION six_frame(rna_sequence)
+  RETURNS SETOF rna_sequence AS
+  '$libdir/postbis', 'rna_sequence_six_frame'
+  LANGUAGE c IMMUTABLE STRICT ROWS 6;
+
+CREATE FUNCTION six_frame_translate(rna_sequence, text)
+  RETURNS SETOF aa_sequence AS
+  '$libdir/postbis', 'six_frame_translate_rna'
+  LANGUAGE c IMMUTABLE STRICT ROWS 6;
+
+CREATE FUNCTION six_frame_translate(rna_sequence, int)
+  RETURNS SETOF aa_sequence AS
+  '$libdir/postbis', 'six_frame_translate_rna_by_id'
+  LANGUAGE c IMMUTABLE STRICT ROWS 6;
+
+CREATE FUNCTION six_frame_translate(rna_sequence)
+  RETURNS SETOF aa_sequence AS $$
+    SELECT six_frame_translate($1, 1);
+  $$ LANGUAGE sql IMMUTABLE STRICT ROWS 6;
+
 /*
 *	Type: aligned_dna_sequence
 */
@@ -1196,6 +1359,11 @@ CREATE FUNCTION compare_aligned_dna(aligned_dna_sequence, aligned_dna_sequence)
   '$libdir/postbis', 'compare_aligned_dna'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION sortsupport_aligned_dna(internal)
+  RETURNS void AS
+  '$libdir/postbis', 'sortsupport_aligned_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE OPERATOR CLASS aligned_dna_sequence_btree_ops
   DEFAULT FOR TYPE aligned_dna_sequence USING btree AS
     OPERATOR 1 < (aligned_dna_sequence, aligned_dna_sequence),
@@ -1203,7 +1371,8 @@ CREATE OPERATOR CLASS aligned_dna_sequence_btree_ops
     OPERATOR 3 = (aligned_dna_sequence, aligned_dna_sequence),
     OPERATOR 4 >= (aligned_dna_sequence, aligned_dna_sequence),
     OPERATOR 5 > (aligned_dna_sequence, aligned_dna_sequence),
-    FUNCTION 1 compare_aligned_dna(aligned_dna_sequence, aligned_dna_sequence);
+    FUNCTION 1 compare_aligned_dna(aligned_dna_sequence, aligned_dna_sequence),
+    FUNCTION 2 sortsupport_aligned_dna(internal);
 
 CREATE FUNCTION hash_aligned_dna(aligned_dna_sequence)
   RETURNS integer AS
@@ -1216,9 +1385,9 @@ CREATE OPERATOR CLASS aligned_dna_sequence_hash_ops
     FUNCTION 1 hash_aligned_dna(aligned_dna_sequence);
 
 CREATE FUNCTION concat_aligned_dna(aligned_dna_sequence, aligned_dna_sequence)
-  RETURNS aligned_dna_sequence AS $$
-    SELECT ($1::text || $2::text)::aligned_dna_sequence;
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS aligned_dna_sequence AS
+  '$libdir/postbis', 'concat_aligned_dna'
+  LANGUAGE c IMMUTABLE STRICT;
 
 CREATE OPERATOR || (
   leftarg = aligned_dna_sequence,
@@ -1465,6 +1634,11 @@ CREATE FUNCTION compare_aligned_rna(aligned_rna_sequence, aligned_rna_sequence)
   '$libdir/postbis', 'compare_aligned_rna'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION sortsupport_aligned_rna(internal)
+  RETURNS void AS
+  '$libdir/postbis', 'sortsupport_aligned_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE OPERATOR CLASS aligned_rna_sequence_btree_ops
   DEFAULT FOR TYPE aligned_rna_sequence USING btree AS
     OPERATOR 1 < (aligned_rna_sequence, aligned_rna_sequence),
@@ -1472,7 +1646,8 @@ CREATE OPERATOR CLASS aligned_rna_sequence_btree_ops
     OPERATOR 3 = (aligned_rna_sequence, aligned_rna_sequence),
     OPERATOR 4 >= (aligned_rna_sequence, aligned_rna_sequence),
     OPERATOR 5 > (aligned_rna_sequence, aligned_rna_sequence),
-    FUNCTION 1 compare_aligned_rna(aligned_rna_sequence, aligned_rna_sequence);
+    FUNCTION 1 compare_aligned_rna(aligned_rna_sequence, aligned_rna_sequence),
+    FUNCTION 2 sortsupport_aligned_rna(internal);
 
 CREATE FUNCTION hash_aligned_rna(aligned_rna_sequence)
   RETURNS integer AS
@@ -1485,9 +1660,9 @@ CREATE OPERATOR CLASS aligned_rna_sequence_hash_ops
     FUNCTION 1 hash_aligned_rna(aligned_rna_sequence);
 
 CREATE FUNCTION concat_aligned_rna(aligned_rna_sequence, aligned_rna_sequence)
-  RETURNS aligned_rna_sequence AS $$
-    SELECT ($1::text || $2::text)::aligned_rna_sequence;
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS aligned_rna_sequence AS
+  '$libdir/postbis', 'concat_aligned_rna'
+  LANGUAGE c IMMUTABLE STRICT;
 
 CREATE OPERATOR || (
   leftarg = aligned_rna_sequence,
@@ -1724,6 +1899,11 @@ CREATE FUNCTION compare_aligned_aa(aligned_aa_sequence, aligned_aa_sequence)
   '$libdir/postbis', 'compare_aligned_aa'
   LANGUAGE c IMMUTABLE STRICT;
 
+CREATE FUNCTION sortsupport_aligned_aa(internal)
+  RETURNS void AS
+  '$libdir/postbis', 'sortsupport_aligned_aa'
+  LANGUAGE c IMMUTABLE STRICT;
+
 CREATE OPERATOR CLASS aligned_aa_sequence_btree_ops
   DEFAULT FOR TYPE aligned_aa_sequence USING btree AS
     OPERATOR 1 < (aligned_aa_sequence, aligned_aa_sequence),
@@ -1731,7 +1911,8 @@ CREATE OPERATOR CLASS aligned_aa_sequence_btree_ops
     OPERATOR 3 = (aligned_aa_sequence, aligned_aa_sequence),
     OPERATOR 4 >= (aligned_aa_sequence, aligned_aa_sequence),
     OPERATOR 5 > (aligned_aa_sequence, aligned_aa_sequence),
-    FUNCTION 1 compare_aligned_aa(aligned_aa_sequence, aligned_aa_sequence);
+    FUNCTION 1 compare_aligned_aa(aligned_aa_sequence, aligned_aa_sequence),
+    FUNCTION 2 sortsupport_aligned_aa(internal);
 
 CREATE FUNCTION hash_aligned_aa(aligned_aa_sequence)
   RETURNS integer AS
@@ -1744,9 +1925,9 @@ CREATE OPERATOR CLASS aligned_aa_sequence_hash_ops
     FUNCTION 1 hash_aligned_aa(aligned_aa_sequence);
 
 CREATE FUNCTION concat_aligned_aa(aligned_aa_sequence, aligned_aa_sequence)
-  RETURNS aligned_aa_sequence AS $$
-    SELECT ($1::text || $2::text)::aligned_aa_sequence;
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS aligned_aa_sequence AS
+  '$libdir/postbis', 'concat_aligned_aa'
+  LANGUAGE c IMMUTABLE STRICT;
 
 CREATE OPERATOR || (
   leftarg = aligned_aa_sequence,
@@ -1856,6 +2037,48 @@ CREATE FUNCTION get_alphabet(aligned_aa_sequence)
   '$libdir/postbis', 'get_alphabet_aligned_aa_sequence'
   LANGUAGE c IMMUTABLE STRICT;
 
+/*
+*	Type: fm_index
+*/
+CREATE TYPE fm_index;
+
+CREATE FUNCTION fm_index_in(cstring)
+  RETURNS fm_index AS
+  '$libdir/postbis', 'fm_index_in'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION fm_index_out(fm_index)
+  RETURNS cstring AS
+  '$libdir/postbis', 'fm_index_out'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE TYPE fm_index (
+  input = fm_index_in,
+  output = fm_index_out,
+  internallength = VARIABLE,
+  storage = EXTERNAL
+);
+
+CREATE FUNCTION fm_index(dna_sequence)
+  RETURNS fm_index AS
+  '$libdir/postbis', 'fm_index_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION count(fm_index, text)
+  RETURNS int8 AS
+  '$libdir/postbis', 'count_fm_index'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION locate(fm_index, text)
+  RETURNS SETOF int4 AS
+  '$libdir/postbis', 'locate_fm_index'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION length(fm_index)
+  RETURNS int4 AS
+  '$libdir/postbis', 'length_fm_index'
+  LANGUAGE c IMMUTABLE STRICT;
+
 /*
 * DNA alphabet generator functions
 */
@@ -2110,14 +2333,59 @@ CREATE OR REPLACE FUNCTION gc_content(alphabet)
   $$ LANGUAGE plpgsql IMMUTABLE STRICT;
 
 CREATE OR REPLACE FUNCTION gc_content(dna_sequence)
-  RETURNS real AS $$
-    SELECT gc_content(get_alphabet($1));
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS real AS
+  '$libdir/postbis', 'gc_content_dna'
+  LANGUAGE c IMMUTABLE STRICT;
 
 CREATE OR REPLACE FUNCTION gc_content(rna_sequence)
-  RETURNS real AS $$
-    SELECT gc_content(get_alphabet($1));
-  $$ LANGUAGE sql IMMUTABLE STRICT;
+  RETURNS real AS
+  '$libdir/postbis', 'gc_content_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION base_counts(dna_sequence, OUT symbol text, OUT count int8)
+  RETURNS SETOF record AS
+  '$libdir/postbis', 'base_counts_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION base_counts(rna_sequence, OUT symbol text, OUT count int8)
+  RETURNS SETOF record AS
+  '$libdir/postbis', 'base_counts_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION gc_content(dna_sequence, int4, int4)
+  RETURNS real AS
+  '$libdir/postbis', 'gc_content_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION gc_content(rna_sequence, int4, int4)
+  RETURNS real AS
+  '$libdir/postbis', 'gc_content_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION base_counts(dna_sequence, int4, int4, OUT symbol text, OUT count int8)
+  RETURNS SETOF record AS
+  '$libdir/postbis', 'base_counts_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION base_counts(rna_sequence, int4, int4, OUT symbol text, OUT count int8)
+  RETURNS SETOF record AS
+  '$libdir/postbis', 'base_counts_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION entropy(dna_sequence)
+  RETURNS float4 AS
+  '$libdir/postbis', 'entropy_dna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION entropy(rna_sequence)
+  RETURNS float4 AS
+  '$libdir/postbis', 'entropy_rna'
+  LANGUAGE c IMMUTABLE STRICT;
+
+CREATE FUNCTION entropy(aa_sequence)
+  RETURNS float4 AS
+  '$libdir/postbis', 'entropy_aa'
+  LANGUAGE c IMMUTABLE STRICT;
 
 /*
 *	Test functions
@@ -2128,3 +2396,38 @@ CREATE FUNCTION generate_sequence(alphabet, int)
   '$libdir/postbis', 'generate_sequence'
   LANGUAGE c VOLATILE STRICT;
 
+/*
+*	Diagnostic functions
+*/
+
+CREATE FUNCTION decoding_map_cache_stats(OUT hits int8,
+                                         OUT misses int8,
+                                         OUT evictions int8,
+                                         OUT fixed_entries int4,
+                                         OUT sequence_entries int4)
+  RETURNS record AS
+  '$libdir/postbis', 'decoding_map_cache_stats'
+  LANGUAGE c VOLATILE STRICT;
+
+CREATE FUNCTION sequence_hash_version()
+  RETURNS integer AS
+  '$libdir/postbis', 'sequence_hash_version'
+  LANGUAGE c IMMUTABLE STRICT;
+
+/*
+*	Planner support, PostgreSQL 12 and later
+*/
+
+DO $$
+  BEGIN
+    IF current_setting('server_version_num')::int4 >= 120000 THEN
+      EXECUTE 'ALTER FUNCTION strpos(dna_sequence, text) SUPPORT planner_support_dna';
+      EXECUTE 'ALTER FUNCTION contains(dna_sequence, text) SUPPORT planner_support_dna';
+      EXECUTE 'ALTER FUNCTION contains_dna(dna_sequence, text) SUPPORT planner_support_dna';
+      EXECUTE 'ALTER FUNCTION strpos(rna_sequence, text) SUPPORT planner_support_rna';
+      EXECUTE 'ALTER FUNCTION contains(rna_sequence, text) SUPPORT planner_support_rna';
+      EXECUTE 'ALTER FUNCTION strpos(aa_sequence, text) SUPPORT planner_support_aa';
+      EXECUTE 'ALTER FUNCTION contains(aa_sequence, text) SUPPORT planner_support_aa';
+    END IF;
+  END
+$$;
@@ -21,25 +21,12 @@
 #include "utils/debug.h"
 
 #include "sequence/compression.h"
+#include "sequence/decoding_map_cache.h"
 
 /*
  * local types
  */
 
-/**
- * Type for decoding map elements, so the symbol and the length
- * of the code can be stored close to each other in one data
- * structure. An actual decoding map would be an array of
- * PB_DecodingMap of size PB_DECODE_MAP_SIZE (256 if PB_PrefixCode is
- * uint8)
-  */
-typedef struct {
-	uint8 symbol;
-	uint8 code_length;
-} PB_DecodingMap;
-
-#define PB_DECODE_MAP_SIZE (1 << PB_PREFIX_CODE_BIT_SIZE)
-
 /*
  * Type for encoding map elements, so the code and its length
  * can be stored close to each other in one data structure.
@@ -58,7 +45,6 @@ typedef struct {
  */
 
 static PB_EncodingMap* get_encoding_map(const PB_CodeSet* codeset, int mode);
-static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode);
 
 static void encode_pc(uint8* input,
 					  PB_CompressedSequence* output,
@@ -90,24 +76,28 @@ static void decode_pc_idx(Varlena* input,
 						  uint32 start_position,
 						  uint32 output_length,
 						  PB_IndexEntry* start_entry,
+						  uint32 part_size,
 						  PB_CodeSet* codeset);
 static void decode_pc_rle_idx(Varlena* input,
 							  uint8* output,
 							  uint32 start_position,
 							  uint32 output_length,
 							  PB_IndexEntry* start_entry,
+							  uint32 part_size,
 							  PB_CodeSet* codeset);
 static void decode_pc_swp_idx(Varlena* input,
 							  uint8* output,
 							  uint32 start_position,
 							  uint32 output_length,
 							  PB_IndexEntry* start_entry,
+							  uint32 part_size,
 							  PB_CodeSet* codeset);
 static void decode_pc_swp_rle_idx(Varlena* input,
 								  uint8* output,
 								  uint32 start_position,
 								  uint32 output_length,
 								  PB_IndexEntry* start_entry,
+								  uint32 part_size,
 								  PB_CodeSet* codeset);
 
 
@@ -241,8 +231,6 @@ static void decode_pc_swp_rle_idx(Varlena* input,
 /*
  * local functions
  */
-#define PB_NO_SWAP_MAP		0
-#define PB_SWAP_MAP			1
 
 /**
  * get_encoding_map()
@@ -307,48 +295,6 @@ static PB_EncodingMap* get_encoding_map(const PB_CodeSet* codeset, int mode)
 	return map;
 }
 
-/**
- * get_decoding_map()
- * 		Creates a decoding map for a prefix code set.
- */
- static PB_DecodingMap* get_decoding_map(const PB_CodeSet* codeset, int mode)
- {
-	PB_DecodingMap* map;
-	int i,j;
-	int from = 0;
-	int to = 0;
-
-	if (mode == PB_NO_SWAP_MAP)
-	{
-		from = 0;
-		to = codeset->n_symbols - codeset->n_swapped_symbols;
-	}
-	else if (mode == PB_SWAP_MAP)
-	{
-		from = codeset->n_symbols - codeset->n_swapped_symbols;
-		to = codeset->n_symbols;
-	}
-
-	map = (PB_DecodingMap*) palloc(PB_DECODE_MAP_SIZE * sizeof(PB_DecodingMap));
-	memset(map, 0xFF, PB_DECODE_MAP_SIZE * sizeof(PB_DecodingMap));
-
-	for (i = from; i < to; i++)
-	{
-		const int lower_bound = codeset->words[i].code;
-		const int upper_bound = lower_bound + (1 << (PB_PREFIX_CODE_BIT_SIZE - codeset->words[i].code_length));
-
-		for (j = lower_bound; j < upper_bound; j++)
-		{
-			map[j].symbol = codeset->words[i].symbol;
-			map[j].code_length = codeset->words[i].code_length;
-		}
-
-		PB_DEBUG2(errmsg("get_decoding_map(): i:%d lower_bound:%u upper_bound:%u symbol:%c code:%u length:%u/%ld",i,lower_bound,upper_bound,codeset->words[i].symbol,codeset->words[i].code,codeset->words[i].code_length, PB_PREFIX_CODE_BIT_SIZE));
-	}
-
-	return map;
-}
-
 /**
  * encode_pc()
  * 		Performs simple prefix code encoding.
@@ -428,7 +374,8 @@ static void encode_pc_idx(uint8* input,
 	PB_CompressionBuffer buffer = 0;
 	int bits_free = PB_COMPRESSION_BUFFER_BIT_SIZE;
 	int i = output->sequence_length - 1;
-	int index_counter = PB_INDEX_PART_SIZE - 1;
+	const int part_size = PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(output);
+	int index_counter = part_size - 1;
 
 	uint8* input_pointer = input;
 	PB_CompressionBuffer* stream_start = PB_COMPRESSED_SEQUENCE_STREAM_POINTER(output);
@@ -446,7 +393,7 @@ static void encode_pc_idx(uint8* input,
 		index_counter--;
 		if (index_counter < 0)
 		{
-			index_counter += PB_INDEX_PART_SIZE;
+			index_counter += part_size;
 			if (bits_free > 0)
 			{
 				index_pointer->bit = PB_COMPRESSION_BUFFER_BIT_SIZE - bits_free;
@@ -630,7 +577,8 @@ static void encode_pc_rle_idx(uint8* input,
 	PB_CompressionBuffer buffer = 0;
 	int bits_free = PB_COMPRESSION_BUFFER_BIT_SIZE;
 	int i = output->sequence_length - 1;
-	int index_counter = PB_INDEX_PART_SIZE - 1;
+	const int part_size = PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(output);
+	int index_counter = part_size - 1;
 	int repeated_chars = 0;
 
 	uint8 recent = 0;
@@ -675,7 +623,7 @@ static void encode_pc_rle_idx(uint8* input,
 					index_counter--;
 					if (index_counter < 0)
 					{
-						index_counter += PB_INDEX_PART_SIZE;
+						index_counter += part_size;
 						if (bits_free > 0)
 						{
 							index_pointer->bit = PB_COMPRESSION_BUFFER_BIT_SIZE - bits_free;
@@ -730,7 +678,7 @@ static void encode_pc_rle_idx(uint8* input,
 						index_pointer->block = (output_pointer + 1)- stream_start;
 					}
 					index_pointer->rle_shift = (uint16) index_counter;
-					index_counter += PB_INDEX_PART_SIZE;
+					index_counter += part_size;
 					PB_DEBUG3(errmsg("IDX block:%u bit:%d", index_pointer->block, index_pointer->bit));
 					index_pointer++;
 				}
@@ -933,7 +881,8 @@ static void encode_pc_swp_idx(uint8* input,
 	int bits_free = PB_COMPRESSION_BUFFER_BIT_SIZE;
 	int i = output->sequence_length - 1;
 	int swap_counter = PB_MAX_SWAP_RUN_LENGTH;
-	int index_counter = PB_INDEX_PART_SIZE - 1;
+	const int part_size = PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(output);
+	int index_counter = part_size - 1;
 
 	uint8* input_pointer = input;
 	PB_CompressionBuffer* stream_start = PB_COMPRESSED_SEQUENCE_STREAM_POINTER(output);
@@ -960,7 +909,7 @@ static void encode_pc_swp_idx(uint8* input,
 		index_counter--;
 		if (index_counter < 0)
 		{
-			index_counter += PB_INDEX_PART_SIZE;
+			index_counter += part_size;
 			if (bits_free > 0)
 			{
 				index_pointer->bit = PB_COMPRESSION_BUFFER_BIT_SIZE - bits_free;
@@ -1443,7 +1392,8 @@ static void encode_pc_swp_rle_idx(uint8* input,
 	PB_CompressionBuffer* swap_pointer;
 	int swap_bits;
 
-	int index_counter = PB_INDEX_PART_SIZE - 1;
+	const int part_size = PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(output);
+	int index_counter = part_size - 1;
 	PB_IndexEntry* index_pointer = PB_COMPRESSED_SEQUENCE_INDEX_POINTER(output);
 	int n_swap_index_pointers = 0;
 
@@ -1496,7 +1446,7 @@ static void encode_pc_swp_rle_idx(uint8* input,
 						index_counter--;
 						if (index_counter < 0)
 						{
-							index_counter += PB_INDEX_PART_SIZE;
+							index_counter += part_size;
 							if (bits_free > 0)
 							{
 								index_pointer->bit = PB_COMPRESSION_BUFFER_BIT_SIZE - bits_free;;
@@ -1532,7 +1482,7 @@ static void encode_pc_swp_rle_idx(uint8* input,
 						index_counter--;
 						if (index_counter < 0)
 						{
-							index_counter += PB_INDEX_PART_SIZE;
+							index_counter += part_size;
 							if (bits_free > 0)
 							{
 								index_pointer->bit = PB_COMPRESSION_BUFFER_BIT_SIZE - bits_free;;
@@ -1613,7 +1563,7 @@ static void encode_pc_swp_rle_idx(uint8* input,
 					index_pointer->swap_shift = swap_counter;
 					n_swap_index_pointers++;
 					index_pointer++;
-					index_counter += PB_INDEX_PART_SIZE;
+					index_counter += part_size;
 				}
 				index_counter -= repeated_chars;
 
@@ -1843,6 +1793,7 @@ static void decode_pc_idx(Varlena* input,
 						  uint32 start_position,
 						  uint32 output_length,
 						  PB_IndexEntry* start_entry,
+						  uint32 part_size,
 						  PB_CodeSet* codeset)
 {
 	PB_CompressionBuffer buffer;
@@ -1854,12 +1805,22 @@ static void decode_pc_idx(Varlena* input,
 
 	Varlena* input_slice;
 	PB_CompressionBuffer* input_pointer;
+	PB_CompressionBuffer* input_end;
 	uint8* output_pointer = output;
 
-	PB_DecodingMap* map = get_decoding_map(codeset, PB_NO_SWAP_MAP);
+	const PB_DecodingMap* map;
+	const PB_DecodingMap* swap_map;
+	const PB_MultiDecodingMap* multi_map;
+	const PB_ByteDecodingMap* byte_map;
 
 	PB_TRACE(errmsg("->decode_pc_idx()"));
 
+	get_decoding_maps(codeset, &map, &swap_map);
+	multi_map = PB_USE_MULTI_DECODING_MAP(codeset, output_length) ?
+				get_multi_decoding_map(codeset) : NULL;
+	byte_map = PB_USE_BYTE_DECODING_MAP(codeset) ?
+			   get_byte_decoding_map(codeset) : NULL;
+
 	/*
 	 * Calculate the offset of the stream in the compressed data.
 	 */
@@ -1880,9 +1841,9 @@ static void decode_pc_idx(Varlena* input,
 		 *  -> exact slice, that contains the desired sequence can be computed
 		 */
 		int code_length = codeset->words[0].code_length;
-		int64 bits_to_skip = start_position * code_length;
+		int64 bits_to_skip = (int64) start_position * code_length;
 		int64 slice_start = bits_to_skip / PB_COMPRESSION_BUFFER_BIT_SIZE;
-		int64 slice_size = (bits_to_skip + output_length * code_length)
+		int64 slice_size = (bits_to_skip + (int64) output_length * code_length)
 								/ PB_COMPRESSION_BUFFER_BIT_SIZE + 1 - slice_start;
 
 		slice_start *= PB_COMPRESSION_BUFFER_BYTE_SIZE;
@@ -1946,8 +1907,9 @@ static void decode_pc_idx(Varlena* input,
 			 */
 			int slice_start = stream_offset +
 							  start_entry->block * PB_COMPRESSION_BUFFER_BYTE_SIZE;
-			int slice_size = (output_length + (start_position % PB_INDEX_PART_SIZE)) *
-							 max_codeword_length /
+			int slice_size = (start_entry->bit +
+							  (output_length + (start_position % part_size)) *
+							  max_codeword_length) /
 							 PB_COMPRESSION_BUFFER_BIT_SIZE + 1;
 			slice_size *= PB_COMPRESSION_BUFFER_BYTE_SIZE;
 
@@ -1968,7 +1930,7 @@ static void decode_pc_idx(Varlena* input,
 			bits_in_buffer = PB_COMPRESSION_BUFFER_BIT_SIZE - start_entry->bit;
 			buffer = *(input_pointer) << start_entry->bit;
 			input_pointer++;
-			i = ((start_position + 1) % PB_INDEX_PART_SIZE) - 1;
+			i = ((start_position + 1) % part_size) - 1;
 		}
 
 		PB_DEBUG1(errmsg("decode_pc_idx(): reading %d chars to skip", i + 1));
@@ -1987,6 +1949,102 @@ static void decode_pc_idx(Varlena* input,
 
 	PB_DEBUG1(errmsg("decode_pc_idx(): decoding %d chars",i));
 
+	input_end = ((PB_CompressionBuffer*) VARDATA_ANY(input_slice)) +
+				VARSIZE_ANY_EXHDR(input_slice) / PB_COMPRESSION_BUFFER_BYTE_SIZE;
+
+	/*
+	 * Codes of equal length, that divide a byte, are unpacked a byte
+	 * at a time. Once the buffer is empty, whole words are unpacked
+	 * directly from the stream. Every byte writes
+	 * PB_BYTE_DECODE_MAX_SYMBOLS symbols, so the output must have room
+	 * for them.
+	 */
+	if (byte_map != NULL)
+	{
+		const int code_length = codeset->words[0].code_length;
+		const int symbols_per_byte = 8 / code_length;
+		const int symbols_per_word = PB_COMPRESSION_BUFFER_BIT_SIZE / code_length;
+
+		while (i >= 0 && bits_in_buffer % 8 != 0)
+		{
+			PB_PrefixCode val;
+			int length;
+
+			DECODE(input_pointer, buffer, bits_in_buffer, val, length, map);
+			*output_pointer = map[val].symbol;
+			output_pointer++;
+			i--;
+		}
+
+		while (i >= PB_BYTE_DECODE_MAX_SYMBOLS - 1 && bits_in_buffer >= 8)
+		{
+			memcpy(output_pointer,
+				   byte_map[buffer >> (PB_COMPRESSION_BUFFER_BIT_SIZE - 8)].symbols,
+				   PB_BYTE_DECODE_MAX_SYMBOLS);
+			output_pointer += symbols_per_byte;
+			i -= symbols_per_byte;
+			buffer = buffer << 8;
+			bits_in_buffer -= 8;
+		}
+
+		if (bits_in_buffer == 0)
+		{
+			while (i >= symbols_per_word + PB_BYTE_DECODE_MAX_SYMBOLS - 1)
+			{
+				const PB_CompressionBuffer word = *input_pointer;
+				int shift;
+
+				for (shift = PB_COMPRESSION_BUFFER_BIT_SIZE - 8; shift >= 0; shift -= 8)
+				{
+					memcpy(output_pointer,
+						   byte_map[(uint8) (word >> shift)].symbols,
+						   PB_BYTE_DECODE_MAX_SYMBOLS);
+					output_pointer += symbols_per_byte;
+				}
+
+				input_pointer++;
+				i -= symbols_per_word;
+			}
+
+			buffer = 0;
+		}
+
+		PB_DEBUG1(errmsg("decode_pc_idx(): unpacked bytes, %d chars left", i + 1));
+	}
+
+	/*
+	 * Decode several symbols per lookup, as long as the output has room
+	 * for the largest element of the multi symbol map.
+	 */
+	while (multi_map != NULL && i >= PB_MULTI_DECODE_MAX_SYMBOLS - 1)
+	{
+		const PB_MultiDecodingMap* element;
+		int n_symbols;
+		int peek;
+
+		PEEK_MULTI(input_pointer, input_end, buffer, bits_in_buffer, peek);
+		element = &multi_map[peek];
+		n_symbols = PB_MULTI_DECODE_N_SYMBOLS(*element);
+
+		if (n_symbols > 0)
+		{
+			SKIP_BITS(input_pointer, buffer, bits_in_buffer, element->n_bits);
+			memcpy(output_pointer, element->symbols, PB_MULTI_DECODE_MAX_SYMBOLS);
+			output_pointer += n_symbols;
+			i -= n_symbols;
+		}
+		else
+		{
+			PB_PrefixCode code;
+			int length;
+
+			DECODE(input_pointer, buffer, bits_in_buffer, code, length, map);
+			*output_pointer = map[code].symbol;
+			output_pointer++;
+			i--;
+		}
+	}
+
 	while (i >= 0)
 	{
 		PB_PrefixCode val;
@@ -2000,7 +2058,6 @@ static void decode_pc_idx(Varlena* input,
 		i--;
 	}
 
-	pfree(map);
 	pfree(input_slice);
 
 	PB_TRACE(errmsg("<-decode_pc_idx()"));
@@ -2016,6 +2073,7 @@ static void decode_pc_rle_idx(Varlena* input,
 							  uint32 start_position,
 							  uint32 output_length,
 							  PB_IndexEntry* start_entry,
+							  uint32 part_size,
 							  PB_CodeSet* codeset)
 {
 	PB_CompressionBuffer buffer;
@@ -2029,13 +2087,16 @@ static void decode_pc_rle_idx(Varlena* input,
 	PB_CompressionBuffer* input_pointer;
 	uint8* output_pointer = output;
 
-	PB_DecodingMap* map = get_decoding_map(codeset, PB_NO_SWAP_MAP);
+	const PB_DecodingMap* map;
+	const PB_DecodingMap* swap_map;
 
 	const int max_codeword_length = codeset->words[codeset->n_symbols - 1].code_length;
 	const int raw_size = toast_raw_datum_size((Datum)input);
 
 	PB_TRACE(errmsg("->decode_pc_rle_idx()"));
 
+	get_decoding_maps(codeset, &map, &swap_map);
+
 	/*
 	 * Calculate the offset of the stream in the compressed data.
 	 */
@@ -2085,8 +2146,9 @@ static void decode_pc_rle_idx(Varlena* input,
 		 */
 		int slice_start = stream_offset +
 						  start_entry->block * PB_COMPRESSION_BUFFER_BYTE_SIZE;
-		int slice_size = ((output_length + (start_position % PB_INDEX_PART_SIZE) + 1) *
-						 max_codeword_length  + 8) /
+		int slice_size = (start_entry->bit +
+						  (output_length + (start_position % part_size) + 1) *
+						  max_codeword_length  + 8) /
 						 PB_COMPRESSION_BUFFER_BIT_SIZE + 1;
 		slice_size *= PB_COMPRESSION_BUFFER_BYTE_SIZE;
 
@@ -2107,7 +2169,7 @@ static void decode_pc_rle_idx(Varlena* input,
 		bits_in_buffer = PB_COMPRESSION_BUFFER_BIT_SIZE - start_entry->bit;
 		buffer = *(input_pointer) << start_entry->bit;
 		input_pointer++;
-		i = ((start_position + 1) % PB_INDEX_PART_SIZE) - 1 + start_entry->rle_shift;
+		i = ((start_position + 1) % part_size) - 1 + start_entry->rle_shift;
 	}
 
 	PB_DEBUG1(errmsg("decode_pc_rle_idx(): reading %d chars to skip", i + 1));
@@ -2202,7 +2264,6 @@ static void decode_pc_rle_idx(Varlena* input,
 		}
 	}
 
-	pfree(map);
 	pfree(input_slice);
 
 	PB_TRACE(errmsg("<-decode_pc_rle_idx()"));
@@ -2218,6 +2279,7 @@ static void decode_pc_swp_idx(Varlena* input,
 							  uint32 start_position,
 							  uint32 output_length,
 							  PB_IndexEntry* start_entry,
+							  uint32 part_size,
 							  PB_CodeSet* codeset)
 {
 	PB_CompressionBuffer buffer;
@@ -2230,10 +2292,12 @@ static void decode_pc_swp_idx(Varlena* input,
 
 	Varlena* input_slice;
 	PB_CompressionBuffer* input_pointer;
+	PB_CompressionBuffer* input_end;
 	uint8* output_pointer = output;
 
-	PB_DecodingMap* map = get_decoding_map(codeset, PB_NO_SWAP_MAP);
-	PB_DecodingMap* swap_map = get_decoding_map(codeset, PB_SWAP_MAP);
+	const PB_DecodingMap* map;
+	const PB_DecodingMap* swap_map;
+	const PB_MultiDecodingMap* multi_map;
 
 	const uint8 master_symbol = codeset->words[codeset->n_symbols - codeset->n_swapped_symbols].symbol;
 
@@ -2244,6 +2308,10 @@ static void decode_pc_swp_idx(Varlena* input,
 
 	PB_TRACE(errmsg("->decode_pc_swp_idx()"));
 
+	get_decoding_maps(codeset, &map, &swap_map);
+	multi_map = PB_USE_MULTI_DECODING_MAP(codeset, output_length) ?
+				get_multi_decoding_map(codeset) : NULL;
+
 	/*
 	 * Calculate the offset of the stream in the compressed data.
 	 */
@@ -2297,8 +2365,9 @@ static void decode_pc_swp_idx(Varlena* input,
 		 */
 		int slice_start = stream_offset +
 						  start_entry->block * PB_COMPRESSION_BUFFER_BYTE_SIZE;
-		int slice_size = (output_length + (start_position % PB_INDEX_PART_SIZE)) *
-						 max_codeword_length /
+		int slice_size = (start_entry->bit +
+						  (output_length + (start_position % part_size)) *
+						  max_codeword_length) /
 						 PB_COMPRESSION_BUFFER_BIT_SIZE + 1;
 		slice_size *= PB_COMPRESSION_BUFFER_BYTE_SIZE;
 
@@ -2319,7 +2388,7 @@ static void decode_pc_swp_idx(Varlena* input,
 		bits_in_buffer = PB_COMPRESSION_BUFFER_BIT_SIZE - start_entry->bit;
 		buffer = *(input_pointer) << start_entry->bit;
 		input_pointer++;
-		i = ((start_position + 1) % PB_INDEX_PART_SIZE) - 1;
+		i = ((start_position + 1) % part_size) - 1;
 		swap_counter = start_entry->swap_shift;
 	}
 
@@ -2350,11 +2419,40 @@ static void decode_pc_swp_idx(Varlena* input,
 
 	PB_DEBUG1(errmsg("decode_pc_swp_idx(): reading %d chars, swap_counter = %d, bib=%d", i + 1, swap_counter, bits_in_buffer));
 
+	input_end = ((PB_CompressionBuffer*) VARDATA_ANY(input_slice)) +
+				VARSIZE_ANY_EXHDR(input_slice) / PB_COMPRESSION_BUFFER_BYTE_SIZE;
+
 	while (i >= 0)
 	{
 		PB_PrefixCode val;
 		int length;
 
+		/*
+		 * Decode several symbols per lookup, if the output has room for the
+		 * largest element of the multi symbol map and none of the master
+		 * symbols in the element starts a swapped symbol.
+		 */
+		if (multi_map != NULL && i >= PB_MULTI_DECODE_MAX_SYMBOLS - 1)
+		{
+			const PB_MultiDecodingMap* element;
+			int n_symbols;
+			int peek;
+
+			PEEK_MULTI(input_pointer, input_end, buffer, bits_in_buffer, peek);
+			element = &multi_map[peek];
+			n_symbols = PB_MULTI_DECODE_N_SYMBOLS(*element);
+
+			if (n_symbols > 0 && swap_counter >= PB_MULTI_DECODE_N_MASTER(*element))
+			{
+				SKIP_BITS(input_pointer, buffer, bits_in_buffer, element->n_bits);
+				memcpy(output_pointer, element->symbols, PB_MULTI_DECODE_MAX_SYMBOLS);
+				output_pointer += n_symbols;
+				i -= n_symbols;
+				swap_counter -= PB_MULTI_DECODE_N_MASTER(*element);
+				continue;
+			}
+		}
+
 		DECODE(input_pointer, buffer, bits_in_buffer, val, length, map);
 		if (map[val].symbol != master_symbol)
 		{
@@ -2388,8 +2486,6 @@ static void decode_pc_swp_idx(Varlena* input,
 		}
 	}
 
-	pfree(map);
-	pfree(swap_map);
 	pfree(input_slice);
 
 	PB_TRACE(errmsg("<-decode_pc_swp_idx()"));
@@ -2405,6 +2501,7 @@ static void decode_pc_swp_rle_idx(Varlena* input,
 								  uint32 start_position,
 								  uint32 output_length,
 								  PB_IndexEntry* start_entry,
+								  uint32 part_size,
 								  PB_CodeSet* codeset)
 {
 	PB_CompressionBuffer buffer;
@@ -2419,8 +2516,8 @@ static void decode_pc_swp_rle_idx(Varlena* input,
 	PB_CompressionBuffer* input_pointer;
 	uint8* output_pointer = output;
 
-	PB_DecodingMap* map = get_decoding_map(codeset, PB_NO_SWAP_MAP);
-	PB_DecodingMap* swap_map = get_decoding_map(codeset, PB_SWAP_MAP);
+	const PB_DecodingMap* map;
+	const PB_DecodingMap* swap_map;
 
 	const uint8 master_symbol = codeset->words[codeset->n_symbols - codeset->n_swapped_symbols].symbol;
 	const int max_codeword_length = codeset->words[codeset->n_symbols - 1].code_length +
@@ -2430,6 +2527,8 @@ static void decode_pc_swp_rle_idx(Varlena* input,
 
 	PB_TRACE(errmsg("->decode_pc_swp_rle_idx(%u,%u)", start_position, output_length));
 
+	get_decoding_maps(codeset, &map, &swap_map);
+
 	/*
 	 * Calculate the offset of the stream in the compressed data.
 	 */
@@ -2485,8 +2584,9 @@ static void decode_pc_swp_rle_idx(Varlena* input,
 		 */
 		int slice_start = stream_offset +
 						  start_entry->block * PB_COMPRESSION_BUFFER_BYTE_SIZE;
-		int slice_size = (output_length + (start_position % PB_INDEX_PART_SIZE)) *
-						 max_codeword_length /
+		int slice_size = (start_entry->bit +
+						  (output_length + (start_position % part_size)) *
+						  max_codeword_length) /
 						 PB_COMPRESSION_BUFFER_BIT_SIZE + 1;
 		slice_size *= PB_COMPRESSION_BUFFER_BYTE_SIZE;
 
@@ -2507,7 +2607,7 @@ static void decode_pc_swp_rle_idx(Varlena* input,
 		bits_in_buffer = PB_COMPRESSION_BUFFER_BIT_SIZE - start_entry->bit;
 		buffer = *(input_pointer) << start_entry->bit;
 		input_pointer++;
-		i = ((start_position + 1) % PB_INDEX_PART_SIZE) - 1 + start_entry->rle_shift;
+		i = ((start_position + 1) % part_size) - 1 + start_entry->rle_shift;
 		swap_counter = start_entry->swap_shift;
 	}
 
@@ -2678,9 +2778,6 @@ static void decode_pc_swp_rle_idx(Varlena* input,
 		}
 	}
 
-	pfree((PB_DecodingMap*) map);
-	pfree((PB_DecodingMap*) swap_map);
-
 	PB_TRACE(errmsg("<-decode_pc_swp_rle_idx()"))
 }
 
@@ -2760,10 +2857,7 @@ uint32 get_compressed_size(const PB_SequenceInfo* info,
 
 	total_stream_size_bits = PB_ALIGN_BIT_SIZE(total_stream_size_bits);
 
-	total_size = sizeof(PB_CompressedSequence);
-	total_size += codeset->is_fixed ? 0 : sizeof(PB_Codeword) * codeset->n_symbols;
-	total_size += codeset->has_equal_length ? 0 : info->sequence_length / PB_INDEX_PART_SIZE * sizeof(PB_IndexEntry);
-	total_size = PB_ALIGN_BYTE_SIZE(total_size);
+	total_size = get_stream_offset(info->sequence_length, codeset, info->with_composition, info->index_shift);
 	total_size +=  total_stream_size_bits / 8;
 
 	PB_DEBUG1(errmsg("get_compressed_stream_size(): totalsize in byte:%u (%lu bits)", total_size, total_stream_size_bits));
@@ -2774,6 +2868,172 @@ uint32 get_compressed_size(const PB_SequenceInfo* info,
 }
 
 
+/**
+ * get_stream_offset()
+ * 		Returns the offset of the stream of a sequence compressed with a
+ * 		code set.
+ *
+ * 	uint32 sequence_length : length of the sequence
+ * 	const PB_CodeSet* codeset : code used for compression
+ * 	bool with_composition : whether the composition is stored
+ * 	uint8 index_shift : density of the index
+ */
+uint32 get_stream_offset(uint32 sequence_length,
+						 const PB_CodeSet* codeset,
+						 bool with_composition,
+						 uint8 index_shift)
+{
+	const int n_summary_symbols = PB_SUMMARY_N_SYMBOLS(codeset, with_composition);
+	uint32 offset = sizeof(PB_CompressedSequence);
+
+	offset += codeset->is_fixed ? 0 : sizeof(PB_Codeword) * codeset->n_symbols;
+	offset += with_composition ? sizeof(uint32) * n_summary_symbols : 0;
+	offset += codeset->has_equal_length ? 0 : sequence_length / PB_INDEX_PART_SIZE_OF(index_shift) * sizeof(PB_IndexEntry);
+	offset += PB_SUMMARY_SIZE(sequence_length, n_summary_symbols);
+
+	return PB_ALIGN_BYTE_SIZE(offset);
+}
+
+/**
+ * get_index_shift()
+ * 		Parses an index density type modifier, which is the number of
+ * 		characters per index part, given as a number or as "index=<n>".
+ * 		Returns the index shift or (-1), if the type modifier is not an
+ * 		index density.
+ *
+ * 	const char* modifier : type modifier
+ */
+int get_index_shift(const char* modifier)
+{
+	const char* number = modifier;
+	char* end;
+	long part_size;
+	int shift;
+
+	if (!strncmp(number, "index=", 6))
+		number += 6;
+
+	if (*number < '0' || *number > '9')
+		return (-1);
+
+	part_size = strtol(number, &end, 10);
+	if (*end == '\0')
+	{
+		for (shift = 0; shift <= PB_MAX_INDEX_SHIFT; shift++)
+			if (PB_INDEX_PART_SIZE_OF(shift) == part_size)
+				return shift;
+	}
+
+	ereport(ERROR,(errmsg("type modifier invalid"),
+			errdetail("Index density \"%s\" is not a power of two between %d and %d.",
+					  number, PB_INDEX_PART_SIZE_OF(PB_MAX_INDEX_SHIFT), PB_INDEX_PART_SIZE)));
+
+	return (-1);
+}
+
+/**
+ * get_summary_word_map()
+ * 		Maps every symbol to the index of the codeword, that encodes it.
+ *
+ * 	const PB_CodeSet* codeset : code used for compression
+ * 	bool ignore_case : whether lower case symbols are encoded as upper case
+ * 	int16* words : output, PB_SOURCE_ALPHABET_SIZE elements
+ */
+void get_summary_word_map(const PB_CodeSet* codeset, bool ignore_case, int16* words)
+{
+	int i;
+
+	memset(words, 0xFF, PB_SOURCE_ALPHABET_SIZE * sizeof(int16));
+
+	/*
+	 * The first codeword of a symbol wins, swapped codewords
+	 * repeat symbols of the code.
+	 */
+	for (i = codeset->n_symbols - 1; i >= 0; i--)
+		words[codeset->words[i].symbol] = i;
+
+	if (ignore_case)
+		for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+			if (words[i] < 0)
+				words[i] = words[TO_UPPER(i)];
+}
+
+/**
+ * write_summary()
+ * 		Counts the codewords of a sequence and stores the cumulative
+ * 		counts of every PB_INDEX_PART_SIZE symbols as composition summary
+ * 		and the total counts as composition, if it is included. The
+ * 		number of summary symbols must have been set in the output.
+ *
+ * 	uint8* input : input sequence, not null-terminated
+ * 	PB_CompressedSequence* output : compressed sequence
+ * 	PB_CodeSet* codeset : code used for compression
+ * 	bool ignore_case : whether lower case symbols are encoded as upper case
+ */
+static void write_summary(uint8* input,
+						  PB_CompressedSequence* output,
+						  PB_CodeSet* codeset,
+						  bool ignore_case)
+{
+	const uint32 n_parts = output->sequence_length / PB_INDEX_PART_SIZE;
+	const int n_words = output->n_summary_symbols;
+	uint32 symbol_counts[PB_SOURCE_ALPHABET_SIZE];
+	uint32 word_counts[PB_SOURCE_ALPHABET_SIZE];
+	int16 words[PB_SOURCE_ALPHABET_SIZE];
+	uint8* summary = ((uint8*) output) + PB_COMPRESSED_SEQUENCE_SUMMARY_OFFSET(output);
+	uint8* input_pointer = input;
+	uint8* input_end = input + output->sequence_length;
+	uint32 part;
+	int i;
+
+	if (n_words == 0)
+		return;
+
+	PB_TRACE(errmsg("->write_summary(): %u parts, %d symbols", n_parts, n_words));
+
+	get_summary_word_map(codeset, ignore_case, words);
+	memset(symbol_counts, 0, sizeof(symbol_counts));
+
+	for (part = 0; part < n_parts; part++)
+	{
+		uint8* part_end = input_pointer + PB_INDEX_PART_SIZE;
+
+		while (input_pointer < part_end)
+		{
+			symbol_counts[*input_pointer]++;
+			input_pointer++;
+		}
+
+		memset(word_counts, 0, sizeof(word_counts));
+		for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+			if (symbol_counts[i] > 0 && words[i] >= 0)
+				word_counts[words[i]] += symbol_counts[i];
+
+		memcpy(summary, word_counts, n_words * sizeof(uint32));
+		summary += n_words * sizeof(uint32);
+	}
+
+	if (output->has_composition)
+	{
+		while (input_pointer < input_end)
+		{
+			symbol_counts[*input_pointer]++;
+			input_pointer++;
+		}
+
+		memset(word_counts, 0, sizeof(word_counts));
+		for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+			if (symbol_counts[i] > 0 && words[i] >= 0)
+				word_counts[words[i]] += symbol_counts[i];
+
+		memcpy(((uint8*) output) + PB_COMPRESSED_SEQUENCE_COMPOSITION_OFFSET(output),
+			   word_counts,
+			   n_words * sizeof(uint32));
+	}
+
+	PB_TRACE(errmsg("<-write_summary()"));
+}
+
 /**
  * encode()
  * 		Encode a sequence.
@@ -2823,11 +3083,17 @@ PB_CompressedSequence* encode(uint8* input,
 	result->has_equal_length = codeset->has_equal_length;
 	result->uses_rle = codeset->uses_rle;
 
-	if (codeset->has_equal_length || info->sequence_length < PB_INDEX_PART_SIZE)
+	result->index_shift = info->index_shift;
+	if (codeset->has_equal_length ||
+		info->sequence_length < PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(result))
 		result->has_index = false;
 	else
 		result->has_index = true;
 
+	result->has_composition = info->with_composition;
+	result->n_summary_symbols = PB_SUMMARY_N_SYMBOLS(codeset, info->with_composition);
+	write_summary(input, result, codeset, codeset->ignore_case);
+
 	/*
 	 * Choose the encoding function
 	 */
@@ -2871,6 +3137,106 @@ PB_CompressedSequence* encode(uint8* input,
 	return result;
 }
 
+/**
+ * encode_fixed()
+ * 		Encode a sequence with a fixed code set of equal length codes in
+ * 		a single pass, validating every symbol against the code set.
+ * 		Returns NULL if the code set can not express the sequence.
+ *
+ * 	Since all codes have equal length, the compressed size is known in
+ * 	advance and no sequence info is needed.
+ *
+ * 	uint8* input : input sequence, not null-terminated
+ * 	uint32 length : length of the input sequence
+ * 	PB_CodeSet* codeset : fixed codeset with codes of equal length
+ * 	bool ignore_case : whether lower case symbols are encoded as upper case
+ * 	bool with_composition : whether the composition is stored
+ * 	uint8 index_shift : density of the index, see PB_INDEX_PART_SIZE_OF()
+ */
+PB_CompressedSequence* encode_fixed(uint8* input,
+									uint32 length,
+									PB_CodeSet* codeset,
+									bool ignore_case,
+									bool with_composition,
+									uint8 index_shift)
+{
+	PB_CompressedSequence* result;
+	uint32 compressed_size;
+	uint64 stream_size_bits;
+
+	int16 codes[PB_SOURCE_ALPHABET_SIZE];
+	const int code_length = codeset->words[0].code_length;
+
+	PB_CompressionBuffer buffer = 0;
+	int bits_free = PB_COMPRESSION_BUFFER_BIT_SIZE;
+	PB_CompressionBuffer* output_pointer;
+	uint8* input_pointer = input;
+	uint8* input_end = input + length;
+	int i;
+
+	PB_TRACE(errmsg("->encode_fixed(): fixed code id:%d, length:%u", codeset->fixed_id, length));
+
+	/*
+	 * Symbols, that are not part of the code set, map to -1.
+	 */
+	memset(codes, 0xFF, sizeof(codes));
+	for (i = 0; i < codeset->n_symbols; i++)
+	{
+		const int symbol = codeset->words[i].symbol;
+		const int16 code = codeset->words[i].code >> (PB_PREFIX_CODE_BIT_SIZE - code_length);
+
+		codes[symbol] = code;
+		if (ignore_case && codeset->ignore_case)
+			codes[TO_LOWER(symbol)] = code;
+	}
+
+	stream_size_bits = ((uint64) length) * code_length;
+	stream_size_bits = PB_ALIGN_BIT_SIZE(stream_size_bits);
+
+	compressed_size = get_stream_offset(length, codeset, with_composition, index_shift);
+	compressed_size += stream_size_bits / 8;
+
+	result = palloc0(compressed_size);
+	SET_VARSIZE(result, compressed_size);
+	result->sequence_length = length;
+	result->is_fixed = true;
+	result->n_symbols = 0;
+	result->n_swapped_symbols = codeset->fixed_id;
+	result->has_equal_length = true;
+	result->uses_rle = false;
+	result->has_index = false;
+	result->has_composition = with_composition;
+	result->index_shift = index_shift;
+	result->n_summary_symbols = PB_SUMMARY_N_SYMBOLS(codeset, with_composition);
+
+	output_pointer = PB_COMPRESSED_SEQUENCE_STREAM_POINTER(result);
+
+	while (input_pointer < input_end)
+	{
+		const int16 code = codes[*input_pointer];
+
+		if (code < 0)
+		{
+			PB_DEBUG1(errmsg("encode_fixed(): symbol %d at position %ld not in code set",
+							 *input_pointer, (long) (input_pointer - input)));
+			pfree(result);
+			return NULL;
+		}
+
+		ENCODE(code, code_length, buffer, bits_free, output_pointer);
+		input_pointer++;
+	}
+
+	if (bits_free < PB_COMPRESSION_BUFFER_BIT_SIZE)
+		*output_pointer = (buffer << bits_free);
+
+	write_summary(input, result, codeset, ignore_case && codeset->ignore_case);
+
+	PB_TRACE(errmsg("<-encode_fixed()"));
+
+	return result;
+}
+
 /**
  * decode()
  * 		Decode a compressed sequence.
@@ -2949,12 +3315,11 @@ void decode(Varlena* input,
 	{
 		int start_entry_no;
 
-		start_entry_no = (start_position + 1) / PB_INDEX_PART_SIZE - 1;
+		start_entry_no = (start_position + 1) / PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(input_header) - 1;
 		if (start_entry_no >= 0)
 		{
 			Varlena* data_slice = (Varlena*) PG_DETOAST_DATUM_SLICE(input,
-													  sizeof(PB_CompressedSequence) - VARHDRSZ +
-													  sizeof(PB_Codeword) * input_header->n_symbols +
+													  PB_COMPRESSED_SEQUENCE_INDEX_OFFSET(input_header) - VARHDRSZ +
 													  sizeof(PB_IndexEntry) * start_entry_no,
 													  sizeof(PB_IndexEntry));
 
@@ -2974,6 +3339,7 @@ void decode(Varlena* input,
 								  start_position,
 								  out_length,
 								  start_entry,
+								  PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(input_header),
 								  codeset);
 		else
 			decode_pc_swp_idx(input,
@@ -2981,6 +3347,7 @@ void decode(Varlena* input,
 							  start_position,
 							  out_length,
 							  start_entry,
+							  PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(input_header),
 							  codeset);
 	}
 	else
@@ -2991,6 +3358,7 @@ void decode(Varlena* input,
 							  start_position,
 							  out_length,
 							  start_entry,
+							  PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(input_header),
 							  codeset);
 		else
 			decode_pc_idx(input,
@@ -2998,6 +3366,7 @@ void decode(Varlena* input,
 						  start_position,
 						  out_length,
 						  start_entry,
+						  PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(input_header),
 						  codeset);
 	}
 
@@ -0,0 +1,469 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   src/sequence/decoding_map_cache.c
+*
+*-------------------------------------------------------------------------
+*/
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "utils/memutils.h"
+
+#include "sequence/sequence.h"
+#include "sequence/decoding_map_cache.h"
+#include "utils/debug.h"
+
+/*
+ * local types
+ */
+
+/**
+ * A cached pair of decoding maps.
+ *
+ * Fixed code sets are static, so they are identified by their address,
+ * which is unique for every (fixed code set array, fixed_id) pair.
+ * Sequence specific code sets are identified by their codewords.
+ */
+typedef struct PB_DecodingMapCacheEntry {
+	struct PB_DecodingMapCacheEntry* next;
+	struct PB_DecodingMapCacheEntry* lru_prev;
+	struct PB_DecodingMapCacheEntry* lru_next;
+	uint32 hash;
+	const PB_CodeSet* fixed_codeset;
+	uint8 n_symbols;
+	uint8 n_swapped_symbols;
+	PB_DecodingMap map[PB_DECODE_MAP_SIZE];
+	PB_DecodingMap swap_map[PB_DECODE_MAP_SIZE];
+	PB_MultiDecodingMap* multi_map;
+	PB_ByteDecodingMap* byte_map;
+	PB_Codeword words[];
+} PB_DecodingMapCacheEntry;
+
+/**
+ * Number of hash buckets, must be a power of 2.
+ */
+#define PB_DECODING_MAP_CACHE_BUCKETS	256
+
+/*
+ * static fields
+ */
+
+static MemoryContext cache_context = NULL;
+
+static PB_DecodingMapCacheEntry* cache_buckets[PB_DECODING_MAP_CACHE_BUCKETS];
+
+/*
+ * Sequence specific entries, most recently looked up first. The least
+ * recently looked up one is replaced once the cache is full, so maps
+ * just handed out are never freed by the next miss.
+ */
+static PB_DecodingMapCacheEntry* lru_head = NULL;
+static PB_DecodingMapCacheEntry* lru_tail = NULL;
+
+static int64 cache_hits = 0;
+static int64 cache_misses = 0;
+static int64 cache_evictions = 0;
+static int32 n_fixed_entries = 0;
+static int32 n_sequence_entries = 0;
+
+/*
+ * local function declarations
+ */
+
+static void fill_decoding_map(PB_DecodingMap* map, const PB_CodeSet* codeset, int mode);
+static void fill_byte_decoding_map(PB_ByteDecodingMap* byte_map, const PB_DecodingMap* map, const PB_CodeSet* codeset);
+static void fill_multi_decoding_map(PB_MultiDecodingMap* multi_map, const PB_DecodingMap* map, const PB_CodeSet* codeset);
+static uint32 get_code_set_hash(const PB_CodeSet* codeset);
+static bool entry_matches(const PB_DecodingMapCacheEntry* entry, uint32 hash, const PB_CodeSet* codeset);
+static void lru_unlink(PB_DecodingMapCacheEntry* entry);
+static void lru_push(PB_DecodingMapCacheEntry* entry);
+static void evict_entry(PB_DecodingMapCacheEntry* entry);
+static PB_DecodingMapCacheEntry* lookup_entry(const PB_CodeSet* codeset);
+
+/*
+ * local functions
+ */
+
+/**
+ * fill_decoding_map()
+ * 		Fills a decoding map for a prefix code set.
+ */
+static void fill_decoding_map(PB_DecodingMap* map, const PB_CodeSet* codeset, int mode)
+{
+	int i,j;
+	int from = 0;
+	int to = 0;
+
+	if (mode == PB_NO_SWAP_MAP)
+	{
+		from = 0;
+		to = codeset->n_symbols - codeset->n_swapped_symbols;
+	}
+	else if (mode == PB_SWAP_MAP)
+	{
+		from = codeset->n_symbols - codeset->n_swapped_symbols;
+		to = codeset->n_symbols;
+	}
+
+	memset(map, 0xFF, PB_DECODE_MAP_SIZE * sizeof(PB_DecodingMap));
+
+	for (i = from; i < to; i++)
+	{
+		const int lower_bound = codeset->words[i].code;
+		const int upper_bound = lower_bound + (1 << (PB_PREFIX_CODE_BIT_SIZE - codeset->words[i].code_length));
+
+		for (j = lower_bound; j < upper_bound; j++)
+		{
+			map[j].symbol = codeset->words[i].symbol;
+			map[j].code_length = codeset->words[i].code_length;
+		}
+
+		PB_DEBUG3(errmsg("fill_decoding_map(): i:%d lower_bound:%u upper_bound:%u symbol:%c code:%u length:%u/%ld",i,lower_bound,upper_bound,codeset->words[i].symbol,codeset->words[i].code,codeset->words[i].code_length, PB_PREFIX_CODE_BIT_SIZE));
+	}
+}
+
+/**
+ * fill_multi_decoding_map()
+ * 		Fills a multi symbol decoding map from a single symbol decoding map.
+ */
+static void fill_multi_decoding_map(PB_MultiDecodingMap* multi_map, const PB_DecodingMap* map, const PB_CodeSet* codeset)
+{
+	const bool has_master = codeset->n_swapped_symbols > 0;
+	const uint8 master_symbol = has_master ? codeset->words[codeset->n_symbols - codeset->n_swapped_symbols].symbol : 0;
+	int val;
+
+	for (val = 0; val < PB_MULTI_DECODE_MAP_SIZE; val++)
+	{
+		int n_symbols = 0;
+		int n_master = 0;
+		int n_bits = 0;
+
+		while (n_symbols < PB_MULTI_DECODE_MAX_SYMBOLS)
+		{
+			/*
+			 * Next PB_PREFIX_CODE_BIT_SIZE bits, missing bits are zeros.
+			 */
+			const PB_PrefixCode code = (PB_PrefixCode)
+				(((val << n_bits) & (PB_MULTI_DECODE_MAP_SIZE - 1)) >> (PB_MULTI_DECODE_BIT_SIZE - PB_PREFIX_CODE_BIT_SIZE));
+			const int code_length = map[code].code_length;
+
+			if (n_bits + code_length > PB_MULTI_DECODE_BIT_SIZE ||
+				map[code].symbol == PB_RUN_LENGTH_SYMBOL)
+				break;
+
+			multi_map[val].symbols[n_symbols] = map[code].symbol;
+			if (has_master && map[code].symbol == master_symbol)
+				n_master++;
+
+			n_symbols++;
+			n_bits += code_length;
+		}
+
+		multi_map[val].counts = (uint8) (n_symbols | (n_master << 4));
+		multi_map[val].n_bits = (uint8) n_bits;
+	}
+}
+
+/**
+ * fill_byte_decoding_map()
+ * 		Fills a byte decoding map from a single symbol decoding map.
+ */
+static void fill_byte_decoding_map(PB_ByteDecodingMap* byte_map, const PB_DecodingMap* map, const PB_CodeSet* codeset)
+{
+	const int code_length = codeset->words[0].code_length;
+	int val, shift, n;
+
+	for (val = 0; val < 256; val++)
+	{
+		memset(byte_map[val].symbols, 0, PB_BYTE_DECODE_MAX_SYMBOLS);
+
+		for (shift = 0, n = 0; shift < 8; shift += code_length, n++)
+			byte_map[val].symbols[n] = map[(uint8) (val << shift)].symbol;
+	}
+}
+
+/**
+ * get_code_set_hash()
+ * 		Hashes the address of a fixed code set or the codewords
+ * 		of a sequence specific code set.
+ */
+static uint32 get_code_set_hash(const PB_CodeSet* codeset)
+{
+	if (codeset->is_fixed)
+		return DatumGetUInt32(hash_any((const unsigned char*) &codeset, sizeof(codeset)));
+
+	return DatumGetUInt32(hash_any((const unsigned char*) codeset->words,
+								   codeset->n_symbols * sizeof(PB_Codeword)))
+		   ^ codeset->n_swapped_symbols;
+}
+
+/**
+ * entry_matches()
+ * 		True if a cache entry holds the maps for the given code set.
+ */
+static bool entry_matches(const PB_DecodingMapCacheEntry* entry, uint32 hash, const PB_CodeSet* codeset)
+{
+	if (entry->hash != hash)
+		return false;
+
+	if (codeset->is_fixed)
+		return entry->fixed_codeset == codeset;
+
+	return entry->fixed_codeset == NULL &&
+		   entry->n_symbols == codeset->n_symbols &&
+		   entry->n_swapped_symbols == codeset->n_swapped_symbols &&
+		   memcmp(entry->words, codeset->words, codeset->n_symbols * sizeof(PB_Codeword)) == 0;
+}
+
+/**
+ * lru_unlink()
+ * 		Removes a sequence specific entry from the recency list.
+ */
+static void lru_unlink(PB_DecodingMapCacheEntry* entry)
+{
+	if (entry->lru_prev != NULL)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		lru_head = entry->lru_next;
+
+	if (entry->lru_next != NULL)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		lru_tail = entry->lru_prev;
+}
+
+/**
+ * lru_push()
+ * 		Makes a sequence specific entry the most recently looked up one.
+ */
+static void lru_push(PB_DecodingMapCacheEntry* entry)
+{
+	entry->lru_prev = NULL;
+	entry->lru_next = lru_head;
+
+	if (lru_head != NULL)
+		lru_head->lru_prev = entry;
+	else
+		lru_tail = entry;
+
+	lru_head = entry;
+}
+
+/**
+ * evict_entry()
+ * 		Unlinks an entry from its bucket and the recency list and frees it.
+ */
+static void evict_entry(PB_DecodingMapCacheEntry* entry)
+{
+	PB_DecodingMapCacheEntry** link = &cache_buckets[entry->hash & (PB_DECODING_MAP_CACHE_BUCKETS - 1)];
+
+	while (*link != entry)
+		link = &((*link)->next);
+
+	*link = entry->next;
+	lru_unlink(entry);
+	if (entry->multi_map != NULL)
+		pfree(entry->multi_map);
+	if (entry->byte_map != NULL)
+		pfree(entry->byte_map);
+	pfree(entry);
+
+	n_sequence_entries--;
+	cache_evictions++;
+}
+
+/**
+ * lookup_entry()
+ * 		Finds the cache entry of a code set. A missing entry is created
+ * 		and stored in the cache.
+ */
+static PB_DecodingMapCacheEntry* lookup_entry(const PB_CodeSet* codeset)
+{
+	const uint32 hash = get_code_set_hash(codeset);
+	const int bucket = hash & (PB_DECODING_MAP_CACHE_BUCKETS - 1);
+	PB_DecodingMapCacheEntry* entry;
+
+	for (entry = cache_buckets[bucket]; entry != NULL; entry = entry->next)
+	{
+		if (entry_matches(entry, hash, codeset))
+		{
+			if (entry->fixed_codeset == NULL && entry != lru_head)
+			{
+				lru_unlink(entry);
+				lru_push(entry);
+			}
+
+			cache_hits++;
+			return entry;
+		}
+	}
+
+	cache_misses++;
+
+	if (cache_context == NULL)
+		cache_context = AllocSetContextCreate(TopMemoryContext,
+											  "PostBIS decoding map cache",
+											  ALLOCSET_DEFAULT_MINSIZE,
+											  ALLOCSET_DEFAULT_INITSIZE,
+											  ALLOCSET_DEFAULT_MAXSIZE);
+
+	/*
+	 * Create the new entry completely, before it is linked into the cache.
+	 */
+	if (codeset->is_fixed)
+	{
+		entry = MemoryContextAlloc(cache_context, sizeof(PB_DecodingMapCacheEntry));
+		entry->fixed_codeset = codeset;
+		entry->n_symbols = codeset->n_symbols;
+		entry->n_swapped_symbols = codeset->n_swapped_symbols;
+	}
+	else
+	{
+		entry = MemoryContextAlloc(cache_context, sizeof(PB_DecodingMapCacheEntry) +
+												  codeset->n_symbols * sizeof(PB_Codeword));
+		entry->fixed_codeset = NULL;
+		entry->n_symbols = codeset->n_symbols;
+		entry->n_swapped_symbols = codeset->n_swapped_symbols;
+		memcpy(entry->words, codeset->words, codeset->n_symbols * sizeof(PB_Codeword));
+	}
+
+	entry->hash = hash;
+	entry->multi_map = NULL;
+	entry->byte_map = NULL;
+	fill_decoding_map(entry->map, codeset, PB_NO_SWAP_MAP);
+	fill_decoding_map(entry->swap_map, codeset, PB_SWAP_MAP);
+
+	if (codeset->is_fixed)
+		n_fixed_entries++;
+	else
+	{
+		if (n_sequence_entries >= PB_DECODING_MAP_CACHE_SIZE)
+			evict_entry(lru_tail);
+
+		lru_push(entry);
+		n_sequence_entries++;
+	}
+
+	entry->next = cache_buckets[bucket];
+	cache_buckets[bucket] = entry;
+
+	PB_DEBUG1(errmsg("lookup_entry(): cached maps for %s code set, hash:%u",
+					 codeset->is_fixed ? "fixed" : "sequence specific", hash));
+
+	return entry;
+}
+
+/*
+ * public functions
+ */
+
+/**
+ * get_decoding_maps()
+ * 		Returns the decoding maps of a code set from the per backend
+ * 		cache. Missing maps are created and stored in the cache.
+ *
+ * 	const PB_CodeSet* codeset : code set to get the maps for
+ * 	const PB_DecodingMap** map : output for the map without swapped symbols
+ * 	const PB_DecodingMap** swap_map : output for the map of swapped symbols
+ */
+void get_decoding_maps(const PB_CodeSet* codeset,
+					   const PB_DecodingMap** map,
+					   const PB_DecodingMap** swap_map)
+{
+	PB_DecodingMapCacheEntry* entry = lookup_entry(codeset);
+
+	*map = entry->map;
+	*swap_map = entry->swap_map;
+}
+
+/**
+ * get_multi_decoding_map()
+ * 		Returns the multi symbol decoding map of a code set from the per
+ * 		backend cache. It is created on first use.
+ *
+ * 	const PB_CodeSet* codeset : code set to get the map for
+ */
+const PB_MultiDecodingMap* get_multi_decoding_map(const PB_CodeSet* codeset)
+{
+	PB_DecodingMapCacheEntry* entry = lookup_entry(codeset);
+
+	if (entry->multi_map == NULL)
+	{
+		PB_MultiDecodingMap* multi_map = MemoryContextAlloc(cache_context,
+															PB_MULTI_DECODE_MAP_SIZE * sizeof(PB_MultiDecodingMap));
+
+		fill_multi_decoding_map(multi_map, entry->map, codeset);
+		entry->multi_map = multi_map;
+	}
+
+	return entry->multi_map;
+}
+
+/**
+ * get_byte_decoding_map()
+ * 		Returns the byte decoding map of a code set from the per backend
+ * 		cache. It is created on first use.
+ *
+ * 	const PB_CodeSet* codeset : code set to get the map for
+ */
+const PB_ByteDecodingMap* get_byte_decoding_map(const PB_CodeSet* codeset)
+{
+	PB_DecodingMapCacheEntry* entry = lookup_entry(codeset);
+
+	if (entry->byte_map == NULL)
+	{
+		PB_ByteDecodingMap* byte_map = MemoryContextAlloc(cache_context,
+														  256 * sizeof(PB_ByteDecodingMap));
+
+		fill_byte_decoding_map(byte_map, entry->map, codeset);
+		entry->byte_map = byte_map;
+	}
+
+	return entry->byte_map;
+}
+
+/*
+ * pgsql interface functions
+ */
+
+/**
+ * decoding_map_cache_stats()
+ * 		Returns hits, misses, evictions and number of cached maps.
+ */
+PG_FUNCTION_INFO_V1 (decoding_map_cache_stats);
+Datum decoding_map_cache_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc tuple_desc;
+	Datum values[5];
+	bool nulls[5];
+	HeapTuple tuple;
+
+	PB_TRACE(errmsg("->decoding_map_cache_stats()"));
+
+	if (get_call_result_type(fcinfo, NULL, &tuple_desc) != TYPEFUNC_COMPOSITE)
+		ereport(ERROR,(errmsg("function returning record called in context that cannot accept type record")));
+
+	tuple_desc = BlessTupleDesc(tuple_desc);
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(cache_hits);
+	values[1] = Int64GetDatum(cache_misses);
+	values[2] = Int64GetDatum(cache_evictions);
+	values[3] = Int32GetDatum(n_fixed_entries);
+	values[4] = Int32GetDatum(n_sequence_entries);
+
+	tuple = heap_form_tuple(tuple_desc, values, nulls);
+
+	PB_TRACE(errmsg("<-decoding_map_cache_stats()"));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
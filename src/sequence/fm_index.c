@@ -0,0 +1,510 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   src/sequence/fm_index.c
+*
+*-------------------------------------------------------------------------
+*/
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/tuptoaster.h"
+#include "utils/memutils.h"
+
+#include "sequence/sequence.h"
+#include "sequence/stats.h"
+#include "utils/debug.h"
+
+#include "sequence/fm_index.h"
+
+/**
+ * Reads blocks of a possibly toasted FM-index. Toasted indexes are
+ * read in slices, the last slice is kept.
+ */
+typedef struct {
+	Varlena* raw_index;
+	PB_FMIndex* index;
+	bool is_sliced;
+	uint32 block_bytes;
+	int64 current_block;
+	Varlena* block_slice;
+	uint8* block;
+} PB_FMIndexReader;
+
+/**
+ * count_bits()
+ * 		Returns the number of set bits of a word.
+ */
+static int count_bits(uint32 word)
+{
+	word = word - ((word >> 1) & 0x55555555);
+	word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+	word = (word + (word >> 4)) & 0x0F0F0F0F;
+	return (word * 0x01010101) >> 24;
+}
+
+/**
+ * sort_suffixes()
+ * 		Sorts the suffixes of a sequence of ranks followed by a sentinel
+ * 		by prefix doubling. Each round sorts by the ranks of the first
+ * 		2k symbols using two stable counting sorts.
+ *
+ * 	uint32* rank : ranks of the symbols, 0 for the sentinel at the end,
+ * 				   overwritten
+ * 	uint32 n_rows : number of suffixes, including the sentinel
+ * 	uint32 n_ranks : number of distinct ranks
+ * 	uint32* sa : output for the suffix array
+ */
+static void sort_suffixes(uint32* rank, uint32 n_rows, uint32 n_ranks, uint32* sa)
+{
+	uint32* tmp = MemoryContextAllocHuge(CurrentMemoryContext, (Size) n_rows * sizeof(uint32));
+	uint32* count = MemoryContextAllocHuge(CurrentMemoryContext, ((Size) n_rows + 1) * sizeof(uint32));
+	uint32 max_rank = n_ranks - 1;
+	uint32 k;
+	uint32 i;
+	uint32 j;
+
+	/* sort by the first symbol */
+	memset(count, 0, (max_rank + 1) * sizeof(uint32));
+	for (i = 0; i < n_rows; i++)
+		count[rank[i]]++;
+	for (i = 1; i <= max_rank; i++)
+		count[i] += count[i - 1];
+	for (i = n_rows; i > 0; i--)
+		sa[--count[rank[i - 1]]] = i - 1;
+
+	for (k = 1; max_rank < n_rows - 1; k *= 2)
+	{
+		/* order by the second key, suffixes shorter than k come first */
+		j = 0;
+		for (i = n_rows - Min(k, n_rows); i < n_rows; i++)
+			tmp[j++] = i;
+		for (i = 0; i < n_rows; i++)
+			if (sa[i] >= k)
+				tmp[j++] = sa[i] - k;
+
+		/* stable sort by the first key */
+		memset(count, 0, (max_rank + 1) * sizeof(uint32));
+		for (i = 0; i < n_rows; i++)
+			count[rank[i]]++;
+		for (i = 1; i <= max_rank; i++)
+			count[i] += count[i - 1];
+		for (i = n_rows; i > 0; i--)
+			sa[--count[rank[tmp[i - 1]]]] = tmp[i - 1];
+
+		/* rank the sorted pairs */
+		tmp[sa[0]] = 0;
+		max_rank = 0;
+		for (i = 1; i < n_rows; i++)
+		{
+			uint32 a = sa[i - 1];
+			uint32 b = sa[i];
+
+			if (rank[a] != rank[b] ||
+				(a + k < n_rows ? (int64) rank[a + k] : (int64) -1) !=
+				(b + k < n_rows ? (int64) rank[b + k] : (int64) -1))
+				max_rank++;
+
+			tmp[b] = max_rank;
+		}
+		memcpy(rank, tmp, (Size) n_rows * sizeof(uint32));
+
+		PB_DEBUG2(errmsg("sort_suffixes(): k %u, %u ranks", k, max_rank + 1));
+	}
+
+	pfree(count);
+	pfree(tmp);
+}
+
+PB_FMIndex* fm_index_create(uint8* input, uint32 length)
+{
+	PB_FMIndex* result;
+	PB_SequenceInfo* info;
+	uint32 n_rows = length + 1;
+	uint32 n_blocks = n_rows / PB_FM_INDEX_BLOCK_SIZE + 1;
+	uint32 n_samples = length / PB_FM_INDEX_SAMPLE_RATE + 1;
+	uint32 occurrences[PB_FM_INDEX_MAX_SYMBOLS];
+	uint32* rank;
+	uint32* sa;
+	uint32* samples;
+	uint32 block_bytes;
+	uint32 n_sampled = 0;
+	Size size;
+	uint8 n_symbols = 0;
+	uint8* terminated;
+	int i;
+	uint32 row;
+
+	PB_TRACE(errmsg("->fm_index_create()"));
+
+	/* collect the alphabet */
+	terminated = MemoryContextAllocHuge(CurrentMemoryContext, (Size) length + 1);
+	memcpy(terminated, input, length);
+	terminated[length] = '\0';
+	info = get_sequence_info_cstring(terminated, PB_SEQUENCE_INFO_CASE_SENSITIVE | PB_SEQUENCE_INFO_WITHOUT_RLE);
+	check_ascii(info);
+	pfree(terminated);
+
+	if (info->n_symbols > PB_FM_INDEX_MAX_SYMBOLS)
+	{
+		PB_SEQUENCE_INFO_PFREE(info);
+		ereport(ERROR,(errmsg("input sequence violates alphabet constraints"),
+				errdetail("An FM-index can hold at most %d different symbols.", PB_FM_INDEX_MAX_SYMBOLS)));
+	}
+
+	block_bytes = PB_FM_INDEX_BLOCK_BYTES(info->n_symbols);
+	size = offsetof(PB_FMIndex, data) +
+		   (Size) n_blocks * block_bytes +
+		   (Size) n_samples * sizeof(uint32);
+	if (size > MaxAllocSize)
+	{
+		PB_SEQUENCE_INFO_PFREE(info);
+		ereport(ERROR,(errmsg("sequence too long for an FM-index"),
+				errdetail("FM-index would exceed %lu bytes.", (unsigned long) MaxAllocSize)));
+	}
+
+	result = palloc0(size);
+	SET_VARSIZE(result, size);
+	result->sequence_length = length;
+	result->n_blocks = n_blocks;
+	result->n_samples = n_samples;
+
+	/* ranks in ascending symbol order, the sentinel is row 0 */
+	row = 1;
+	for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+	{
+		if (info->frequencies[i] == 0)
+			continue;
+
+		result->ranks[i] = n_symbols + 1;
+		result->c[n_symbols] = row;
+		row += info->frequencies[i];
+		n_symbols++;
+	}
+	result->n_symbols = n_symbols;
+	PB_SEQUENCE_INFO_PFREE(info);
+
+	/* sort suffixes */
+	rank = MemoryContextAllocHuge(CurrentMemoryContext, (Size) n_rows * sizeof(uint32));
+	sa = MemoryContextAllocHuge(CurrentMemoryContext, (Size) n_rows * sizeof(uint32));
+	for (row = 0; row < length; row++)
+		rank[row] = result->ranks[input[row]];
+	rank[length] = 0;
+
+	sort_suffixes(rank, n_rows, n_symbols + 1, sa);
+	pfree(rank);
+
+	/* write blocks and samples */
+	memset(occurrences, 0, sizeof(occurrences));
+	samples = (uint32*) (((uint8*) result) + PB_FM_INDEX_SAMPLE_OFFSET(result, 0));
+	for (row = 0; row < n_blocks * PB_FM_INDEX_BLOCK_SIZE; row++)
+	{
+		uint8* block = ((uint8*) result) + PB_FM_INDEX_BLOCK_OFFSET(result, row / PB_FM_INDEX_BLOCK_SIZE);
+		uint32 offset = row % PB_FM_INDEX_BLOCK_SIZE;
+		uint8* bwt = block + PB_FM_INDEX_BWT_OFFSET(n_symbols);
+
+		if (offset == 0)
+		{
+			memcpy(block, occurrences, n_symbols * sizeof(uint32));
+			*((uint32*) (block + PB_FM_INDEX_N_SAMPLED_OFFSET(n_symbols))) = n_sampled;
+		}
+
+		if (row >= n_rows)
+		{
+			bwt[offset] = PB_FM_INDEX_SENTINEL;
+			continue;
+		}
+
+		if (sa[row] == 0)
+		{
+			bwt[offset] = PB_FM_INDEX_SENTINEL;
+			result->primary_index = row;
+		}
+		else
+		{
+			bwt[offset] = result->ranks[input[sa[row] - 1]] - 1;
+			occurrences[bwt[offset]]++;
+		}
+
+		if (sa[row] % PB_FM_INDEX_SAMPLE_RATE == 0)
+		{
+			uint32* sampled = (uint32*) (block + PB_FM_INDEX_SAMPLED_OFFSET(n_symbols));
+
+			sampled[offset / 32] |= ((uint32) 1) << (offset % 32);
+			samples[n_sampled++] = sa[row];
+		}
+	}
+	pfree(sa);
+
+	PB_TRACE(errmsg("<-fm_index_create(): %u blocks, %u samples", n_blocks, n_sampled));
+
+	return result;
+}
+
+char* fm_index_to_cstring(PB_FMIndex* index)
+{
+	uint8 n_symbols = index->n_symbols;
+	uint32 n_rows = index->sequence_length + 1;
+	uint32 occurrences[PB_FM_INDEX_MAX_SYMBOLS];
+	uint8 symbols[PB_FM_INDEX_MAX_SYMBOLS];
+	uint32* lf;
+	char* result;
+	uint32 row;
+	uint32 i;
+
+	PB_TRACE(errmsg("->fm_index_to_cstring()"));
+
+	for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+		if (index->ranks[i] > 0)
+			symbols[index->ranks[i] - 1] = i;
+
+	/* last to first mapping of all rows */
+	lf = MemoryContextAllocHuge(CurrentMemoryContext, (Size) n_rows * sizeof(uint32));
+	memset(occurrences, 0, sizeof(occurrences));
+	for (row = 0; row < n_rows; row++)
+	{
+		uint8* block = ((uint8*) index) + PB_FM_INDEX_BLOCK_OFFSET(index, row / PB_FM_INDEX_BLOCK_SIZE);
+		uint8 c = block[PB_FM_INDEX_BWT_OFFSET(n_symbols) + row % PB_FM_INDEX_BLOCK_SIZE];
+
+		if (c == PB_FM_INDEX_SENTINEL)
+			lf[row] = 0;
+		else
+			lf[row] = index->c[c] + occurrences[c]++;
+	}
+
+	/* row 0 is the sentinel suffix, its BWT symbol is the last one */
+	result = MemoryContextAllocHuge(CurrentMemoryContext, (Size) n_rows);
+	result[index->sequence_length] = '\0';
+	row = 0;
+	for (i = index->sequence_length; i > 0; i--)
+	{
+		uint8* block = ((uint8*) index) + PB_FM_INDEX_BLOCK_OFFSET(index, row / PB_FM_INDEX_BLOCK_SIZE);
+
+		result[i - 1] = symbols[block[PB_FM_INDEX_BWT_OFFSET(n_symbols) + row % PB_FM_INDEX_BLOCK_SIZE]];
+		row = lf[row];
+	}
+	pfree(lf);
+
+	PB_TRACE(errmsg("<-fm_index_to_cstring()"));
+
+	return result;
+}
+
+/**
+ * reader_init()
+ * 		Initializes a reader. Small indexes are detoasted at once.
+ *
+ * 	PB_FMIndexReader* reader : reader to initialize
+ * 	Varlena* raw_index : possibly toasted FM-index
+ */
+static void reader_init(PB_FMIndexReader* reader, Varlena* raw_index)
+{
+	reader->raw_index = raw_index;
+	reader->is_sliced = VARATT_IS_EXTERNAL(raw_index);
+	reader->current_block = -1;
+	reader->block_slice = NULL;
+	reader->block = NULL;
+
+	if (reader->is_sliced)
+		reader->index = (PB_FMIndex*)
+						PG_DETOAST_DATUM_SLICE(raw_index, 0, offsetof(PB_FMIndex, data) - VARHDRSZ);
+	else
+		reader->index = (PB_FMIndex*) PG_DETOAST_DATUM(raw_index);
+
+	reader->block_bytes = PB_FM_INDEX_BLOCK_BYTES(reader->index->n_symbols);
+}
+
+/**
+ * reader_get_block()
+ * 		Returns the block containing a row.
+ *
+ * 	PB_FMIndexReader* reader : reader
+ * 	uint32 row : BWT row
+ */
+static uint8* reader_get_block(PB_FMIndexReader* reader, uint32 row)
+{
+	uint32 block = row / PB_FM_INDEX_BLOCK_SIZE;
+
+	if (!reader->is_sliced)
+		return ((uint8*) reader->index) + PB_FM_INDEX_BLOCK_OFFSET(reader->index, block);
+
+	if (reader->current_block != block)
+	{
+		if (reader->block_slice != NULL)
+			pfree(reader->block_slice);
+
+		reader->block_slice = (Varlena*)
+							  PG_DETOAST_DATUM_SLICE(reader->raw_index,
+													 PB_FM_INDEX_BLOCK_OFFSET(reader->index, block) - VARHDRSZ,
+													 reader->block_bytes);
+		reader->block = (uint8*) VARDATA(reader->block_slice);
+		reader->current_block = block;
+	}
+
+	return reader->block;
+}
+
+/**
+ * reader_get_sample()
+ * 		Returns a suffix array sample.
+ *
+ * 	PB_FMIndexReader* reader : reader
+ * 	uint32 sample : number of the sample
+ */
+static uint32 reader_get_sample(PB_FMIndexReader* reader, uint32 sample)
+{
+	Varlena* slice;
+	uint32 result;
+
+	if (!reader->is_sliced)
+		return *((uint32*) (((uint8*) reader->index) + PB_FM_INDEX_SAMPLE_OFFSET(reader->index, sample)));
+
+	slice = (Varlena*) PG_DETOAST_DATUM_SLICE(reader->raw_index,
+											  PB_FM_INDEX_SAMPLE_OFFSET(reader->index, sample) - VARHDRSZ,
+											  sizeof(uint32));
+	memcpy(&result, VARDATA(slice), sizeof(uint32));
+	pfree(slice);
+
+	return result;
+}
+
+/**
+ * reader_occurrences()
+ * 		Returns the number of occurrences of a rank before a row.
+ *
+ * 	PB_FMIndexReader* reader : reader
+ * 	uint8 c : rank of the symbol
+ * 	uint32 row : BWT row
+ */
+static uint32 reader_occurrences(PB_FMIndexReader* reader, uint8 c, uint32 row)
+{
+	uint8* block = reader_get_block(reader, row);
+	uint8* bwt = block + PB_FM_INDEX_BWT_OFFSET(reader->index->n_symbols);
+	uint32 result = ((uint32*) block)[c];
+	uint32 i;
+
+	for (i = 0; i < row % PB_FM_INDEX_BLOCK_SIZE; i++)
+		result += bwt[i] == c;
+
+	return result;
+}
+
+/**
+ * reader_locate()
+ * 		Returns the text position of a row. Walks the last to first
+ * 		mapping until a sampled row is reached.
+ *
+ * 	PB_FMIndexReader* reader : reader
+ * 	uint32 row : BWT row
+ */
+static uint32 reader_locate(PB_FMIndexReader* reader, uint32 row)
+{
+	uint8 n_symbols = reader->index->n_symbols;
+	uint32 steps = 0;
+
+	for (;;)
+	{
+		uint8* block = reader_get_block(reader, row);
+		uint32* sampled = (uint32*) (block + PB_FM_INDEX_SAMPLED_OFFSET(n_symbols));
+		uint32 offset = row % PB_FM_INDEX_BLOCK_SIZE;
+		uint8 c;
+
+		if (sampled[offset / 32] & (((uint32) 1) << (offset % 32)))
+		{
+			uint32 sample = *((uint32*) (block + PB_FM_INDEX_N_SAMPLED_OFFSET(n_symbols)));
+			uint32 i;
+
+			for (i = 0; i < offset / 32; i++)
+				sample += count_bits(sampled[i]);
+			sample += count_bits(sampled[offset / 32] & ((((uint32) 1) << (offset % 32)) - 1));
+
+			return reader_get_sample(reader, sample) + steps;
+		}
+
+		/* the sentinel row is always sampled */
+		c = block[PB_FM_INDEX_BWT_OFFSET(n_symbols) + offset];
+		row = reader->index->c[c] + reader_occurrences(reader, c, row);
+		steps++;
+	}
+}
+
+/**
+ * compare_positions()
+ * 		qsort comparator for positions.
+ */
+static int compare_positions(const void* a, const void* b)
+{
+	uint32 position_a = *((const uint32*) a);
+	uint32 position_b = *((const uint32*) b);
+
+	if (position_a < position_b)
+		return (-1);
+	if (position_a > position_b)
+		return 1;
+	return 0;
+}
+
+uint32 fm_index_find(Varlena* raw_index, text* pattern, uint32** positions)
+{
+	PB_FMIndexReader reader;
+	uint8* symbols = (uint8*) VARDATA_ANY(pattern);
+	int32 length = VARSIZE_ANY_EXHDR(pattern);
+	uint32 start = 0;
+	uint32 end;
+	uint32 result;
+	int32 i;
+
+	PB_TRACE(errmsg("->fm_index_find()"));
+
+	if (positions != NULL)
+		*positions = NULL;
+
+	/* an empty pattern is never found, like in sequence_strpos() */
+	if (length == 0)
+		return 0;
+
+	reader_init(&reader, raw_index);
+	end = reader.index->sequence_length + 1;
+
+	/* backward search */
+	for (i = length - 1; i >= 0 && start < end; i--)
+	{
+		uint8 rank = reader.index->ranks[symbols[i]];
+
+		if (rank == 0)
+		{
+			start = end = 0;
+			break;
+		}
+
+		start = reader.index->c[rank - 1] + reader_occurrences(&reader, rank - 1, start);
+		end = reader.index->c[rank - 1] + reader_occurrences(&reader, rank - 1, end);
+	}
+
+	result = start < end ? end - start : 0;
+
+	if (positions != NULL && result > 0)
+	{
+		uint32 row;
+
+		*positions = palloc(result * sizeof(uint32));
+		for (row = start; row < end; row++)
+			(*positions)[row - start] = reader_locate(&reader, row) + 1;
+
+		qsort(*positions, result, sizeof(uint32), compare_positions);
+	}
+
+	if (reader.block_slice != NULL)
+		pfree(reader.block_slice);
+	if ((Pointer) reader.index != (Pointer) raw_index)
+		pfree(reader.index);
+
+	PB_TRACE(errmsg("<-fm_index_find(): %u occurrences", result));
+
+	return result;
+}
@@ -15,7 +15,9 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "utils/array.h"
+#include "utils/builtins.h"
 #include "catalog/pg_type.h"
 #include "access/tuptoaster.h"
 
@@ -84,8 +86,21 @@ PB_CompressedSequence* reverse(PB_CompressedSequence* sequence, PB_CodeSet** fix
 	}
 
 	info.sequence_length = sequence->sequence_length;
+	info.with_composition = sequence->has_composition;
+	info.index_shift = sequence->index_shift;
 
-	result = encode(temp, VARSIZE(sequence), codeset, &info);
+	/*
+	 * The stream keeps its size, the composition summary might have
+	 * been missing.
+	 */
+	result = encode(temp,
+					get_stream_offset(sequence->sequence_length,
+									  codeset,
+									  sequence->has_composition,
+									  sequence->index_shift) +
+					VARSIZE(sequence) - PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(sequence),
+					codeset,
+					&info);
 
 	pfree(temp);
 	if (!codeset->is_fixed)
@@ -96,6 +111,122 @@ PB_CompressedSequence* reverse(PB_CompressedSequence* sequence, PB_CodeSet** fix
 	return result;
 }
 
+/**
+ * Number of stream bytes compared at once by equal_streams() and
+ * compare_streams(), if a sequence is toasted.
+ */
+#define PB_STREAM_SLICE_SIZE		(64 * 1024)
+
+/**
+ * Number of symbols decoded for the first block compared by
+ * sequence_compare(). Every further block is twice as large, up
+ * to PB_COMPARE_MAX_BLOCK_SIZE.
+ */
+#define PB_COMPARE_FIRST_BLOCK_SIZE		256
+#define PB_COMPARE_MAX_BLOCK_SIZE		(64 * 1024)
+
+/**
+ * get_code_header()
+ * 		Returns the header and the codewords of a possibly toasted
+ * 		sequence without detoasting the stream.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ */
+static PB_CompressedSequence* get_code_header(Varlena* raw_seq)
+{
+	PB_CompressedSequence* header;
+	int n_symbols;
+
+	header = (PB_CompressedSequence*)
+			 PG_DETOAST_DATUM_SLICE(raw_seq, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+
+	if (header->is_fixed || header->n_symbols == 0)
+		return header;
+
+	n_symbols = header->n_symbols;
+	pfree(header);
+
+	return (PB_CompressedSequence*)
+		   PG_DETOAST_DATUM_SLICE(raw_seq,
+								  0,
+								  sizeof(PB_CompressedSequence) - VARHDRSZ
+								  + n_symbols * sizeof(PB_Codeword));
+}
+
+/**
+ * have_equal_code()
+ * 		Returns true if two sequences were compressed with the same code
+ * 		and the same options. Compression is deterministic, so such
+ * 		sequences are equal, iff their streams are bit-identical.
+ *
+ * 	PB_CompressedSequence* header1 : header and codewords of first sequence
+ * 	PB_CompressedSequence* header2 : header and codewords of second sequence
+ */
+static bool have_equal_code(PB_CompressedSequence* header1, PB_CompressedSequence* header2)
+{
+	if (header1->is_fixed != header2->is_fixed ||
+		header1->n_symbols != header2->n_symbols ||
+		header1->n_swapped_symbols != header2->n_swapped_symbols ||
+		header1->has_equal_length != header2->has_equal_length ||
+		header1->has_index != header2->has_index ||
+		header1->uses_rle != header2->uses_rle)
+		return false;
+
+	if (header1->is_fixed)
+		return true;
+
+	return memcmp(header1->data, header2->data, header1->n_symbols * sizeof(PB_Codeword)) == 0;
+}
+
+/**
+ * equal_streams()
+ * 		Compares the streams of two sequences byte-wise. Toasted
+ * 		sequences are compared slice by slice, so that unequal
+ * 		sequences are rarely detoasted completely.
+ *
+ * 	Varlena* raw_seq1 : first possibly toasted sequence
+ * 	Varlena* raw_seq2 : second possibly toasted sequence
+ * 	int stream_offset : offset of both streams
+ */
+static bool equal_streams(Varlena* raw_seq1, Varlena* raw_seq2, int stream_offset)
+{
+	Size size;
+	Size slice_start;
+	Size slice_size;
+	Varlena* slice1;
+	Varlena* slice2;
+	bool result;
+
+	size = toast_raw_datum_size((Datum) raw_seq1);
+
+	/* Same code and length, so different sizes mean different symbols */
+	if (size != toast_raw_datum_size((Datum) raw_seq2))
+		return false;
+
+	if (!VARATT_IS_EXTENDED(raw_seq1) && !VARATT_IS_EXTENDED(raw_seq2))
+		return memcmp(((uint8*) raw_seq1) + stream_offset,
+					  ((uint8*) raw_seq2) + stream_offset,
+					  size - stream_offset) == 0;
+
+	result = true;
+	for (slice_start = stream_offset - VARHDRSZ;
+		 result && slice_start < size - VARHDRSZ;
+		 slice_start += slice_size)
+	{
+		slice_size = Min(PB_STREAM_SLICE_SIZE, size - VARHDRSZ - slice_start);
+
+		slice1 = (Varlena*) PG_DETOAST_DATUM_SLICE(raw_seq1, slice_start, slice_size);
+		slice2 = (Varlena*) PG_DETOAST_DATUM_SLICE(raw_seq2, slice_start, slice_size);
+
+		result = memcmp(VARDATA(slice1), VARDATA(slice2), slice_size) == 0;
+
+		pfree(slice1);
+		pfree(slice2);
+	}
+
+	return result;
+}
+
 /**
  * sequence_equal()
  * 		Compares two compressed sequences. Returns (-1) if equal, 0 if not.
@@ -108,10 +239,13 @@ PB_CompressedSequence* reverse(PB_CompressedSequence* sequence, PB_CodeSet** fix
 bool sequence_equal(Varlena* raw_seq1, Varlena* raw_seq2, PB_CodeSet** fixed_codesets)
 {
 	PB_CompressedSequence* input_header;
+	PB_CompressedSequence* header1;
+	PB_CompressedSequence* header2;
 	PB_CompressedSequence* seq1;
 	PB_CompressedSequence* seq2;
 	uint8* decompressed_sequence;
 	int len;
+	bool result;
 
 	uint8 c;
 	uint8* output_pointer;
@@ -135,6 +269,29 @@ bool sequence_equal(Varlena* raw_seq1, Varlena* raw_seq2, PB_CodeSet** fixed_cod
 		return false;
 	}
 
+	/* Sequences compressed with the same code are compared without decoding */
+	header1 = get_code_header(raw_seq1);
+	header2 = get_code_header(raw_seq2);
+
+	/* Composition and summary are optional, the streams might be shifted */
+	if (have_equal_code(header1, header2) &&
+		PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(header1) == PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(header2))
+	{
+		result = equal_streams(raw_seq1,
+							   raw_seq2,
+							   PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(header1));
+
+		pfree(header1);
+		pfree(header2);
+
+		PB_TRACE(errmsg("<-sequence_equal(): compared in compressed domain"));
+
+		return result;
+	}
+
+	pfree(header1);
+	pfree(header2);
+
 	seq1 = (PB_CompressedSequence*) PG_DETOAST_DATUM(raw_seq1);
 	seq2 = (PB_CompressedSequence*) PG_DETOAST_DATUM(raw_seq2);
 
@@ -159,72 +316,370 @@ bool sequence_equal(Varlena* raw_seq1, Varlena* raw_seq2, PB_CodeSet** fixed_cod
 	return true;
 }
 
+/**
+ * is_order_preserving()
+ * 		Returns true if all codewords of a code set have the same length
+ * 		and their order matches the order of their symbols. The streams of
+ * 		two sequences compressed with such a code can be compared as
+ * 		unsigned integers.
+ *
+ * 	PB_CodeSet* codeset : code set to check
+ */
+static bool is_order_preserving(PB_CodeSet* codeset)
+{
+	int i;
+	int j;
+
+	if (!codeset->has_equal_length || codeset->uses_rle || codeset->n_swapped_symbols > 0)
+		return false;
+
+	for (i = 0; i < codeset->n_symbols; i++)
+		for (j = 0; j < codeset->n_symbols; j++)
+			if ((codeset->words[i].symbol < codeset->words[j].symbol) !=
+				(codeset->words[i].code < codeset->words[j].code))
+				return false;
+
+	return true;
+}
+
+/**
+ * compare_streams()
+ * 		Compares the first bits of the streams of two sequences as
+ * 		unsigned integers. Returns (-1) if the first stream is smaller,
+ * 		0 if both are equal, 1 if the second one is smaller. Toasted
+ * 		sequences are compared slice by slice.
+ *
+ * 	Varlena* raw_seq1 : first possibly toasted sequence
+ * 	Varlena* raw_seq2 : second possibly toasted sequence
+ * 	int stream_offset1 : offset of the first stream
+ * 	int stream_offset2 : offset of the second stream
+ * 	uint64 n_bits : number of bits to compare
+ */
+static int compare_streams(Varlena* raw_seq1,
+						   Varlena* raw_seq2,
+						   int stream_offset1,
+						   int stream_offset2,
+						   uint64 n_bits)
+{
+	uint64 n_words = (n_bits + PB_COMPRESSION_BUFFER_BIT_SIZE - 1) / PB_COMPRESSION_BUFFER_BIT_SIZE;
+	int last_bits = n_bits % PB_COMPRESSION_BUFFER_BIT_SIZE;
+	bool is_sliced = VARATT_IS_EXTENDED(raw_seq1) || VARATT_IS_EXTENDED(raw_seq2);
+	uint64 word_start;
+	uint64 slice_words = 0;
+	Varlena* slice1 = NULL;
+	Varlena* slice2 = NULL;
+	PB_CompressionBuffer* words1;
+	PB_CompressionBuffer* words2;
+	int result = 0;
+
+	for (word_start = 0; result == 0 && word_start < n_words; word_start += slice_words)
+	{
+		uint64 k;
+
+		if (is_sliced)
+		{
+			slice_words = Min(PB_STREAM_SLICE_SIZE / PB_COMPRESSION_BUFFER_BYTE_SIZE, n_words - word_start);
+
+			slice1 = (Varlena*) PG_DETOAST_DATUM_SLICE(raw_seq1,
+										stream_offset1 - VARHDRSZ + word_start * PB_COMPRESSION_BUFFER_BYTE_SIZE,
+										slice_words * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+			slice2 = (Varlena*) PG_DETOAST_DATUM_SLICE(raw_seq2,
+										stream_offset2 - VARHDRSZ + word_start * PB_COMPRESSION_BUFFER_BYTE_SIZE,
+										slice_words * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+
+			words1 = (PB_CompressionBuffer*) VARDATA_ANY(slice1);
+			words2 = (PB_CompressionBuffer*) VARDATA_ANY(slice2);
+		}
+		else
+		{
+			slice_words = n_words;
+
+			words1 = (PB_CompressionBuffer*) (((uint8*) raw_seq1) + stream_offset1);
+			words2 = (PB_CompressionBuffer*) (((uint8*) raw_seq2) + stream_offset2);
+		}
+
+		for (k = 0; k < slice_words; k++)
+		{
+			PB_CompressionBuffer word1 = words1[k];
+			PB_CompressionBuffer word2 = words2[k];
+
+			/* Ignore bits beyond the compared symbols in the last word */
+			if (word_start + k == n_words - 1 && last_bits > 0)
+			{
+				word1 >>= PB_COMPRESSION_BUFFER_BIT_SIZE - last_bits;
+				word2 >>= PB_COMPRESSION_BUFFER_BIT_SIZE - last_bits;
+			}
+
+			if (word1 != word2)
+			{
+				result = (word1 < word2) ? (-1) : 1;
+				break;
+			}
+		}
+
+		if (is_sliced)
+		{
+			pfree(slice1);
+			pfree(slice2);
+		}
+	}
+
+	return result;
+}
+
 /**
  * sequence_compare()
  * 		Compares two compressed sequences. Returns (-1) if first is smaller,
  * 		0 if both are equal, 1 if second sequence is smaller (lexicographically).
  *
+ * 		Both sequences are decoded block by block, starting with small
+ * 		blocks, so that comparing sequences, which differ early, neither
+ * 		detoasts nor decodes them completely. Sequences sharing a fixed,
+ * 		order preserving code are compared without decoding.
+ *
  * 	Varlena* seq_a : first possibly toasted sequence
  * 	Varlena* seq_b : second possibly toasted sequence
  */
 int sequence_compare(Varlena* seq_a, Varlena* seq_b, PB_CodeSet** fixed_codesets)
 {
-	PB_CompressedSequence* seq1 = (PB_CompressedSequence*) PG_DETOAST_DATUM(seq_a);
-	PB_CompressedSequence* seq2 = (PB_CompressedSequence*) PG_DETOAST_DATUM(seq_b);
-	int swap = 1;
+	PB_CompressedSequence* header1;
+	PB_CompressedSequence* header2;
+	uint32 length1;
+	uint32 length2;
+	uint32 common_length;
+	int result = 0;
 
-	uint8* decompressed_sequence;
+	PB_TRACE(errmsg("->sequence_compare()"));
 
-	uint8 c;
-	uint8* output_pointer;
+	header1 = get_code_header(seq_a);
+	header2 = get_code_header(seq_b);
 
-	PB_TRACE(errmsg("->sequence_compare()"));
+	length1 = header1->sequence_length;
+	length2 = header2->sequence_length;
+	common_length = Min(length1, length2);
 
-	/*
-	 * seq1 should be the shorter sequence, as it will be fully decompressed
-	 */
-	if (seq1->sequence_length > seq2->sequence_length)
+	if (common_length > 0 &&
+		have_equal_code(header1, header2) &&
+		header1->is_fixed &&
+		is_order_preserving(fixed_codesets[PB_COMPRESSED_SEQUENCE_FIXED_CODE_ID(header1)]))
 	{
-		PB_CompressedSequence* swapseq = seq1;
-		seq1 = seq2;
-		seq2 = swapseq;
-		swap = (-1);
-	}
+		PB_CodeSet* codeset = fixed_codesets[PB_COMPRESSED_SEQUENCE_FIXED_CODE_ID(header1)];
 
-	decompressed_sequence = palloc0(seq1->sequence_length);
-	decode((Varlena*) seq1, decompressed_sequence, 0, seq1->sequence_length, fixed_codesets);
+		result = compare_streams(seq_a,
+								 seq_b,
+								 PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(header1),
+								 PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(header2),
+								 (uint64) common_length * codeset->words[0].code_length);
 
-	output_pointer = decompressed_sequence;
+		PB_TRACE(errmsg("sequence_compare(): compared in compressed domain"));
+	}
+	else if (common_length > 0)
+	{
+		uint32 position;
+		uint32 block_size = PB_COMPARE_FIRST_BLOCK_SIZE;
+		uint8* block1 = palloc(Min(common_length, PB_COMPARE_MAX_BLOCK_SIZE));
+		uint8* block2 = palloc(Min(common_length, PB_COMPARE_MAX_BLOCK_SIZE));
 
-	PB_BEGIN_DECODE((Varlena*) seq2, 0, seq1->sequence_length, fixed_codesets, (c)) {
-		if (c != *output_pointer)
+		for (position = 0; result == 0 && position < common_length; position += block_size)
 		{
-			int result = 1;
+			if (position > 0 && block_size < PB_COMPARE_MAX_BLOCK_SIZE)
+				block_size *= 2;
+
+			block_size = Min(block_size, common_length - position);
+
+			decode(seq_a, block1, position, block_size, fixed_codesets);
+			decode(seq_b, block2, position, block_size, fixed_codesets);
+
+			result = memcmp(block1, block2, block_size);
+		}
+
+		PB_TRACE(errmsg("sequence_compare(): compared %u chars", position));
+
+		pfree(block1);
+		pfree(block2);
+	}
+
+	pfree(header1);
+	pfree(header2);
+
+	if (result != 0)
+		result = (result < 0) ? (-1) : 1;
+	else if (length1 != length2)
+		result = (length1 < length2) ? (-1) : 1;
+
+	PB_TRACE(errmsg("<-sequence_compare()"));
+
+	return result;
+}
+
+/**
+ * State of the sort support of a sequence type. An abbreviated key
+ * holds the first symbols_per_key symbols of a sequence, each one
+ * mapped to a code of bits_per_symbol bits. Codes of symbols are
+ * ordered like the symbols.
+ *
+ * Symbols, that are not part of the key alphabet, are mapped to the
+ * code of the next smaller symbol of the alphabet and the rest of
+ * the key is filled with ones. Symbols smaller than all symbols of
+ * the alphabet end the key. Such keys never contradict the order of
+ * the full sequences, ties are resolved by sequence_compare().
+ */
+typedef struct {
+	PB_CodeSet** fixed_codesets;
+	int bits_per_symbol;
+	int symbols_per_key;
+	uint8 codes[PB_SOURCE_ALPHABET_SIZE];
+	bool is_exact[PB_SOURCE_ALPHABET_SIZE];
+	bool is_below[PB_SOURCE_ALPHABET_SIZE];
+} PB_SortSupportState;
+
+/**
+ * sequence_fast_compare()
+ * 		Sort support comparator skipping the fmgr overhead.
+ */
+static int sequence_fast_compare(Datum x, Datum y, SortSupport ssup)
+{
+	PB_SortSupportState* state = (PB_SortSupportState*) ssup->ssup_extra;
+
+	return sequence_compare((Varlena*) DatumGetPointer(x),
+							(Varlena*) DatumGetPointer(y),
+							state->fixed_codesets);
+}
+
+#if PG_VERSION_NUM >= 90500
+/**
+ * sequence_abbreviated_compare()
+ * 		Compares two abbreviated keys.
+ */
+static int sequence_abbreviated_compare(Datum x, Datum y, SortSupport ssup)
+{
+	if (x < y)
+		return (-1);
+	if (x > y)
+		return 1;
+	return 0;
+}
+
+/**
+ * sequence_abbreviate()
+ * 		Builds the abbreviated key of a possibly toasted sequence.
+ */
+static Datum sequence_abbreviate(Datum original, SortSupport ssup)
+{
+	PB_SortSupportState* state = (PB_SortSupportState*) ssup->ssup_extra;
+	Varlena* raw_seq = (Varlena*) DatumGetPointer(original);
+	PB_CompressedSequence* input_header;
+	uint8 symbols[SIZEOF_DATUM * 8];
+	int max_code = (1 << state->bits_per_symbol) - 1;
+	int n_symbols;
+	int shift;
+	int i;
+	Datum key = 0;
+
+	input_header = (PB_CompressedSequence*)
+				   PG_DETOAST_DATUM_SLICE(raw_seq, 0, 4);
+	n_symbols = Min(input_header->sequence_length, state->symbols_per_key);
+	pfree(input_header);
+
+	if (n_symbols > 0)
+		decode(raw_seq, symbols, 0, n_symbols, state->fixed_codesets);
 
-			if (c > *output_pointer)
-				result = (-1);
+	shift = SIZEOF_DATUM * 8;
+	for (i = 0; i < n_symbols; i++)
+	{
+		uint8 c = symbols[i];
 
-			result *= swap;
+		if (state->is_below[c])
+			break;
 
-			PB_TRACE(errmsg("<-sequence_compare(): exits due to different char at position %ld", output_pointer - decompressed_sequence));
+		shift -= state->bits_per_symbol;
+		key |= ((Datum) state->codes[c]) << shift;
 
-			return result;
+		if (!state->is_exact[c])
+		{
+			for (i++; i < state->symbols_per_key; i++)
+			{
+				shift -= state->bits_per_symbol;
+				key |= ((Datum) max_code) << shift;
+			}
+			break;
 		}
-		output_pointer++;
-	} PB_END_DECODE
+	}
 
-	pfree(decompressed_sequence);
+	return key;
+}
+
+/**
+ * sequence_abbreviation_abort()
+ * 		Abbreviated keys are cheap to build, they are always kept.
+ */
+static bool sequence_abbreviation_abort(int memtupcount, SortSupport ssup)
+{
+	return false;
+}
+#endif
 
-	if (seq1->sequence_length < seq2->sequence_length)
+/**
+ * sequence_sortsupport()
+ * 		Sets up sort support for a sequence type.
+ *
+ * 	SortSupport ssup : sort support to set up
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	const char* key_alphabet : sorted symbols, which are abbreviated
+ * 							   exactly, NULL for all bytes
+ */
+void sequence_sortsupport(SortSupport ssup, PB_CodeSet** fixed_codesets, const char* key_alphabet)
+{
+	PB_SortSupportState* state;
+	int n_symbols;
+	int c;
+
+	state = MemoryContextAllocZero(ssup->ssup_cxt, sizeof(PB_SortSupportState));
+	state->fixed_codesets = fixed_codesets;
+
+	if (key_alphabet == NULL)
+	{
+		for (c = 0; c < PB_SOURCE_ALPHABET_SIZE; c++)
+		{
+			state->codes[c] = c;
+			state->is_exact[c] = true;
+		}
+		n_symbols = PB_SOURCE_ALPHABET_SIZE;
+	}
+	else
 	{
-		PB_TRACE(errmsg("<-sequence_compare(): exits, seq1 is shorter"));
+		int code = -1;
 
-		return (-swap);
+		n_symbols = strlen(key_alphabet);
+		for (c = 0; c < PB_SOURCE_ALPHABET_SIZE; c++)
+		{
+			if (code + 1 < n_symbols && c == (uint8) key_alphabet[code + 1])
+			{
+				code++;
+				state->is_exact[c] = true;
+			}
+			state->is_below[c] = (code < 0);
+			state->codes[c] = Max(code, 0);
+		}
 	}
 
-	PB_TRACE(errmsg("<-sequence_compare()"));
+	state->bits_per_symbol = 1;
+	while ((1 << state->bits_per_symbol) < n_symbols)
+		state->bits_per_symbol++;
+	state->symbols_per_key = (SIZEOF_DATUM * 8) / state->bits_per_symbol;
 
-	return 0;
+	ssup->ssup_extra = state;
+	ssup->comparator = sequence_fast_compare;
+
+#if PG_VERSION_NUM >= 90500
+	if (ssup->abbreviate)
+	{
+		ssup->abbrev_full_comparator = ssup->comparator;
+		ssup->comparator = sequence_abbreviated_compare;
+		ssup->abbrev_converter = sequence_abbreviate;
+		ssup->abbrev_abort = sequence_abbreviation_abort;
+	}
+#endif
 }
 
 /* generated using the AUTODIN II polynomial
@@ -301,6 +756,79 @@ static const unsigned int crc32tab[256] = {
 
 #define _CRC32_(crc, ch) (crc = (crc >> 8) ^ crc32tab[(crc ^ (ch)) & 0xff])
 
+/**
+ * Number of symbols decoded at once by sequence_crc32().
+ */
+#define PB_CRC32_BLOCK_SIZE		8192
+
+/**
+ * Tables for computing the CRC32 eight bytes at a time (slicing-by-8).
+ * crc32tab8[0] equals crc32tab, crc32tab8[k] advances a CRC by k more
+ * zero bytes. They are built on first use.
+ */
+static uint32 crc32tab8[8][256];
+static bool crc32tab8_ready = false;
+
+/**
+ * fill_crc32tab8()
+ * 		Builds the slicing-by-8 tables from crc32tab.
+ */
+static void fill_crc32tab8(void)
+{
+	int i;
+	int k;
+
+	for (i = 0; i < 256; i++)
+		crc32tab8[0][i] = crc32tab[i];
+
+	for (k = 1; k < 8; k++)
+		for (i = 0; i < 256; i++)
+			crc32tab8[k][i] = (crc32tab8[k - 1][i] >> 8) ^ crc32tab[crc32tab8[k - 1][i] & 0xff];
+
+	crc32tab8_ready = true;
+}
+
+/**
+ * crc32_update()
+ * 		Feeds a buffer into a CRC32, eight bytes at a time. The result
+ * 		equals feeding the bytes one by one using _CRC32_.
+ *
+ * 	uint32 crc : CRC32 so far
+ * 	const uint8* buffer : bytes to add
+ * 	int length : number of bytes
+ */
+static uint32 crc32_update(uint32 crc, const uint8* buffer, int length)
+{
+	while (length >= 8)
+	{
+		uint32 low = crc ^ ((uint32) buffer[0] |
+							((uint32) buffer[1] << 8) |
+							((uint32) buffer[2] << 16) |
+							((uint32) buffer[3] << 24));
+
+		crc = crc32tab8[7][low & 0xff] ^
+			  crc32tab8[6][(low >> 8) & 0xff] ^
+			  crc32tab8[5][(low >> 16) & 0xff] ^
+			  crc32tab8[4][low >> 24] ^
+			  crc32tab8[3][buffer[4]] ^
+			  crc32tab8[2][buffer[5]] ^
+			  crc32tab8[1][buffer[6]] ^
+			  crc32tab8[0][buffer[7]];
+
+		buffer += 8;
+		length -= 8;
+	}
+
+	while (length > 0)
+	{
+		_CRC32_(crc, *buffer);
+		buffer++;
+		length--;
+	}
+
+	return crc;
+}
+
 /*
  * sequence_crc32()
  *		Compute CRC32 of a compressed sequence.
@@ -308,66 +836,208 @@ static const unsigned int crc32tab[256] = {
  * 		Original code by Spencer Garrett <srg@quick.com>
  * 		Taken into PostBIS from pgsql/src/contrib/hstore/crc32.c
  *
+ * 		The sequence is decoded into a buffer in blocks, each block is
+ * 		added eight bytes at a time. Results equal those of hash
+ * 		version 1, see PB_HASH_VERSION.
+ *
  * 	PB_CompressedSequence* seq: detoasted input sequence
  * 	PB_CodeSet** fixed_codesets : fixed codes
  */
 uint32 sequence_crc32(PB_CompressedSequence* seq, PB_CodeSet** fixed_codesets)
 {
 	uint32 crc32 = ~((uint32) 0);
+	uint8 buffer[PB_CRC32_BLOCK_SIZE];
+	int n_buffered = 0;
 	uint8 c;
 
+	if (!crc32tab8_ready)
+		fill_crc32tab8();
+
 	PB_BEGIN_DECODE((Varlena*) seq, 0, seq->sequence_length, fixed_codesets, (c)) {
-		_CRC32_(crc32, c);
+		buffer[n_buffered] = c;
+		n_buffered++;
+
+		if (n_buffered == PB_CRC32_BLOCK_SIZE)
+		{
+			crc32 = crc32_update(crc32, buffer, n_buffered);
+			n_buffered = 0;
+		}
 	} PB_END_DECODE
 
+	crc32 = crc32_update(crc32, buffer, n_buffered);
+
 	return ~crc32;
 }
 
+/**
+ * sequence_hash_version()
+ * 		Returns the version of the hash values of all sequence types.
+ */
+PG_FUNCTION_INFO_V1 (sequence_hash_version);
+Datum sequence_hash_version(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT32(PB_HASH_VERSION);
+}
+
+/**
+ * Number of decoded symbols searched at once by sequence_strpos().
+ */
+#define PB_STRPOS_BLOCK_SIZE	4096
+
+/**
+ * State of a multi-word shift-and search (Baeza-Yates-Gonnet). Bit j
+ * of the state is set, if the last j + 1 symbols match the first
+ * j + 1 symbols of the pattern. Bit j is stored in word j / 64.
+ *
+ * Words above last_active are zero, so only the active prefix of the
+ * state is shifted. This keeps the search linear in the number of
+ * symbols for random sequences, independently of the pattern length.
+ */
 typedef struct {
-	uint32 pos;
-	uint32 len;
-	void* next;
-} PB_PartialMatch;
+	int pattern_length;
+	int n_words;
+	int last_active;
+	uint64 match_bit;
+	uint64* masks;
+	uint64* state;
+} PB_ShiftAnd;
 
-/*
- * sequence_strpos()
- * 		Find position of given string.
- * 		Baeza-Yates-Gonnet implementation.
+/**
+ * shift_and_create()
+ * 		Creates the state of a shift-and search for a pattern of
+ * 		any length. Uses a single allocation.
  *
- * 	PB_CompressedSequence* seq : detoasted sequence to search in
- * 	Text* search : detoasted text to search for
- * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	const uint8* pattern : pattern to search
+ * 	int length : length of pattern, at least 1
  */
-uint32 sequence_strpos(PB_CompressedSequence* seq, text* search, PB_CodeSet** fixed_codesets)
+static PB_ShiftAnd* shift_and_create(const uint8* pattern, int length)
 {
-	uint64 search_vector = 0;
-	uint64 match;
-	uint64* specific_vectors;
-	int search_vector_length = 64;
+	int n_words = (length + 63) / 64;
+	PB_ShiftAnd* matcher;
+	int i;
+
+	matcher = palloc0(sizeof(PB_ShiftAnd) +
+					  (PB_SOURCE_ALPHABET_SIZE + 1) * n_words * sizeof(uint64));
+	matcher->pattern_length = length;
+	matcher->n_words = n_words;
+	matcher->last_active = 0;
+	matcher->match_bit = ((uint64) 1) << ((length - 1) % 64);
+	matcher->masks = (uint64*) (matcher + 1);
+	matcher->state = matcher->masks + PB_SOURCE_ALPHABET_SIZE * n_words;
+
+	for (i = 0; i < length; i++)
+		matcher->masks[pattern[i] * n_words + i / 64] |= ((uint64) 1) << (i % 64);
+
+	return matcher;
+}
 
-	PB_SequenceInfo* search_str_info;
-	uint32 pos = 0;
+/**
+ * shift_and_find()
+ * 		Feeds symbols into a shift-and search until a match ends.
+ * 		Returns the index of the symbol ending the match or (-1), if
+ * 		no match ends within the given symbols. After a match the
+ * 		search can be continued with the following symbols.
+ *
+ * 	PB_ShiftAnd* matcher : search state
+ * 	const uint8* symbols : decoded symbols
+ * 	int n_symbols : number of symbols
+ */
+static int shift_and_find(PB_ShiftAnd* matcher, const uint8* symbols, int n_symbols)
+{
+	int n_words = matcher->n_words;
+	uint64* state = matcher->state;
+	int i;
 
-	PB_PartialMatch* first_match = NULL;
-	PB_PartialMatch* last_match = NULL;
+	if (n_words == 1)
+	{
+		uint64 word = state[0];
 
-	uint8 c;
+		for (i = 0; i < n_symbols; i++)
+		{
+			word = ((word << 1) | 1) & matcher->masks[symbols[i]];
 
-	PB_TRACE(errmsg("->sequence_strpos()"));
+			if (word & matcher->match_bit)
+			{
+				state[0] = word;
+				return i;
+			}
+		}
 
-	/* collect info about pattern */
-	search_str_info = get_sequence_info_text(search, PB_SEQUENCE_INFO_CASE_SENSITIVE);
+		state[0] = word;
+		return (-1);
+	}
 
-	/* terminate if pattern is longer than sequence */
-	if (search_str_info->sequence_length > seq->sequence_length || search_str_info->n_symbols > (seq->is_fixed ? fixed_codesets[seq->n_swapped_symbols]->n_symbols : seq->n_symbols))
+	for (i = 0; i < n_symbols; i++)
 	{
-		PB_TRACE(errmsg("<-sequence_strpos(): too short pl:%u sl:%u ps:%u ss:%u", search_str_info->sequence_length, seq->sequence_length, search_str_info->n_symbols, (seq->is_fixed ? fixed_codesets[seq->n_swapped_symbols]->n_symbols : seq->n_symbols)));
+		const uint64* mask = matcher->masks + symbols[i] * n_words;
+		int last = Min(matcher->last_active + 1, n_words - 1);
+		uint64 carry = 1;
+		int w;
 
-		return 0;
-	}
+		for (w = 0; w <= last; w++)
+		{
+			uint64 next_carry = state[w] >> 63;
 
-	/* terminate if pattern contains characters the sequence does not */
-	{
+			state[w] = ((state[w] << 1) | carry) & mask[w];
+			carry = next_carry;
+		}
+
+		while (last > 0 && state[last] == 0)
+			last--;
+		matcher->last_active = last;
+
+		if (state[n_words - 1] & matcher->match_bit)
+			return i;
+	}
+
+	return (-1);
+}
+
+/*
+ * sequence_strpos()
+ * 		Find position of given string.
+ * 		Baeza-Yates-Gonnet implementation, the pattern may have any
+ * 		length. The sequence is decoded into a buffer and searched
+ * 		block by block.
+ *
+ * 	PB_CompressedSequence* seq : detoasted sequence to search in
+ * 	Text* search : detoasted text to search for
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+uint32 sequence_strpos(PB_CompressedSequence* seq, text* search, PB_CodeSet** fixed_codesets)
+{
+	PB_ShiftAnd* matcher;
+	PB_SequenceInfo* search_str_info;
+	uint8 block[PB_STRPOS_BLOCK_SIZE];
+	int n_block = 0;
+	uint32 block_start = 0;
+	int match_end;
+
+	uint8 c;
+
+	PB_TRACE(errmsg("->sequence_strpos()"));
+
+	/* collect info about pattern */
+	search_str_info = get_sequence_info_text(search, PB_SEQUENCE_INFO_CASE_SENSITIVE);
+
+	/* terminate if pattern is longer than sequence */
+	if (search_str_info->sequence_length > seq->sequence_length || search_str_info->n_symbols > (seq->is_fixed ? fixed_codesets[seq->n_swapped_symbols]->n_symbols : seq->n_symbols))
+	{
+		PB_TRACE(errmsg("<-sequence_strpos(): too short pl:%u sl:%u ps:%u ss:%u", search_str_info->sequence_length, seq->sequence_length, search_str_info->n_symbols, (seq->is_fixed ? fixed_codesets[seq->n_swapped_symbols]->n_symbols : seq->n_symbols)));
+
+		PB_SEQUENCE_INFO_PFREE(search_str_info);
+		return 0;
+	}
+
+	/* an empty pattern is never found */
+	if (search_str_info->sequence_length == 0)
+	{
+		PB_SEQUENCE_INFO_PFREE(search_str_info);
+		return 0;
+	}
+
+	/* terminate if pattern contains characters the sequence does not */
+	{
 		int i = 0;
 		PB_Codeword* codewords = (seq->is_fixed ? fixed_codesets[seq->n_swapped_symbols]->words : PB_COMPRESSED_SEQUENCE_SYMBOL_POINTER(seq));
 		uint64 bitmap_high = 0;
@@ -388,156 +1058,967 @@ uint32 sequence_strpos(PB_CompressedSequence* seq, text* search, PB_CodeSet** fi
 		{
 			PB_TRACE(errmsg("<-sequence_strpos(): alphabet mismatch pl:%lu sl:%lu ph:%lu sh:%lu", search_str_info->ascii_bitmap_high, bitmap_high, search_str_info->ascii_bitmap_low, bitmap_low));
 
+			PB_SEQUENCE_INFO_PFREE(search_str_info);
 			return 0;
 		}
 	}
 
-	/*
-	 * Determine search window length
-	 */
-	if (search_str_info->sequence_length < search_vector_length)
-		search_vector_length = search_str_info->sequence_length;
+	matcher = shift_and_create((uint8*) VARDATA_ANY(search), search_str_info->sequence_length);
 
-	/*
-	 * Build specific vectors
-	 */
+	PB_BEGIN_DECODE((Varlena*) seq, 0, seq->sequence_length, fixed_codesets, (c)) {
+		block[n_block] = c;
+		n_block++;
+
+		if (n_block == PB_STRPOS_BLOCK_SIZE)
+		{
+			match_end = shift_and_find(matcher, block, n_block);
+
+			if (match_end >= 0)
+			{
+				uint32 result = block_start + match_end + 2 - matcher->pattern_length;
+
+				pfree(matcher);
+				PB_SEQUENCE_INFO_PFREE(search_str_info);
+
+				PB_TRACE(errmsg("<-sequence_strpos(): found at %u", result));
+
+				return result;
+			}
+
+			block_start += n_block;
+			n_block = 0;
+		}
+	} PB_END_DECODE
+
+	match_end = shift_and_find(matcher, block, n_block);
+	if (match_end >= 0)
+		match_end = block_start + match_end + 2 - matcher->pattern_length;
+	else
+		match_end = 0;
+
+	pfree(matcher);
+	PB_SEQUENCE_INFO_PFREE(search_str_info);
+
+	PB_TRACE(errmsg("<-sequence_strpos()"));
+
+	return match_end;
+}
+
+/**
+ * collect_matches()
+ * 		Searches a block of decoded symbols for all matches of a shift-and
+ * 		search. Adds their positions to a growing array, if given.
+ * 		Returns the new number of matches.
+ *
+ * 	PB_ShiftAnd* matcher : search state
+ * 	const uint8* block : decoded symbols
+ * 	int n_block : number of symbols
+ * 	uint32 block_start : position of first symbol, first is 0
+ * 	uint32** positions : growing array of positions or NULL
+ * 	uint32 n_matches : number of matches so far
+ * 	uint32* max_matches : allocated size of positions
+ */
+static uint32 collect_matches(PB_ShiftAnd* matcher,
+							  const uint8* block,
+							  int n_block,
+							  uint32 block_start,
+							  uint32** positions,
+							  uint32 n_matches,
+							  uint32* max_matches)
+{
+	int done = 0;
+	int match_end;
+
+	while ((match_end = shift_and_find(matcher, block + done, n_block - done)) >= 0)
 	{
-		uint64 position_bit = 1;
-		int i;
-		uint8* input_pointer = (uint8*) VARDATA_ANY(search);
+		done += match_end + 1;
 
-		specific_vectors = palloc0(sizeof(uint64) * PB_ASCII_SIZE);
+		if (positions != NULL)
+		{
+			if (n_matches == *max_matches)
+			{
+				*max_matches = Max(2 * *max_matches, 64);
+				*positions = (*positions == NULL) ?
+							 palloc(*max_matches * sizeof(uint32)) :
+							 repalloc(*positions, *max_matches * sizeof(uint32));
+			}
+			(*positions)[n_matches] = block_start + done + 1 - matcher->pattern_length;
+		}
+		n_matches++;
+	}
 
-		for (i = 0; i < search_vector_length; i++, input_pointer++)
+	return n_matches;
+}
+
+/**
+ * sequence_find_all()
+ * 		Finds all, possibly overlapping, occurrences of a pattern, that
+ * 		lie completely within a window of a sequence. The window is
+ * 		decoded in one pass, starting at the nearest index entry.
+ * 		Returns the number of occurrences.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence to search in
+ * 	text* search : detoasted text to search for
+ * 	uint32 from : first position of window, first is 1
+ * 	uint32 to : last position of window
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	uint32** positions : output for palloc'd positions, NULL to count only
+ */
+uint32 sequence_find_all(Varlena* raw_seq,
+						 text* search,
+						 uint32 from,
+						 uint32 to,
+						 PB_CodeSet** fixed_codesets,
+						 uint32** positions)
+{
+	PB_CompressedSequence* input_header;
+	PB_ShiftAnd* matcher;
+	uint32 pattern_length = VARSIZE_ANY_EXHDR(search);
+	uint8 block[PB_STRPOS_BLOCK_SIZE];
+	int n_block = 0;
+	uint32 block_start;
+	uint32 window_length;
+	uint32 n_matches = 0;
+	uint32 max_matches = 0;
+	uint8 c;
+
+	PB_TRACE(errmsg("->sequence_find_all()"));
+
+	if (positions != NULL)
+		*positions = NULL;
+
+	input_header = (PB_CompressedSequence*)
+				   PG_DETOAST_DATUM_SLICE(raw_seq, 0, 4);
+	if (to > input_header->sequence_length)
+		to = input_header->sequence_length;
+	if (from < 1)
+		from = 1;
+	pfree(input_header);
+
+	if (pattern_length == 0 || from > to || to - from + 1 < pattern_length)
+	{
+		PB_TRACE(errmsg("<-sequence_find_all(): window too short"));
+		return 0;
+	}
+
+	matcher = shift_and_create((uint8*) VARDATA_ANY(search), pattern_length);
+	block_start = from - 1;
+	window_length = to - from + 1;
+
+	PB_BEGIN_DECODE(raw_seq, block_start, window_length, fixed_codesets, (c)) {
+		block[n_block] = c;
+		n_block++;
+
+		if (n_block == PB_STRPOS_BLOCK_SIZE)
 		{
-			specific_vectors[*input_pointer] |= position_bit;
-			position_bit <<= 1;
+			n_matches = collect_matches(matcher, block, n_block, block_start,
+										positions, n_matches, &max_matches);
+			block_start += n_block;
+			n_block = 0;
 		}
-		match = position_bit >> 1;
+	} PB_END_DECODE
+
+	n_matches = collect_matches(matcher, block, n_block, block_start,
+								positions, n_matches, &max_matches);
+
+	pfree(matcher);
+
+	PB_TRACE(errmsg("<-sequence_find_all(): %u matches", n_matches));
+
+	return n_matches;
+}
+
+/**
+ * Number of stream words counted per detoasted slice.
+ */
+#define PB_COUNT_SLICE_WORDS	(PB_STREAM_SLICE_SIZE / PB_COMPRESSION_BUFFER_BYTE_SIZE)
+
+/**
+ * count_bits64()
+ * 		Returns the number of set bits of a stream word.
+ */
+static int count_bits64(uint64 word)
+{
+	word = word - ((word >> 1) & UINT64CONST(0x5555555555555555));
+	word = (word & UINT64CONST(0x3333333333333333)) + ((word >> 2) & UINT64CONST(0x3333333333333333));
+	word = (word + (word >> 4)) & UINT64CONST(0x0F0F0F0F0F0F0F0F);
+	return (int) ((word * UINT64CONST(0x0101010101010101)) >> 56);
+}
 
-		for (i = 0; i < PB_ASCII_SIZE; i++)
+/**
+ * count_packed_codes()
+ * 		Counts the codes of a range of a stream of codes of equal length
+ * 		1, 2, 4 or 8 without decoding it. Words completely inside the range
+ * 		are counted on bit-planes for code lengths 1 and 2, and byte-wise
+ * 		otherwise.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	int stream_offset : offset of the stream from the start of the sequence
+ * 	uint32 start : first symbol, first is 0
+ * 	uint32 length : number of symbols
+ * 	int code_length : length of all codes
+ * 	uint64* code_counts : output for counts of each code, 1 << code_length elements
+ */
+static void count_packed_codes(Varlena* raw_seq,
+							   int stream_offset,
+							   uint32 start,
+							   uint32 length,
+							   int code_length,
+							   uint64* code_counts)
+{
+	const uint64 high_bits = UINT64CONST(0xAAAAAAAAAAAAAAAA);
+	const uint64 code_mask = (1 << code_length) - 1;
+	uint64 byte_counts[256];
+	uint64 bit_start = (uint64) start * code_length;
+	uint64 bit_end = (uint64) (start + length) * code_length;
+	uint64 first_word = bit_start / PB_COMPRESSION_BUFFER_BIT_SIZE;
+	uint64 end_word = (bit_end + PB_COMPRESSION_BUFFER_BIT_SIZE - 1) / PB_COMPRESSION_BUFFER_BIT_SIZE;
+	uint64 slice_word;
+	int i;
+
+	memset(byte_counts, 0, sizeof(byte_counts));
+
+	for (slice_word = first_word; slice_word < end_word; slice_word += PB_COUNT_SLICE_WORDS)
+	{
+		int n_words = (int) Min(PB_COUNT_SLICE_WORDS, end_word - slice_word);
+		Varlena* slice = (Varlena*)
+						 PG_DETOAST_DATUM_SLICE(raw_seq,
+												stream_offset - VARHDRSZ + slice_word * PB_COMPRESSION_BUFFER_BYTE_SIZE,
+												n_words * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+		PB_CompressionBuffer* words = (PB_CompressionBuffer*) VARDATA(slice);
+
+		for (i = 0; i < n_words; i++)
 		{
-			if (specific_vectors[i]) {
-				PB_DEBUG2(errmsg("%c: %lx", i, specific_vectors[i]));
+			PB_CompressionBuffer word = words[i];
+			uint64 word_start = (slice_word + i) * PB_COMPRESSION_BUFFER_BIT_SIZE;
+
+			if (word_start < bit_start || word_start + PB_COMPRESSION_BUFFER_BIT_SIZE > bit_end)
+			{
+				/* partial word at the edges of the range */
+				uint64 bit = Max(bit_start, word_start);
+				uint64 end = Min(bit_end, word_start + PB_COMPRESSION_BUFFER_BIT_SIZE);
+
+				for (; bit < end; bit += code_length)
+					code_counts[(word >> (PB_COMPRESSION_BUFFER_BIT_SIZE - (bit - word_start) - code_length)) & code_mask]++;
+			}
+			else if (code_length == 1)
+			{
+				int ones = count_bits64(word);
+
+				code_counts[1] += ones;
+				code_counts[0] += PB_COMPRESSION_BUFFER_BIT_SIZE - ones;
+			}
+			else if (code_length == 2)
+			{
+				uint64 high = word & high_bits;
+				uint64 low = (word << 1) & high_bits;
+				int n_both = count_bits64(high & low);
+				int n_high = count_bits64(high) - n_both;
+				int n_low = count_bits64(low) - n_both;
+
+				code_counts[3] += n_both;
+				code_counts[2] += n_high;
+				code_counts[1] += n_low;
+				code_counts[0] += PB_COMPRESSION_BUFFER_BIT_SIZE / 2 - n_both - n_high - n_low;
+			}
+			else
+			{
+				int shift;
+
+				for (shift = 0; shift < PB_COMPRESSION_BUFFER_BIT_SIZE; shift += 8)
+					byte_counts[(word >> shift) & 0xFF]++;
 			}
 		}
 
-		PB_DEBUG2(errmsg("match:%lx", match));
+		pfree(slice);
 	}
 
-	PB_BEGIN_DECODE((Varlena*) seq, 0, seq->sequence_length, fixed_codesets, (c)) {
-		/*
-		 * Extend partial matches
-		 */
-		if (first_match) {
-			PB_PartialMatch* current = first_match;
-			last_match = NULL;
-
-			while (1) {
-				uint8* search_str = (uint8*) VARDATA(search) + current->len;
-
-				if (*search_str == c)
-				{
-					/* extend match */
-					current->len++;
-					last_match = current;
-
-					/* check if match long enough to terminate */
-					if (current->len == search_str_info->sequence_length)
-					{
-						int result = current->pos;
-
-						/* free all matches */
-						while (first_match) {
-							PB_PartialMatch* next = first_match->next;
-							pfree(first_match);
-							first_match = next;
-						}
-
-						pfree(specific_vectors);
-						PB_SEQUENCE_INFO_PFREE(search_str_info);
-
-						return result;
-					}
-
-					/* go to next in list */
-					if (current->next)
-						current = current->next;
-					else
-						break;
-				}
-				else
-				{
-					/* delete match */
-					if (current->next)
-					{
-						/* current has predecessor in list */
-						PB_PartialMatch* next = current->next;
-
-						if (current == first_match)
-							first_match = next;
-						else
-							last_match->next = next;
-
-						pfree(current);
-
-						current = next;
-					}
-					else
-					{
-						/* current is last element in list */
-						if (current == first_match)
-							first_match = NULL;
-
-						pfree(current);
-
-						break;
-					}
-				}
+	if (code_length > 2)
+	{
+		int shift;
+
+		for (i = 0; i < 256; i++)
+			if (byte_counts[i] > 0)
+				for (shift = 0; shift < 8; shift += code_length)
+					code_counts[(i >> shift) & code_mask] += byte_counts[i];
+	}
+}
+
+/**
+ * count_range()
+ * 		Adds the counts of the symbols of a range of a sequence. Streams
+ * 		of codes of equal length 1, 2, 4 or 8 without swapping and RLE are
+ * 		counted on the packed words, others are decoded without storing
+ * 		symbols.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	PB_CompressedSequence* header : header of the sequence
+ * 	PB_CodeSet* codeset : code of the sequence
+ * 	uint32 start : first symbol, first is 0
+ * 	uint32 length : number of symbols
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	uint64* counts : counts of each symbol, PB_SOURCE_ALPHABET_SIZE elements
+ */
+static void count_range(Varlena* raw_seq,
+						PB_CompressedSequence* header,
+						PB_CodeSet* codeset,
+						uint32 start,
+						uint32 length,
+						PB_CodeSet** fixed_codesets,
+						uint64* counts)
+{
+	const int code_length = codeset->words[0].code_length;
+	uint8 c;
+
+	if (length == 0)
+		return;
+
+	if (codeset->has_equal_length &&
+		codeset->n_swapped_symbols == 0 &&
+		!codeset->uses_rle &&
+		code_length > 0 &&
+		8 % code_length == 0)
+	{
+		const PB_DecodingMap* map;
+		const PB_DecodingMap* swap_map;
+		uint64 code_counts[256];
+		int code;
+
+		memset(code_counts, 0, sizeof(code_counts));
+		count_packed_codes(raw_seq,
+						   PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(header),
+						   start,
+						   length,
+						   code_length,
+						   code_counts);
+
+		get_decoding_maps(codeset, &map, &swap_map);
+		for (code = 0; code < (1 << code_length); code++)
+			if (code_counts[code] > 0)
+				counts[map[(uint8) (code << (8 - code_length))].symbol] += code_counts[code];
+	}
+	else
+	{
+		PB_BEGIN_DECODE(raw_seq, start, length, fixed_codesets, c) {
+			counts[c]++;
+		} PB_END_DECODE
+	}
+}
+
+/**
+ * count_summarized_parts()
+ * 		Adds the counts of the symbols of a range of complete index
+ * 		parts, taken from two rows of the composition summary.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	PB_CompressedSequence* header : header of the sequence
+ * 	PB_CodeSet* codeset : code of the sequence
+ * 	uint32 first_part : first part of the range
+ * 	uint32 end_part : part after the range
+ * 	uint64* counts : counts of each symbol, PB_SOURCE_ALPHABET_SIZE elements
+ */
+static void count_summarized_parts(Varlena* raw_seq,
+								   PB_CompressedSequence* header,
+								   PB_CodeSet* codeset,
+								   uint32 first_part,
+								   uint32 end_part,
+								   uint64* counts)
+{
+	const int n_words = header->n_summary_symbols;
+	const int row_size = n_words * sizeof(uint32);
+	const int summary_offset = PB_COMPRESSED_SEQUENCE_SUMMARY_OFFSET(header) - VARHDRSZ;
+	Varlena* end_row;
+	Varlena* first_row = NULL;
+	uint32* end_counts;
+	uint32* first_counts = NULL;
+	int i;
+
+	end_row = (Varlena*) PG_DETOAST_DATUM_SLICE(raw_seq,
+												summary_offset + (end_part - 1) * row_size,
+												row_size);
+	end_counts = (uint32*) VARDATA(end_row);
+
+	if (first_part > 0)
+	{
+		first_row = (Varlena*) PG_DETOAST_DATUM_SLICE(raw_seq,
+													  summary_offset + (first_part - 1) * row_size,
+													  row_size);
+		first_counts = (uint32*) VARDATA(first_row);
+	}
+
+	for (i = 0; i < n_words; i++)
+		counts[codeset->words[i].symbol] += end_counts[i] - (first_counts == NULL ? 0 : first_counts[i]);
+
+	pfree(end_row);
+	if (first_row != NULL)
+		pfree(first_row);
+}
+
+/**
+ * sequence_count_symbols()
+ * 		Counts the symbols of a range of a sequence. The symbols of the
+ * 		whole sequence are taken from the composition, if it is included.
+ * 		Complete parts of PB_INDEX_PART_SIZE symbols inside the range are
+ * 		counted from the composition summary, if the sequence has one, so
+ * 		that only the symbols at the edges of the range are read.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	uint32 start : first symbol, first is 0
+ * 	uint32 length : number of symbols
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	uint64* counts : output for counts of each symbol, PB_SOURCE_ALPHABET_SIZE elements
+ */
+void sequence_count_symbols(Varlena* raw_seq,
+							uint32 start,
+							uint32 length,
+							PB_CodeSet** fixed_codesets,
+							uint64* counts)
+{
+	PB_CompressedSequence* header;
+	PB_CodeSet* codeset;
+	uint32 first_part = 0;
+	uint32 end_part = 0;
+
+	PB_TRACE(errmsg("->sequence_count_symbols()"));
+
+	memset(counts, 0, PB_SOURCE_ALPHABET_SIZE * sizeof(uint64));
+
+	header = get_code_header(raw_seq);
+	if (start >= header->sequence_length)
+		length = 0;
+	else if (length > header->sequence_length - start)
+		length = header->sequence_length - start;
+
+	if (length == 0)
+	{
+		pfree(header);
+		PB_TRACE(errmsg("<-sequence_count_symbols(): empty range"));
+		return;
+	}
+
+	if (header->is_fixed)
+		codeset = fixed_codesets[header->n_swapped_symbols];
+	else
+	{
+		codeset = palloc0(sizeof(PB_CodeSet) + header->n_symbols * sizeof(PB_Codeword));
+		codeset->n_symbols = header->n_symbols;
+		codeset->n_swapped_symbols = header->n_swapped_symbols;
+		codeset->is_fixed = false;
+		codeset->has_equal_length = header->has_equal_length;
+		codeset->uses_rle = header->uses_rle;
+		memcpy(codeset->words, header->data,
+			   header->n_symbols * sizeof(PB_Codeword));
+	}
+
+	if (header->has_composition &&
+		header->n_summary_symbols <= codeset->n_symbols &&
+		start == 0 &&
+		length == header->sequence_length)
+	{
+		Varlena* composition = (Varlena*)
+							   PG_DETOAST_DATUM_SLICE(raw_seq,
+													  PB_COMPRESSED_SEQUENCE_COMPOSITION_OFFSET(header) - VARHDRSZ,
+													  PB_COMPRESSED_SEQUENCE_COMPOSITION_SIZE(header));
+		uint32* word_counts = (uint32*) VARDATA(composition);
+		int i;
+
+		for (i = 0; i < header->n_summary_symbols; i++)
+			counts[codeset->words[i].symbol] += word_counts[i];
+
+		pfree(composition);
+		if (!header->is_fixed)
+			pfree(codeset);
+		pfree(header);
+
+		PB_TRACE(errmsg("<-sequence_count_symbols(): from composition"));
+		return;
+	}
+
+	if (header->n_summary_symbols > 0 && header->n_summary_symbols <= codeset->n_symbols)
+	{
+		first_part = (start + PB_INDEX_PART_SIZE - 1) / PB_INDEX_PART_SIZE;
+		end_part = (start + length) / PB_INDEX_PART_SIZE;
+	}
+
+	if (end_part > first_part)
+	{
+		PB_DEBUG1(errmsg("sequence_count_symbols(): parts %u to %u from summary", first_part, end_part - 1));
+
+		count_summarized_parts(raw_seq, header, codeset, first_part, end_part, counts);
+		count_range(raw_seq, header, codeset,
+					start, first_part * PB_INDEX_PART_SIZE - start,
+					fixed_codesets, counts);
+		count_range(raw_seq, header, codeset,
+					end_part * PB_INDEX_PART_SIZE, start + length - end_part * PB_INDEX_PART_SIZE,
+					fixed_codesets, counts);
+	}
+	else
+		count_range(raw_seq, header, codeset, start, length, fixed_codesets, counts);
+
+	if (!header->is_fixed)
+		pfree(codeset);
+	pfree(header);
+
+	PB_TRACE(errmsg("<-sequence_count_symbols()"));
+}
+
+/**
+ * sequence_range_args()
+ * 		Reads optional start and length arguments like substr().
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the calling function
+ * 	int start_arg : number of the start argument
+ * 	uint32* start : output for the first symbol
+ * 	uint32* length : output for the number of symbols
+ */
+void sequence_range_args(FunctionCallInfo fcinfo, int start_arg, uint32* start, uint32* length)
+{
+	int64 from;
+	int64 len;
+
+	*start = 0;
+	*length = PG_UINT32_MAX;
+
+	if (PG_NARGS() < start_arg + 2)
+		return;
+
+	/*
+	 * SQL's first position is 1, our first position is 0
+	 */
+	from = (int64) PG_GETARG_INT32(start_arg) - 1;
+	len = PG_GETARG_INT32(start_arg + 1);
+
+	if (len < 0)
+		ereport(ERROR,(errmsg("negative substring length not allowed")));
+
+	if (from < 0)
+	{
+		len += from;
+		from = 0;
+	}
+
+	*start = (uint32) from;
+	*length = (uint32) Max(len, 0);
+}
+
+/**
+ * sequence_gc_content()
+ * 		Returns the fraction of G and C in a range of a sequence.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	uint32 start : first symbol, first is 0
+ * 	uint32 length : number of symbols
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+float4 sequence_gc_content(Varlena* raw_seq, uint32 start, uint32 length, PB_CodeSet** fixed_codesets)
+{
+	uint64 counts[PB_SOURCE_ALPHABET_SIZE];
+	uint64 n_symbols = 0;
+	int i;
+
+	sequence_count_symbols(raw_seq, start, length, fixed_codesets, counts);
+
+	for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+		n_symbols += counts[i];
+
+	if (n_symbols == 0)
+		return 0.0;
+
+	return (float4) ((double) (counts['G'] + counts['C']) / n_symbols);
+}
+
+/**
+ * sequence_entropy()
+ * 		Returns the Shannon entropy of the symbols of a sequence in bits.
+ *
+ * 	Varlena* raw_seq : possibly toasted sequence
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+float4 sequence_entropy(Varlena* raw_seq, PB_CodeSet** fixed_codesets)
+{
+	uint64 counts[PB_SOURCE_ALPHABET_SIZE];
+	uint64 length = 0;
+	double result = 0.0;
+	int i;
+
+	sequence_count_symbols(raw_seq, 0, PG_UINT32_MAX, fixed_codesets, counts);
+
+	for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+		length += counts[i];
+
+	for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+	{
+		if (counts[i] > 0)
+		{
+			double p = (double) counts[i] / length;
+
+			result -= p * log2(p);
+		}
+	}
+
+	return (float4) result;
+}
+
+/**
+ * sequence_symbol_counts()
+ * 		Set returning function, that returns each symbol of a sequence
+ * 		with its number of occurrences in ascending symbol order.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the calling function
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+Datum sequence_symbol_counts(FunctionCallInfo fcinfo, PB_CodeSet** fixed_codesets)
+{
+	FuncCallContext* funcctx;
+	uint64* counts;
+	uint8* symbols;
+	Datum values[2];
+	bool nulls[2];
+	HeapTuple tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc tuple_desc;
+		uint64 all_counts[PB_SOURCE_ALPHABET_SIZE];
+		uint32 start;
+		uint32 length;
+		int i;
+
+		PB_TRACE(errmsg("->sequence_symbol_counts()"));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tuple_desc) != TYPEFUNC_COMPOSITE)
+			ereport(ERROR,(errmsg("function returning record called in context that cannot accept type record")));
+		funcctx->tuple_desc = BlessTupleDesc(tuple_desc);
+
+		sequence_range_args(fcinfo, 1, &start, &length);
+		sequence_count_symbols((Varlena*) PG_GETARG_RAW_VARLENA_P(0), start, length, fixed_codesets, all_counts);
+
+		/* store symbols followed by their counts */
+		counts = palloc(PB_SOURCE_ALPHABET_SIZE * (sizeof(uint64) + sizeof(uint8)));
+		symbols = (uint8*) (counts + PB_SOURCE_ALPHABET_SIZE);
+		funcctx->max_calls = 0;
+		for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+		{
+			if (all_counts[i] > 0)
+			{
+				symbols[funcctx->max_calls] = i;
+				counts[funcctx->max_calls] = all_counts[i];
+				funcctx->max_calls++;
 			}
 		}
+		funcctx->user_fctx = counts;
 
-		/* shift-and */
-		search_vector = ((search_vector << 1) | 1) & specific_vectors[c];
-		pos++;
+		MemoryContextSwitchTo(oldcontext);
 
-		PB_DEBUG3(errmsg("pos: %u, c:%c sv:%lx", pos, c, search_vector));
+		PB_TRACE(errmsg("<-sequence_symbol_counts()"));
+	}
 
-		if ((search_vector & match) && pos >= search_vector_length)
+	funcctx = SRF_PERCALL_SETUP();
+	counts = (uint64*) funcctx->user_fctx;
+	symbols = (uint8*) (counts + PB_SOURCE_ALPHABET_SIZE);
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		memset(nulls, 0, sizeof(nulls));
+		values[0] = PointerGetDatum(cstring_to_text_with_len((char*) &symbols[funcctx->call_cntr], 1));
+		values[1] = Int64GetDatum(counts[funcctx->call_cntr]);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/**
+ * check_concat_length()
+ * 		Raises an error if the concatenation of two sequences is too long.
+ *
+ * 	uint64 length : length of the concatenation
+ */
+static void check_concat_length(uint64 length)
+{
+	if (length >= PB_MAX_INPUT_SEQUENCE_LENGTH)
+	{
+		ereport(ERROR,(errmsg("input sequence violates length constraints"),
+				errdetail("Maximum is %ld characters. This sequence has %ld characters,",
+						  PB_MAX_INPUT_SEQUENCE_LENGTH, (long) length)));
+	}
+}
+
+/**
+ * sequence_concat()
+ * 		Appends a sequence to another one without decoding the first one,
+ * 		if both were compressed with the same case insensitive fixed
+ * 		code. The stream of
+ * 		the second sequence is shifted onto the end of the first stream.
+ * 		Index entries and composition summary rows are copied from the
+ * 		first sequence and only computed for the appended part. The
+ * 		result keeps the composition and index density of the first
+ * 		sequence.
+ *
+ * 	Returns NULL if the sequences use different codes, a case sensitive
+ * 	code, or the summary of the first sequence does not match its code.
+ * 	Then the decoded sequences have to be compressed again, which folds
+ * 	case.
+ *
+ * 	Varlena* raw_seq1 : possibly toasted first sequence
+ * 	Varlena* raw_seq2 : possibly toasted second sequence
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+PB_CompressedSequence* sequence_concat(Varlena* raw_seq1, Varlena* raw_seq2, PB_CodeSet** fixed_codesets)
+{
+	PB_CompressedSequence* header1;
+	PB_CompressedSequence* header2;
+	PB_CompressedSequence* seq1;
+	PB_CompressedSequence* seq2;
+	PB_CompressedSequence* result;
+	PB_CodeSet* codeset;
+	PB_CompressionBuffer* stream;
+	PB_CompressionBuffer* stream2;
+	PB_IndexEntry* index;
+	uint8* summary;
+	uint64 counts[PB_SOURCE_ALPHABET_SIZE];
+	uint64 counts2[PB_SOURCE_ALPHABET_SIZE];
+	uint8 code_lengths[PB_SOURCE_ALPHABET_SIZE];
+	uint32 row[PB_SOURCE_ALPHABET_SIZE];
+	uint32 length1;
+	uint32 length2;
+	uint32 part_size;
+	uint32 n_parts1;
+	uint32 n_parts;
+	uint32 n_rows1;
+	uint64 bits1 = 0;
+	uint64 bits2 = 0;
+	uint64 stream_bits;
+	uint64 n_words;
+	uint64 n_words2;
+	uint64 first_word;
+	uint32 compressed_size;
+	int shift;
+	uint64 i;
+	int j;
+	uint8 c;
+
+	PB_TRACE(errmsg("->sequence_concat()"));
+
+	header1 = (PB_CompressedSequence*)
+			  PG_DETOAST_DATUM_SLICE(raw_seq1, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+	header2 = (PB_CompressedSequence*)
+			  PG_DETOAST_DATUM_SLICE(raw_seq2, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+
+	length1 = header1->sequence_length;
+	length2 = header2->sequence_length;
+	check_concat_length((uint64) length1 + length2);
+
+	part_size = PB_COMPRESSED_SEQUENCE_INDEX_PART_SIZE(header1);
+	n_parts1 = length1 / part_size;
+	n_parts = (length1 + length2) / part_size;
+	n_rows1 = length1 / PB_INDEX_PART_SIZE;
+
+	if (!header1->is_fixed ||
+		!header2->is_fixed ||
+		header1->n_swapped_symbols != header2->n_swapped_symbols ||
+		!fixed_codesets[header1->n_swapped_symbols]->ignore_case ||
+		(n_rows1 > 0 &&
+		 header1->n_summary_symbols != PB_SUMMARY_N_SYMBOLS(fixed_codesets[header1->n_swapped_symbols],
+															header1->has_composition)))
+	{
+		pfree(header1);
+		pfree(header2);
+
+		PB_TRACE(errmsg("<-sequence_concat(): different codes"));
+		return NULL;
+	}
+
+	codeset = fixed_codesets[header1->n_swapped_symbols];
+
+	/*
+	 * The sizes of both streams follow from the symbol counts, which
+	 * are read from the composition or the composition summary.
+	 */
+	sequence_count_symbols(raw_seq1, 0, length1, fixed_codesets, counts);
+	sequence_count_symbols(raw_seq2, 0, length2, fixed_codesets, counts2);
+
+	memset(code_lengths, 0, sizeof(code_lengths));
+	for (j = 0; j < codeset->n_symbols; j++)
+		code_lengths[codeset->words[j].symbol] = codeset->words[j].code_length;
+
+	for (j = 0; j < PB_SOURCE_ALPHABET_SIZE; j++)
+	{
+		bits1 += counts[j] * code_lengths[j];
+		bits2 += counts2[j] * code_lengths[j];
+	}
+
+	stream_bits = bits1 + bits2;
+	stream_bits = PB_ALIGN_BIT_SIZE(stream_bits);
+	n_words = stream_bits / PB_COMPRESSION_BUFFER_BIT_SIZE;
+
+	compressed_size = get_stream_offset(length1 + length2,
+										codeset,
+										header1->has_composition,
+										header1->index_shift);
+	compressed_size += stream_bits / 8;
+
+	result = palloc0(compressed_size);
+	SET_VARSIZE(result, compressed_size);
+	result->sequence_length = length1 + length2;
+	result->is_fixed = true;
+	result->n_symbols = 0;
+	result->n_swapped_symbols = codeset->fixed_id;
+	result->has_equal_length = codeset->has_equal_length;
+	result->uses_rle = false;
+	result->has_index = !codeset->has_equal_length && n_parts > 0;
+	result->has_composition = header1->has_composition;
+	result->index_shift = header1->index_shift;
+	result->n_summary_symbols = PB_SUMMARY_N_SYMBOLS(codeset, header1->has_composition);
+
+	PB_DEBUG1(errmsg("sequence_concat(): fixed code id %u, appending %lu bits to %lu bits",
+					 codeset->fixed_id, (unsigned long) bits2, (unsigned long) bits1));
+
+	seq1 = (PB_CompressedSequence*) PG_DETOAST_DATUM(raw_seq1);
+	seq2 = (PB_CompressedSequence*) PG_DETOAST_DATUM(raw_seq2);
+
+	/*
+	 * Copy the first stream and shift the second one onto its end.
+	 * Unused bits of the last block of a stream are always zero.
+	 */
+	stream = PB_COMPRESSED_SEQUENCE_STREAM_POINTER(result);
+	stream2 = PB_COMPRESSED_SEQUENCE_STREAM_POINTER(seq2);
+	n_words2 = PB_ALIGN_BIT_SIZE(bits2);
+	n_words2 /= PB_COMPRESSION_BUFFER_BIT_SIZE;
+	first_word = bits1 / PB_COMPRESSION_BUFFER_BIT_SIZE;
+	shift = bits1 % PB_COMPRESSION_BUFFER_BIT_SIZE;
+
+	memcpy(stream,
+		   PB_COMPRESSED_SEQUENCE_STREAM_POINTER(seq1),
+		   (first_word + (shift > 0 ? 1 : 0)) * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+
+	if (shift == 0)
+		memcpy(stream + first_word, stream2, n_words2 * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+	else
+	{
+		for (i = 0; i < n_words2; i++)
 		{
-			PB_DEBUG2(errmsg("found partial match at pos %u", pos));
+			stream[first_word + i] |= stream2[i] >> shift;
+			if (first_word + i + 1 < n_words)
+				stream[first_word + i + 1] = stream2[i] << (PB_COMPRESSION_BUFFER_BIT_SIZE - shift);
+		}
+	}
 
-			/* partial match found */
-			if (search_str_info->sequence_length > search_vector_length)
-			{
-				/* add partial match to end of list */
-				PB_PartialMatch* new_match = palloc0(sizeof(PB_PartialMatch));
+	if (result->has_composition)
+	{
+		for (j = 0; j < codeset->n_symbols; j++)
+			row[j] = counts[codeset->words[j].symbol] + counts2[codeset->words[j].symbol];
+
+		memcpy(((uint8*) result) + PB_COMPRESSED_SEQUENCE_COMPOSITION_OFFSET(result),
+			   row,
+			   PB_COMPRESSED_SEQUENCE_COMPOSITION_SIZE(result));
+	}
+
+	index = PB_COMPRESSED_SEQUENCE_INDEX_POINTER(result);
+	summary = ((uint8*) result) + PB_COMPRESSED_SEQUENCE_SUMMARY_OFFSET(result);
 
-				new_match->pos = pos - search_vector_length + 1;
-				new_match->len = (uint32) search_vector_length;
+	if (index != NULL && n_parts1 > 0)
+		memcpy(index,
+			   ((uint8*) seq1) + PB_COMPRESSED_SEQUENCE_INDEX_OFFSET(seq1),
+			   n_parts1 * sizeof(PB_IndexEntry));
 
-				if (last_match)
-					last_match->next = new_match;
-				else
-					last_match = new_match;
+	if (result->n_summary_symbols > 0 && n_rows1 > 0)
+		memcpy(summary,
+			   ((uint8*) seq1) + PB_COMPRESSED_SEQUENCE_SUMMARY_OFFSET(seq1),
+			   PB_SUMMARY_SIZE(length1, codeset->n_symbols));
 
-				if (!first_match)
-					first_match = new_match;
+	/*
+	 * Walk through the appended symbols up to the last complete part
+	 * to set the index entries and the composition summary rows. Index
+	 * parts divide PB_INDEX_PART_SIZE, so the last complete part is not
+	 * before the last complete summary row.
+	 */
+	if (n_parts > n_parts1 && (index != NULL || result->n_summary_symbols > 0))
+	{
+		uint64 position = length1;
+		uint64 bits = bits1;
+		const uint32 row_size = codeset->n_symbols * sizeof(uint32);
+
+		PB_BEGIN_DECODE((Varlena*) seq2, 0, n_parts * part_size - length1, fixed_codesets, c) {
+			if (index != NULL && (position + 1) % part_size == 0)
+			{
+				index[(position + 1) / part_size - 1].block = bits / PB_COMPRESSION_BUFFER_BIT_SIZE;
+				index[(position + 1) / part_size - 1].bit = bits % PB_COMPRESSION_BUFFER_BIT_SIZE;
 			}
-			else
+
+			counts[c]++;
+			bits += code_lengths[c];
+			position++;
+
+			if (result->n_summary_symbols > 0 && position % PB_INDEX_PART_SIZE == 0)
 			{
-				/* partial match is indeed full match */
-				pfree(specific_vectors);
-				PB_SEQUENCE_INFO_PFREE(search_str_info);
-				return pos - search_vector_length + 1;
+				for (j = 0; j < codeset->n_symbols; j++)
+					row[j] = counts[codeset->words[j].symbol];
+
+				memcpy(summary + (position / PB_INDEX_PART_SIZE - 1) * row_size, row, row_size);
 			}
-		}
-	} PB_END_DECODE
+		} PB_END_DECODE
+	}
 
-	pfree(specific_vectors);
-	PB_SEQUENCE_INFO_PFREE(search_str_info);
+	if ((Pointer) seq1 != (Pointer) raw_seq1)
+		pfree(seq1);
+	if ((Pointer) seq2 != (Pointer) raw_seq2)
+		pfree(seq2);
+	pfree(header1);
+	pfree(header2);
 
-	PB_TRACE(errmsg("<-sequence_strpos()"));
+	PB_TRACE(errmsg("<-sequence_concat()"));
 
-	return 0;
+	return result;
+}
+
+/**
+ * sequence_concat_decoded()
+ * 		Decodes two sequences into a single null-terminated buffer.
+ *
+ * 	Varlena* raw_seq1 : possibly toasted first sequence
+ * 	Varlena* raw_seq2 : possibly toasted second sequence
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ * 	uint32* length : output for the length of the concatenation
+ */
+uint8* sequence_concat_decoded(Varlena* raw_seq1,
+							   Varlena* raw_seq2,
+							   PB_CodeSet** fixed_codesets,
+							   uint32* length)
+{
+	PB_CompressedSequence* header1;
+	PB_CompressedSequence* header2;
+	uint8* result;
+	uint32 length1;
+	uint32 length2;
+
+	header1 = (PB_CompressedSequence*)
+			  PG_DETOAST_DATUM_SLICE(raw_seq1, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+	header2 = (PB_CompressedSequence*)
+			  PG_DETOAST_DATUM_SLICE(raw_seq2, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+
+	length1 = header1->sequence_length;
+	length2 = header2->sequence_length;
+	check_concat_length((uint64) length1 + length2);
+
+	result = palloc((uint64) length1 + length2 + 1);
+	if (length1 > 0)
+		decode(raw_seq1, result, 0, length1, fixed_codesets);
+	if (length2 > 0)
+		decode(raw_seq2, result + length1, 0, length2, fixed_codesets);
+	result[length1 + length2] = '\0';
+
+	*length = length1 + length2;
+
+	pfree(header1);
+	pfree(header2);
+
+	return result;
 }
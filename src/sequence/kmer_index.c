@@ -0,0 +1,315 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   src/sequence/kmer_index.c
+*
+*-------------------------------------------------------------------------
+*/
+#include <stdlib.h>
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/gin.h"
+#include "access/skey.h"
+#include "access/tuptoaster.h"
+
+#include "sequence/sequence.h"
+#include "sequence/decompression_iteration.h"
+#include "utils/debug.h"
+
+#include "sequence/kmer_index.h"
+
+/**
+ * kmer_code()
+ * 		Returns the 2 bit code of a nucleotide or (-1), if the symbol
+ * 		is not part of any k-mer.
+ */
+static int kmer_code(uint8 c)
+{
+	switch (c)
+	{
+		case 'A':
+		case 'a':
+			return 0;
+		case 'C':
+		case 'c':
+			return 1;
+		case 'G':
+		case 'g':
+			return 2;
+		case 'T':
+		case 't':
+			return 3;
+		default:
+			return (-1);
+	}
+}
+
+/**
+ * compare_kmers()
+ * 		qsort comparator for packed k-mers.
+ */
+static int compare_kmers(const void* a, const void* b)
+{
+	int32 kmer_a = *((const int32*) a);
+	int32 kmer_b = *((const int32*) b);
+
+	if (kmer_a < kmer_b)
+		return (-1);
+	if (kmer_a > kmer_b)
+		return 1;
+	return 0;
+}
+
+/**
+ * kmers_to_entries()
+ * 		Sorts k-mers, removes duplicates and converts them to GIN
+ * 		entries. Frees the k-mers.
+ *
+ * 	int32* kmers : packed k-mers
+ * 	int32 n_kmers : number of k-mers
+ * 	int32* n_entries : output for number of entries
+ */
+static Datum* kmers_to_entries(int32* kmers, int32 n_kmers, int32* n_entries)
+{
+	Datum* entries;
+	int32 i;
+	int32 n = 0;
+
+	*n_entries = 0;
+
+	if (n_kmers == 0)
+	{
+		pfree(kmers);
+		return NULL;
+	}
+
+	qsort(kmers, n_kmers, sizeof(int32), compare_kmers);
+
+	entries = palloc(sizeof(Datum) * n_kmers);
+	for (i = 0; i < n_kmers; i++)
+	{
+		if (i == 0 || kmers[i] != kmers[i - 1])
+		{
+			entries[n] = Int32GetDatum(kmers[i]);
+			n++;
+		}
+	}
+
+	pfree(kmers);
+
+	*n_entries = n;
+	return entries;
+}
+
+/**
+ * kmer_bitmap_to_entries()
+ * 		Converts the set bits of a k-mer bitmap to GIN entries. Set bits
+ * 		in ascending order are the sorted distinct k-mers. Frees the
+ * 		bitmap.
+ *
+ * 	uint8* kmer_bitmap : one bit per possible k-mer
+ * 	uint32 bitmap_size : size of the bitmap in bytes
+ * 	int32 n_kmers : number of set bits
+ * 	int32* n_entries : output for number of entries
+ */
+static Datum* kmer_bitmap_to_entries(uint8* kmer_bitmap,
+									 uint32 bitmap_size,
+									 int32 n_kmers,
+									 int32* n_entries)
+{
+	Datum* entries;
+	uint32 i;
+	int j;
+
+	*n_entries = 0;
+
+	if (n_kmers == 0)
+	{
+		pfree(kmer_bitmap);
+		return NULL;
+	}
+
+	entries = palloc(sizeof(Datum) * n_kmers);
+	for (i = 0; i < bitmap_size && *n_entries < n_kmers; i++)
+	{
+		if (kmer_bitmap[i] == 0)
+			continue;
+
+		for (j = 0; j < 8; j++)
+		{
+			if (kmer_bitmap[i] & (1 << j))
+			{
+				entries[*n_entries] = Int32GetDatum((int32) (i * 8 + j));
+				(*n_entries)++;
+			}
+		}
+	}
+
+	pfree(kmer_bitmap);
+
+	return entries;
+}
+
+/**
+ * kmer_gin_extract_value()
+ * 		GIN extractValue support for nucleotide sequences.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the support function
+ * 	int k : k-mer length, at most PB_KMER_MAX_LENGTH
+ * 	PB_CodeSet** fixed_codesets : fixed codes
+ */
+Datum kmer_gin_extract_value(FunctionCallInfo fcinfo, int k, PB_CodeSet** fixed_codesets)
+{
+	Varlena* raw_seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+	int32* n_entries = (int32*) PG_GETARG_POINTER(1);
+	PB_CompressedSequence* input_header;
+	uint32 length;
+	int32* kmers = NULL;
+	uint8* kmer_bitmap = NULL;
+	uint32 bitmap_size = ((((uint32) 1) << (2 * k)) + 7) / 8;
+	int32 n_kmers = 0;
+	uint32 kmer = 0;
+	uint32 mask = (((uint32) 1) << (2 * k)) - 1;
+	int n_valid = 0;
+	uint8 c;
+
+	PB_TRACE(errmsg("->kmer_gin_extract_value()"));
+
+	input_header = (PB_CompressedSequence*)
+				   PG_DETOAST_DATUM_SLICE(raw_seq, 0, 4);
+	length = input_header->sequence_length;
+	pfree(input_header);
+
+	if (length < (uint32) k)
+	{
+		*n_entries = 0;
+		PG_RETURN_POINTER(NULL);
+	}
+
+	/*
+	 * Sequences of at least as many symbols as the bitmap of all 4^k
+	 * k-mers has bytes mark their k-mers in the bitmap, which needs no
+	 * sort. Shorter sequences collect their k-mers in an array.
+	 */
+	if (length >= bitmap_size)
+		kmer_bitmap = palloc0(bitmap_size);
+	else
+		kmers = palloc(sizeof(int32) * (length - k + 1));
+
+	PB_BEGIN_DECODE(raw_seq, 0, length, fixed_codesets, (c)) {
+		int code = kmer_code(c);
+
+		if (code < 0)
+		{
+			n_valid = 0;
+		}
+		else
+		{
+			kmer = ((kmer << 2) | code) & mask;
+			n_valid++;
+
+			if (n_valid >= k && kmers != NULL)
+			{
+				kmers[n_kmers] = (int32) kmer;
+				n_kmers++;
+			}
+			else if (n_valid >= k && !(kmer_bitmap[kmer >> 3] & (1 << (kmer & 7))))
+			{
+				kmer_bitmap[kmer >> 3] |= 1 << (kmer & 7);
+				n_kmers++;
+			}
+		}
+	} PB_END_DECODE
+
+	PB_TRACE(errmsg("<-kmer_gin_extract_value(): %d k-mers", n_kmers));
+
+	if (kmers != NULL)
+		PG_RETURN_POINTER(kmers_to_entries(kmers, n_kmers, n_entries));
+
+	PG_RETURN_POINTER(kmer_bitmap_to_entries(kmer_bitmap, bitmap_size, n_kmers, n_entries));
+}
+
+/**
+ * kmer_gin_extract_query()
+ * 		GIN extractQuery support for nucleotide sequences.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the support function
+ * 	int k : k-mer length, at most PB_KMER_MAX_LENGTH
+ */
+Datum kmer_gin_extract_query(FunctionCallInfo fcinfo, int k)
+{
+	text* pattern = PG_GETARG_TEXT_PP(0);
+	int32* n_entries = (int32*) PG_GETARG_POINTER(1);
+	int32* search_mode = (int32*) PG_GETARG_POINTER(6);
+	uint8* symbols = (uint8*) VARDATA_ANY(pattern);
+	int32 length = VARSIZE_ANY_EXHDR(pattern);
+	int32* kmers;
+	int32 n_kmers = 0;
+	uint32 kmer = 0;
+	uint32 mask = (((uint32) 1) << (2 * k)) - 1;
+	int n_valid = 0;
+	int32 i;
+	Datum* entries;
+
+	PB_TRACE(errmsg("->kmer_gin_extract_query()"));
+
+	kmers = palloc(sizeof(int32) * Max(length - k + 1, 1));
+
+	for (i = 0; i < length; i++)
+	{
+		int code = kmer_code(symbols[i]);
+
+		if (code < 0)
+		{
+			n_valid = 0;
+			continue;
+		}
+
+		kmer = ((kmer << 2) | code) & mask;
+		n_valid++;
+
+		if (n_valid >= k)
+		{
+			kmers[n_kmers] = (int32) kmer;
+			n_kmers++;
+		}
+	}
+
+	entries = kmers_to_entries(kmers, n_kmers, n_entries);
+
+	/* patterns without k-mers can be contained in any sequence */
+	if (*n_entries == 0)
+		*search_mode = GIN_SEARCH_MODE_ALL;
+
+	PB_TRACE(errmsg("<-kmer_gin_extract_query(): %d k-mers", *n_entries));
+
+	PG_RETURN_POINTER(entries);
+}
+
+/**
+ * gin_consistent_kmer()
+ * 		GIN consistent support for k-mer operator classes.
+ */
+PG_FUNCTION_INFO_V1 (gin_consistent_kmer);
+Datum gin_consistent_kmer(PG_FUNCTION_ARGS)
+{
+	bool* check = (bool*) PG_GETARG_POINTER(0);
+	int32 n_keys = PG_GETARG_INT32(3);
+	bool* recheck = (bool*) PG_GETARG_POINTER(5);
+	int32 i;
+
+	*recheck = true;
+
+	for (i = 0; i < n_keys; i++)
+		if (!check[i])
+			PG_RETURN_BOOL(false);
+
+	PG_RETURN_BOOL(true);
+}
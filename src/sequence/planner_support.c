@@ -0,0 +1,234 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   src/sequence/planner_support.c
+*
+*-------------------------------------------------------------------------
+*/
+#include <math.h>
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "catalog/pg_type.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/cost.h"
+#include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
+
+#if PG_VERSION_NUM >= 120000
+#include "nodes/makefuncs.h"
+#include "nodes/supportnodes.h"
+#endif
+
+#include "sequence/sequence.h"
+#include "sequence/kmer_index.h"
+#include "utils/debug.h"
+
+#include "sequence/planner_support.h"
+
+/**
+ * estimate_sequence_length()
+ * 		Estimates the average number of symbols of a sequence expression
+ * 		from the width statistics of its column. The width of toasted
+ * 		values is the width of their toast pointer, so long sequences
+ * 		are underestimated.
+ *
+ * 	PlannerInfo* root : planner state
+ * 	Node* seq : sequence expression
+ * 	double bits_per_symbol : average compressed size of a symbol
+ */
+static double estimate_sequence_length(PlannerInfo* root, Node* seq, double bits_per_symbol)
+{
+	if (root != NULL && IsA(seq, Var) && ((Var*) seq)->varlevelsup == 0)
+	{
+		Var* var = (Var*) seq;
+		RangeTblEntry* rte = planner_rt_fetch(var->varno, root);
+
+		if (rte->rtekind == RTE_RELATION && var->varattno > 0)
+		{
+			int32 width = get_attavgwidth(rte->relid, var->varattno);
+
+			if (width > (int32) sizeof(PB_CompressedSequence))
+				return (width - sizeof(PB_CompressedSequence)) * 8.0 / bits_per_symbol;
+		}
+	}
+
+	return PB_DEFAULT_ESTIMATED_LENGTH;
+}
+
+/**
+ * get_pattern_length()
+ * 		Returns the length of a constant search pattern or (-1), if
+ * 		the pattern is not known at planning time.
+ *
+ * 	Node* pattern : pattern expression
+ */
+static int32 get_pattern_length(Node* pattern)
+{
+	Const* value;
+
+	if (!IsA(pattern, Const))
+		return (-1);
+
+	value = (Const*) pattern;
+	if (value->constisnull)
+		return (-1);
+
+	return VARSIZE_ANY_EXHDR(DatumGetTextPP(value->constvalue));
+}
+
+/**
+ * estimate_contains_selectivity()
+ * 		Estimates the fraction of sequences containing a pattern. Models
+ * 		sequences as random strings, in which a pattern of length m
+ * 		occurs at each of the n - m + 1 positions with probability
+ * 		alphabet_size^(-m).
+ *
+ * 	PlannerInfo* root : planner state
+ * 	List* args : sequence and pattern expression
+ * 	int alphabet_size : number of distinct symbols of the type
+ * 	double bits_per_symbol : average compressed size of a symbol
+ */
+static double estimate_contains_selectivity(PlannerInfo* root,
+											List* args,
+											int alphabet_size,
+											double bits_per_symbol)
+{
+	double n;
+	int32 m;
+	double selectivity;
+
+	if (list_length(args) != 2)
+		return DEFAULT_MATCH_SEL;
+
+	m = get_pattern_length((Node*) lsecond(args));
+	if (m < 0)
+		return DEFAULT_MATCH_SEL;
+
+	/* sequence_strpos() never finds an empty pattern */
+	n = estimate_sequence_length(root, (Node*) linitial(args), bits_per_symbol);
+	if (m == 0 || n < m)
+		return 0.0;
+
+	selectivity = -expm1((n - m + 1) * log1p(-pow(alphabet_size, -m)));
+	CLAMP_PROBABILITY(selectivity);
+
+	PB_DEBUG2(errmsg("estimate_contains_selectivity(): length %g, pattern %d, selectivity %g", n, m, selectivity));
+
+	return selectivity;
+}
+
+Datum sequence_planner_support(FunctionCallInfo fcinfo,
+							   int alphabet_size,
+							   double bits_per_symbol)
+{
+#if PG_VERSION_NUM >= 120000
+	Node* rawreq = (Node*) PG_GETARG_POINTER(0);
+
+	if (IsA(rawreq, SupportRequestCost))
+	{
+		SupportRequestCost* req = (SupportRequestCost*) rawreq;
+		List* args;
+		double n;
+		int32 m;
+
+		if (req->node == NULL)
+			PG_RETURN_POINTER(NULL);
+
+		if (IsA(req->node, FuncExpr))
+			args = ((FuncExpr*) req->node)->args;
+		else if (IsA(req->node, OpExpr))
+			args = ((OpExpr*) req->node)->args;
+		else
+			PG_RETURN_POINTER(NULL);
+
+		if (list_length(args) != 2)
+			PG_RETURN_POINTER(NULL);
+
+		n = estimate_sequence_length(req->root, (Node*) linitial(args), bits_per_symbol);
+		m = Max(get_pattern_length((Node*) lsecond(args)), 1);
+
+		req->startup = 0;
+		req->per_tuple = cpu_operator_cost *
+				(1 + n * (m / 64 + 1) / PB_SYMBOLS_PER_OPERATOR_COST);
+
+		PG_RETURN_POINTER(req);
+	}
+
+	if (IsA(rawreq, SupportRequestSelectivity))
+	{
+		SupportRequestSelectivity* req = (SupportRequestSelectivity*) rawreq;
+
+		req->selectivity = estimate_contains_selectivity(req->root,
+														 req->args,
+														 alphabet_size,
+														 bits_per_symbol);
+
+		PG_RETURN_POINTER(req);
+	}
+
+	if (IsA(rawreq, SupportRequestIndexCondition))
+	{
+		SupportRequestIndexCondition* req = (SupportRequestIndexCondition*) rawreq;
+		FuncExpr* func;
+		Node* seq;
+		Node* pattern;
+		Oid opno;
+		char* opname;
+		Expr* clause;
+
+		if (!IsA(req->node, FuncExpr) || req->indexarg != 0)
+			PG_RETURN_POINTER(NULL);
+
+		func = (FuncExpr*) req->node;
+		if (func->funcresulttype != BOOLOID || list_length(func->args) != 2)
+			PG_RETURN_POINTER(NULL);
+
+		seq = (Node*) linitial(func->args);
+		pattern = (Node*) lsecond(func->args);
+		if (!IsA(pattern, Const) && !IsA(pattern, Param))
+			PG_RETURN_POINTER(NULL);
+
+		opno = get_opfamily_member(req->opfamily,
+								   exprType(seq),
+								   exprType(pattern),
+								   PB_KMER_CONTAINS_STRATEGY);
+		if (!OidIsValid(opno))
+			PG_RETURN_POINTER(NULL);
+
+		opname = get_opname(opno);
+		if (opname == NULL || strcmp(opname, "@>") != 0)
+			PG_RETURN_POINTER(NULL);
+
+		clause = make_opclause(opno, BOOLOID, false,
+							   (Expr*) seq, (Expr*) pattern,
+							   InvalidOid, func->inputcollid);
+
+		/* contains() and @> are equivalent, the index rechecks itself */
+		req->lossy = false;
+
+		PG_RETURN_POINTER(list_make1(clause));
+	}
+#endif
+
+	PG_RETURN_POINTER(NULL);
+}
+
+Datum sequence_contains_sel(FunctionCallInfo fcinfo,
+							int alphabet_size,
+							double bits_per_symbol)
+{
+	PlannerInfo* root = (PlannerInfo*) PG_GETARG_POINTER(0);
+	List* args = (List*) PG_GETARG_POINTER(2);
+
+	PG_RETURN_FLOAT8(estimate_contains_selectivity(root,
+												   args,
+												   alphabet_size,
+												   bits_per_symbol));
+}
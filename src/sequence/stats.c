@@ -22,14 +22,20 @@
  * local function declarations
  */
 
-static PB_SequenceInfo* get_sequence_info_cstring_rle_case_sensitive(const uint8* input);
-static PB_SequenceInfo* get_sequence_info_cstring_rle_case_insensitive(const uint8* input);
-static PB_SequenceInfo* get_sequence_info_cstring_case_sensitive(const uint8* input);
-static PB_SequenceInfo* get_sequence_info_cstring_case_insensitive(const uint8* input);
-static PB_SequenceInfo* get_sequence_info_text_rle_case_sensitive(const text* input);
-static PB_SequenceInfo* get_sequence_info_text_rle_case_insensitive(const text* input);
-static PB_SequenceInfo* get_sequence_info_text_case_sensitive(const text* input);
-static PB_SequenceInfo* get_sequence_info_text_case_insensitive(const text* input);
+static void count_frequencies(const uint8* input, int64 length, uint32* frequencies);
+static void add_run(uint32* rle_frequencies, uint8 symbol, int64 repeated_chars);
+static void count_runs(const uint8* input, int64 length, bool ignore_case, uint32* frequencies, uint32* rle_frequencies);
+static PB_SequenceInfo* get_sequence_info_buffer(const uint8* input, int64 length, int mode);
+
+/*
+ * Number of histograms, that consecutive bytes are counted into.
+ */
+#define PB_HISTOGRAM_LANES	4
+
+/*
+ * uint64 with all bytes set to c
+ */
+#define PB_BYTE_PATTERN(c)	(((uint64) (c)) * UINT64CONST(0x0101010101010101))
 
 /*
  * macros for heap-sort
@@ -224,599 +230,223 @@ void check_ascii(PB_SequenceInfo* sequence_info)
 	PB_TRACE(errmsg("<-check_ascii()"));
 }
 
-static PB_SequenceInfo* get_sequence_info_cstring_rle_case_sensitive(const uint8* input)
+/*
+ * local functions
+ */
+
+/**
+ * count_frequencies()
+ * 		Count symbol frequencies of a buffer.
+ *
+ * 	The buffer is read a word at a time and consecutive bytes are
+ * 	counted into separate histogram lanes, so that runs of equal
+ * 	symbols do not stall on incrementing the same counter.
+ *
+ * 	const uint8* input : input buffer
+ * 	int64 length : length of the input buffer
+ * 	uint32* frequencies : output parameter for the frequencies, must be zeroed
+ */
+static void count_frequencies(const uint8* input,
+							  int64 length,
+							  uint32* frequencies)
 {
-	uint8 current = '\000';
-	uint8 recent = '\000';
-	unsigned int repeated_chars = -1;
-	uint8* input_pointer = (uint8*) input;
-	int64 temp_len;
+	uint32 lanes[PB_HISTOGRAM_LANES - 1][PB_SOURCE_ALPHABET_SIZE];
+	const uint8* input_pointer = input;
+	const uint8* input_end = input + length;
+	int i, j;
 
-	PB_SequenceInfo* result;
+	memset(lanes, 0, sizeof(lanes));
 
-	uint32* frequencies;
-	uint32* rle_frequencies;
+	while (input_end - input_pointer >= sizeof(uint64))
+	{
+		uint64 word;
 
-	result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
-	result->rle_info = (PB_RleInfo*) palloc0(sizeof(PB_RleInfo));
-	result->ignore_case = false;
+		memcpy(&word, input_pointer, sizeof(uint64));
+		input_pointer += sizeof(uint64);
 
-	frequencies = (uint32*) &(result->frequencies);
-	rle_frequencies = (uint32*) &(result->rle_info->rle_frequencies);
+		frequencies[(uint8) word]++;
+		lanes[0][(uint8) (word >> 8)]++;
+		lanes[1][(uint8) (word >> 16)]++;
+		lanes[2][(uint8) (word >> 24)]++;
+		frequencies[(uint8) (word >> 32)]++;
+		lanes[0][(uint8) (word >> 40)]++;
+		lanes[1][(uint8) (word >> 48)]++;
+		lanes[2][(uint8) (word >> 56)]++;
+	}
 
-	while (*input_pointer != '\000')
+	while (input_pointer < input_end)
 	{
-		current = *input_pointer;
+		frequencies[*input_pointer]++;
 		input_pointer++;
-		frequencies[current]++;
-		repeated_chars++;
-
-		if (current != recent)
-		{
-			/*
-			 * a series of length 'repeated_chars' equal characters ends
-			 */
-			if (repeated_chars < PB_MIN_RUN_LENGTH)
-			{
-				/*
-				 * the series is too short for using rle
-				 */
-				rle_frequencies[recent] += repeated_chars;
-				recent = current;
-				repeated_chars = 0;
-			}
-			else
-			{
-				 /*
-				  * number of full PB_MAX_RUN_LENGTH rle 'blocks' needed
-				  */
-				const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-				/*
-				 *  remaining characters, that are not covered by full rle blocks
-				 */
-				const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
-
-				rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-				rle_frequencies[recent] += rle_blocks;
-
-				if (remainder >= PB_MIN_RUN_LENGTH)
-				{
-					/*
-					 * enough remaining characters to put them into an rle block
-					 */
-					rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-					rle_frequencies[recent]++;
-				}
-				else
-				{
-					/*
-					 * too few remaining characters to use RLE
-					 */
-					rle_frequencies[recent] += remainder;
-				}
-
-				recent = current;
-				repeated_chars = 0;
-			}
-		}
 	}
 
-	/*
-	 * processing last character
-	 */
-	repeated_chars++;
+	for (i = 0; i < PB_HISTOGRAM_LANES - 1; i++)
+		for (j = 0; j < PB_SOURCE_ALPHABET_SIZE; j++)
+			frequencies[j] += lanes[i][j];
+}
+
+/**
+ * add_run()
+ * 		Add a run of equal symbols to RLE frequencies.
+ *
+ * 	uint32* rle_frequencies : RLE frequencies to update
+ * 	uint8 symbol : symbol of the run
+ * 	int64 repeated_chars : length of the run
+ */
+static void add_run(uint32* rle_frequencies,
+					uint8 symbol,
+					int64 repeated_chars)
+{
 	if (repeated_chars < PB_MIN_RUN_LENGTH)
 	{
-		rle_frequencies[recent] += repeated_chars;
+		/*
+		 * the series is too short for using rle
+		 */
+		rle_frequencies[symbol] += repeated_chars;
 	}
 	else
 	{
-		const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-		const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
+		/*
+		 * number of full PB_MAX_RUN_LENGTH rle 'blocks' needed
+		 */
+		const int64 rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
+		/*
+		 *  remaining characters, that are not covered by full rle blocks
+		 */
+		const int64 remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
 
 		rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-		rle_frequencies[recent] += rle_blocks;
+		rle_frequencies[symbol] += rle_blocks;
 
 		if (remainder >= PB_MIN_RUN_LENGTH)
 		{
+			/*
+			 * enough remaining characters to put them into an rle block
+			 */
 			rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-			rle_frequencies[recent]++;
+			rle_frequencies[symbol]++;
 		}
 		else
 		{
-			rle_frequencies[recent] += remainder;
+			/*
+			 * too few remaining characters to use RLE
+			 */
+			rle_frequencies[symbol] += remainder;
 		}
 	}
-
-	temp_len = (input_pointer - (uint8*) input);
-
-	if (temp_len >= PB_MAX_INPUT_SEQUENCE_LENGTH)
-	{
-		ereport(ERROR,(errmsg("input sequence violates length constraints"),
-				errdetail("Maximum is %ld characters. This sequence has %ld characters,", PB_MAX_INPUT_SEQUENCE_LENGTH, temp_len)));
-	}
-
-	check_ascii(result);
-
-	result->sequence_length = (uint32) temp_len;
-	result->ignore_case = false;
-	collect_alphabet((uint32*) &(result->frequencies), &(result->n_symbols), &(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
-	collect_alphabet((uint32*) &(result->rle_info->rle_frequencies), &(result->rle_info->n_symbols), &(result->rle_info->symbols), NULL, NULL);
-
-	return result;
 }
 
-static PB_SequenceInfo* get_sequence_info_cstring_rle_case_insensitive(const uint8* input)
+/**
+ * count_runs()
+ * 		Count symbol and RLE frequencies of a buffer run by run.
+ *
+ * 	Runs are extended a word at a time, as long as the next word
+ * 	consists of copies of the previous byte. Only the bytes at the
+ * 	end of a run are compared one by one.
+ *
+ * 	const uint8* input : input buffer
+ * 	int64 length : length of the input buffer
+ * 	bool ignore_case : whether lower case symbols are counted as upper case
+ * 	uint32* frequencies : output parameter for the frequencies, must be zeroed
+ * 	uint32* rle_frequencies : output parameter for the RLE frequencies, must be zeroed
+ */
+static void count_runs(const uint8* input,
+					   int64 length,
+					   bool ignore_case,
+					   uint32* frequencies,
+					   uint32* rle_frequencies)
 {
-	uint8 current = '\000';
-	uint8 recent = '\000';
-	unsigned int repeated_chars = -1;
-	uint8* input_pointer = (uint8*) input;
-	int64 temp_len;
+	int64 position = 0;
 
-	PB_SequenceInfo* result;
-
-	uint32* frequencies;
-	uint32* rle_frequencies;
-
-	result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
-	result->rle_info = (PB_RleInfo*) palloc0(sizeof(PB_RleInfo));
-	result->ignore_case = true;
-
-	frequencies = (uint32*) &(result->frequencies);
-	rle_frequencies = (uint32*) &(result->rle_info->rle_frequencies);
-
-	while (*input_pointer != '\000')
+	while (position < length)
 	{
-		current = TO_UPPER(*input_pointer);
-		input_pointer++;
-		frequencies[current]++;
-		repeated_chars++;
+		const uint8 current = ignore_case ? TO_UPPER(input[position]) : input[position];
+		int64 run_end = position + 1;
 
-		if (current != recent)
+		for (;;)
 		{
-			/*
-			 * a series of length 'repeated_chars' equal characters ends
-			 */
-			if (repeated_chars < PB_MIN_RUN_LENGTH)
-			{
-				/*
-				 * the series is too short for using rle
-				 */
-				rle_frequencies[recent] += repeated_chars;
-				recent = current;
-				repeated_chars = 0;
-			}
-			else
+			const uint64 pattern = PB_BYTE_PATTERN(input[run_end - 1]);
+			uint64 word;
+
+			while (run_end + (int64) sizeof(uint64) <= length)
 			{
-				/*
-				 * number of full PB_MAX_RUN_LENGTH rle 'blocks' needed
-				 */
-				const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-				/*
-				 *  remaining characters, that are not covered by full rle blocks
-				 */
-				const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
-
-				rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-				rle_frequencies[recent] += rle_blocks;
-
-				if (remainder >= PB_MIN_RUN_LENGTH)
-				{
-					/*
-					 * enough remaining characters to put them into an rle block
-					 */
-					rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-					rle_frequencies[recent]++;
-				}
-				else
-				{
-					/*
-					 * too few remaining characters to use RLE
-					 */
-					rle_frequencies[recent] += remainder;
-				}
-				recent = current;
-				repeated_chars = 0;
+				memcpy(&word, input + run_end, sizeof(uint64));
+				if (word != pattern)
+					break;
+				run_end += sizeof(uint64);
 			}
-		}
-	}
-
-	/*
-	 * processing last character
-	 */
-	repeated_chars++;
-	if (repeated_chars < PB_MIN_RUN_LENGTH)
-	{
-		rle_frequencies[recent] += repeated_chars;
-	}
-	else
-	{
-		const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-		const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
-		rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-		rle_frequencies[recent] += rle_blocks;
-		if (remainder >= PB_MIN_RUN_LENGTH)
-		{
-			rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-			rle_frequencies[recent]++;
-		}
-		else
-		{
-			rle_frequencies[recent] += remainder;
-		}
-	}
-
-	temp_len = (input_pointer - (uint8*) input);
-
-	if (temp_len >= PB_MAX_INPUT_SEQUENCE_LENGTH)
-	{
-		ereport(ERROR,(errmsg("input sequence violates length constraints"),
-				errdetail("Maximum is %ld characters. This sequence has %ld characters,", PB_MAX_INPUT_SEQUENCE_LENGTH, temp_len)));
-	}
-
-	check_ascii(result);
-
-	result->sequence_length = (uint32) temp_len;
-	result->ignore_case = true;
-	collect_alphabet((uint32*) &(result->frequencies), &(result->n_symbols), &(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
-	collect_alphabet((uint32*) &(result->rle_info->rle_frequencies), &(result->rle_info->n_symbols), &(result->rle_info->symbols), NULL, NULL);
-
-	return result;
-}
-
-static PB_SequenceInfo* get_sequence_info_cstring_case_sensitive(const uint8* input)
-{
-	uint8* input_pointer = (uint8*) input;
-
-	int64 temp_len;
-
-	PB_SequenceInfo* result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
 
-	uint32* frequencies = (uint32*) &(result->frequencies);
+			if (run_end >= length)
+				break;
+			if ((ignore_case ? TO_UPPER(input[run_end]) : input[run_end]) != current)
+				break;
 
-	while (*input_pointer != '\000')
-	{
-		frequencies[*input_pointer]++;
-		input_pointer++;
-	}
+			run_end++;
+		}
 
-	temp_len = (input_pointer - (uint8*) input);
+		frequencies[current] += run_end - position;
+		add_run(rle_frequencies, current, run_end - position);
 
-	if (temp_len >= PB_MAX_INPUT_SEQUENCE_LENGTH)
-	{
-		ereport(ERROR,(errmsg("input sequence violates length constraints"),
-				errdetail("Maximum is %ld characters. This sequence has %ld characters,", PB_MAX_INPUT_SEQUENCE_LENGTH, temp_len)));
+		position = run_end;
 	}
-
-	check_ascii(result);
-
-	result->sequence_length = (uint32) temp_len;
-	result->ignore_case = false;
-	collect_alphabet((uint32*) &(result->frequencies),&(result->n_symbols),&(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
-
-	return result;
 }
 
-/*
- * local functions
+/**
+ * get_sequence_info_buffer()
+ * 		Obtain sequence length, symbol frequencies and alphabet of a buffer.
+ *
+ * 	const uint8* input : input buffer
+ * 	int64 length : length of the input buffer
+ * 	int mode : see get_sequence_info_cstring()
  */
-static PB_SequenceInfo* get_sequence_info_cstring_case_insensitive(const uint8* input)
+static PB_SequenceInfo* get_sequence_info_buffer(const uint8* input,
+												 int64 length,
+												 int mode)
 {
-	uint8* input_pointer = (uint8*) input;
-
-	int64 temp_len;
-	int i;
-
-	PB_SequenceInfo* result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
-
-	uint32* frequencies = (uint32*) &(result->frequencies);
-
-	while (*input_pointer != '\000')
-	{
-		frequencies[*input_pointer]++;
-		input_pointer++;
-	}
-
-	temp_len = (input_pointer - (uint8*) input);
-
-	if (temp_len >= PB_MAX_INPUT_SEQUENCE_LENGTH)
-	{
-		ereport(ERROR,(errmsg("input sequence violates length constraints"),
-				errdetail("Maximum is %ld characters. This sequence has %ld characters,", PB_MAX_INPUT_SEQUENCE_LENGTH, temp_len)));
-	}
-
-	for (i = 97; i <= 122; i++)
-	{
-		frequencies[i - 32] += frequencies[i];
-		frequencies[i] = 0;
-	}
-
-	check_ascii(result);
-
-	result->sequence_length = (uint32) temp_len;
-	result->ignore_case = true;
-	collect_alphabet((uint32*) &(result->frequencies),&(result->n_symbols),&(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
-
-	return result;
-}
-
-static PB_SequenceInfo* get_sequence_info_text_rle_case_sensitive(const text* input)
-{
-	uint8 current = '\000';
-	uint8 recent = '\000';
-	unsigned int repeated_chars = -1;
-	int i = VARSIZE_ANY_EXHDR(input) - 1;
-	uint8* input_pointer = (uint8*) VARDATA_ANY(input);
+	const bool ignore_case = !(mode & PB_SEQUENCE_INFO_CASE_SENSITIVE);
 
 	PB_SequenceInfo* result;
 
 	uint32* frequencies;
-	uint32* rle_frequencies;
 
 	result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
-	result->rle_info = (PB_RleInfo*) palloc0(sizeof(PB_RleInfo));
-	result->ignore_case = false;
+	result->ignore_case = ignore_case;
 
 	frequencies = (uint32*) &(result->frequencies);
-	rle_frequencies = (uint32*) &(result->rle_info->rle_frequencies);
 
-	while (i >= 0)
+	if (mode & PB_SEQUENCE_INFO_WITH_RLE)
 	{
-		current = *input_pointer;
-		input_pointer++;
-		i--;
-		frequencies[current]++;
-		repeated_chars++;
-
-		if (current != recent)
-		{
-			/*
-			 * a series of length 'repeated_chars' equal characters ends
-			 */
-			if (repeated_chars < PB_MIN_RUN_LENGTH)
-			{
-				/*
-				 * the series is too short for using rle
-				 */
-				rle_frequencies[recent] += repeated_chars;
-				recent = current;
-				repeated_chars = 0;
-			}
-			else
-			{
-				/*
-				 * number of full PB_MAX_RUN_LENGTH rle 'blocks' needed
-				 */
-				const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-				/*
-				 *  remaining characters, that are not covered by full rle blocks
-				 */
-				const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
-
-				rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-				rle_frequencies[recent] += rle_blocks;
-
-				if (remainder >= PB_MIN_RUN_LENGTH)
-				{
-					/*
-					 * enough remaining characters to put them into an rle block
-					 */
-					rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-					rle_frequencies[recent]++;
-				}
-				else
-				{
-					/*
-					 * too few remaining characters to use RLE
-					 */
-					rle_frequencies[recent] += remainder;
-				}
-				recent = current;
-				repeated_chars = 0;
-			}
-		}
-	}
+		result->rle_info = (PB_RleInfo*) palloc0(sizeof(PB_RleInfo));
 
-	/*
-	 * processing last character
-	 */
-	repeated_chars++;
-	if (repeated_chars < PB_MIN_RUN_LENGTH)
-	{
-		rle_frequencies[recent] += repeated_chars;
+		count_runs(input,
+				   length,
+				   ignore_case,
+				   frequencies,
+				   (uint32*) &(result->rle_info->rle_frequencies));
 	}
 	else
 	{
-		const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-		const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
-		rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-		rle_frequencies[recent] += rle_blocks;
-		if (remainder >= PB_MIN_RUN_LENGTH)
-		{
-			rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-			rle_frequencies[recent]++;
-		}
-		else
-		{
-			rle_frequencies[recent] += remainder;
-		}
-	}
-
-	check_ascii(result);
-
-	result->sequence_length = VARSIZE_ANY_EXHDR(input);
-	result->ignore_case = false;
-	collect_alphabet((uint32*) &(result->frequencies), &(result->n_symbols), &(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
-	collect_alphabet((uint32*) &(result->rle_info->rle_frequencies), &(result->rle_info->n_symbols), &(result->rle_info->symbols), NULL, NULL);
-
-	return result;
-}
-
-static PB_SequenceInfo* get_sequence_info_text_rle_case_insensitive(const text* input)
-{
-	uint8 current = '\000';
-	uint8 recent = '\000';
-	unsigned int repeated_chars = -1;
-	int i = VARSIZE_ANY_EXHDR(input) - 1;
-	uint8* input_pointer = (uint8*) VARDATA_ANY(input);
-
-	PB_SequenceInfo* result;
-
-	uint32* frequencies;
-	uint32* rle_frequencies;
-
-	result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
-	result->rle_info = (PB_RleInfo*) palloc0(sizeof(PB_RleInfo));
-	result->ignore_case = true;
-
-	frequencies = (uint32*) &(result->frequencies);
-	rle_frequencies = (uint32*) &(result->rle_info->rle_frequencies);
-
-	while (i >= 0)
-	{
-		current = TO_UPPER(*input_pointer);
-		input_pointer++;
-		i--;
-		frequencies[current]++;
-		repeated_chars++;
+		count_frequencies(input, length, frequencies);
 
-		if (current != recent)
+		if (ignore_case)
 		{
-			/*
-			 * a series of length 'repeated_chars' equal characters ends
-			 */
-			if (repeated_chars < PB_MIN_RUN_LENGTH)
-			{
-				/*
-				 * the series is too short for using rle
-				 */
-				rle_frequencies[recent] += repeated_chars;
-				recent = current;
-				repeated_chars = 0;
-			}
-			else
+			int i;
+
+			for (i = 97; i <= 122; i++)
 			{
-				/*
-				 * number of full PB_MAX_RUN_LENGTH rle 'blocks' needed
-				 */
-				const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-				/*
-				 *  remaining characters, that are not covered by full rle blocks
-				 */
-				const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
-
-				rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-				rle_frequencies[recent] += rle_blocks;
-
-				if (remainder >= PB_MIN_RUN_LENGTH)
-				{
-					/*
-					 * enough remaining characters to put them into an rle block
-					 */
-					rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-					rle_frequencies[recent]++;
-				}
-				else
-				{
-					/*
-					 * too few remaining characters to use RLE
-					 */
-					rle_frequencies[recent] += remainder;
-				}
-				recent = current;
-				repeated_chars = 0;
+				frequencies[i - 32] += frequencies[i];
+				frequencies[i] = 0;
 			}
 		}
 	}
 
-	/*
-	 * processing last character
-	 */
-	repeated_chars++;
-	if (repeated_chars < PB_MIN_RUN_LENGTH)
-	{
-		rle_frequencies[recent] += repeated_chars;
-	}
-	else
-	{
-		const int rle_blocks = repeated_chars / (PB_MAX_RUN_LENGTH - 1);
-		const int remainder = repeated_chars % (PB_MAX_RUN_LENGTH - 1);
-		rle_frequencies[PB_RUN_LENGTH_SYMBOL] += rle_blocks;
-		rle_frequencies[recent] += rle_blocks;
-		if (remainder >= PB_MIN_RUN_LENGTH)
-		{
-			rle_frequencies[PB_RUN_LENGTH_SYMBOL]++;
-			rle_frequencies[recent]++;
-		}
-		else
-		{
-			rle_frequencies[recent] += remainder;
-		}
-	}
-
-	check_ascii(result);
-
-	result->sequence_length = VARSIZE_ANY_EXHDR(input);
-	result->ignore_case = true;
-	collect_alphabet((uint32*) &(result->frequencies), &(result->n_symbols), &(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
-	collect_alphabet((uint32*) &(result->rle_info->rle_frequencies), &(result->rle_info->n_symbols), &(result->rle_info->symbols), NULL, NULL);
-
-	return result;
-}
-
-static PB_SequenceInfo* get_sequence_info_text_case_sensitive(const text* input)
-{
-	uint8* input_pointer = (uint8*) VARDATA_ANY(input);
-	int i = VARSIZE_ANY_EXHDR(input) - 1;
-
-	PB_SequenceInfo* result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
-
-	uint32* frequencies = (uint32*) &(result->frequencies);
-
-	while (i >= 0)
-	{
-		frequencies[*input_pointer]++;
-		input_pointer++;
-		i--;
-	}
-
 	check_ascii(result);
 
-	result->sequence_length = VARSIZE_ANY_EXHDR(input);
-	result->ignore_case = false;
+	result->sequence_length = (uint32) length;
 	collect_alphabet((uint32*) &(result->frequencies), &(result->n_symbols), &(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
 
-	return result;
-}
-
-static PB_SequenceInfo* get_sequence_info_text_case_insensitive(const text* input)
-{
-	uint8* input_pointer = (uint8*) VARDATA_ANY(input);
-	int i = VARSIZE_ANY_EXHDR(input) - 1;
-
-	PB_SequenceInfo* result = (PB_SequenceInfo*) palloc0(sizeof(PB_SequenceInfo));
-
-	uint32* frequencies = (uint32*) &(result->frequencies);
-
-	while (i >= 0)
-	{
-		frequencies[*input_pointer]++;
-		input_pointer++;
-		i--;
-	}
-
-	for (i = 97; i <= 122; i++)
-	{
-		frequencies[i - 32] += frequencies[i];
-		frequencies[i] = 0;
-	}
-
-	check_ascii(result);
-
-	result->sequence_length = VARSIZE_ANY_EXHDR(input);
-	result->ignore_case = true;
-	collect_alphabet((uint32*) &(result->frequencies), &(result->n_symbols), &(result->symbols), &(result->ascii_bitmap_low), &(result->ascii_bitmap_high));
+	if (result->rle_info != NULL)
+		collect_alphabet((uint32*) &(result->rle_info->rle_frequencies), &(result->rle_info->n_symbols), &(result->rle_info->symbols), NULL, NULL);
 
 	return result;
 }
@@ -843,30 +473,20 @@ PB_SequenceInfo* get_sequence_info_cstring(uint8* input,
 										   int mode)
 {
 	PB_SequenceInfo* result = NULL;
+	int64 length;
 
 	PB_TRACE(errmsg("->get_sequence_info_cstring(): mode = %d", mode));
 
-	if (mode & PB_SEQUENCE_INFO_WITH_RLE)
-	{
-		if (mode & PB_SEQUENCE_INFO_CASE_SENSITIVE) {
-			result = get_sequence_info_cstring_rle_case_sensitive(input);
-		}
-		else
-		{
-			result = get_sequence_info_cstring_rle_case_insensitive(input);
-		}
-	}
-	else
+	length = strlen((char*) input);
+
+	if (length >= PB_MAX_INPUT_SEQUENCE_LENGTH)
 	{
-		if (mode & PB_SEQUENCE_INFO_CASE_SENSITIVE) {
-			result = get_sequence_info_cstring_case_sensitive(input);
-		}
-		else
-		{
-			result = get_sequence_info_cstring_case_insensitive(input);
-		}
+		ereport(ERROR,(errmsg("input sequence violates length constraints"),
+				errdetail("Maximum is %ld characters. This sequence has %ld characters,", PB_MAX_INPUT_SEQUENCE_LENGTH, length)));
 	}
 
+	result = get_sequence_info_buffer(input, length, mode);
+
 	PB_TRACE(errmsg("<-get_sequence_info_cstring()"))
 
 	return result;
@@ -893,26 +513,9 @@ PB_SequenceInfo* get_sequence_info_text(text* input,
 
 	PB_TRACE(errmsg("->get_sequence_info_text(): mode = %d", mode))
 
-	if (mode & PB_SEQUENCE_INFO_WITH_RLE)
-	{
-		if (mode & PB_SEQUENCE_INFO_CASE_SENSITIVE) {
-			result = get_sequence_info_text_rle_case_sensitive(input);
-		}
-		else
-		{
-			result = get_sequence_info_text_rle_case_insensitive(input);
-		}
-	}
-	else
-	{
-		if (mode & PB_SEQUENCE_INFO_CASE_SENSITIVE) {
-			result = get_sequence_info_text_case_sensitive(input);
-		}
-		else
-		{
-			result = get_sequence_info_text_case_insensitive(input);
-		}
-	}
+	result = get_sequence_info_buffer((uint8*) VARDATA_ANY(input),
+									  VARSIZE_ANY_EXHDR(input),
+									  mode);
 
 	PB_TRACE(errmsg("<-get_sequence_info_text()"))
 
@@ -0,0 +1,382 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   src/sequence/stream_encoder.c
+*
+*-------------------------------------------------------------------------
+*/
+#include "postgres.h"
+#include "utils/memutils.h"
+
+#include "sequence/sequence.h"
+#include "sequence/compression.h"
+#include "sequence/decoding_map_cache.h"
+#include "sequence/decompression_iteration.h"
+#include "sequence/stream_encoder.h"
+#include "utils/debug.h"
+
+/*
+ * local function declarations
+ */
+
+static bool fill_code_table(PB_StreamEncoder* encoder, int candidate, uint8 required_symbol);
+static void reserve(PB_StreamEncoder* encoder, uint64 n_symbols);
+static void encode_symbol(PB_StreamEncoder* encoder, uint8 symbol);
+static void switch_code_set(PB_StreamEncoder* encoder, uint8 symbol);
+
+/*
+ * local functions
+ */
+
+/**
+ * fill_code_table()
+ * 		Fills the code table of an encoder from a candidate code set.
+ * 		Returns false and leaves the encoder untouched, if the candidate
+ * 		can not express the required symbol.
+ */
+static bool fill_code_table(PB_StreamEncoder* encoder, int candidate, uint8 required_symbol)
+{
+	const PB_CodeSet* codeset = encoder->candidates[candidate];
+	int16 word_codes[PB_SOURCE_ALPHABET_SIZE];
+	uint8 word_lengths[PB_SOURCE_ALPHABET_SIZE];
+	int i;
+
+	memset(word_codes, 0xFF, sizeof(word_codes));
+	memset(word_lengths, 0, sizeof(word_lengths));
+
+	for (i = 0; i < codeset->n_symbols; i++)
+	{
+		const uint8 symbol = codeset->words[i].symbol;
+		const int code_length = codeset->words[i].code_length;
+
+		word_codes[symbol] = codeset->words[i].code >> (PB_PREFIX_CODE_BIT_SIZE - code_length);
+		word_lengths[symbol] = code_length;
+	}
+
+	if (word_codes[encoder->ignore_case ? TO_UPPER(required_symbol) : required_symbol] < 0)
+		return false;
+
+	for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+	{
+		const int symbol = encoder->ignore_case ? TO_UPPER(i) : i;
+
+		encoder->codes[i] = word_codes[symbol];
+		encoder->code_lengths[i] = word_lengths[symbol];
+	}
+
+	encoder->current_candidate = candidate;
+
+	return true;
+}
+
+/**
+ * reserve()
+ * 		Makes sure, that the stream and the index of an encoder have
+ * 		room for a number of additional symbols.
+ */
+static void reserve(PB_StreamEncoder* encoder, uint64 n_symbols)
+{
+	const PB_CodeSet* codeset = encoder->candidates[encoder->current_candidate];
+	const uint64 max_bits = n_symbols * codeset->max_codeword_length;
+	uint64 needed_words;
+	uint64 needed_entries;
+
+	/*
+	 * Always keep one spare word, so that the buffer can be flushed.
+	 */
+	needed_words = encoder->n_words + max_bits / PB_COMPRESSION_BUFFER_BIT_SIZE + 2;
+	if (needed_words > encoder->max_words)
+	{
+		uint64 max_words = Max(needed_words, ((uint64) encoder->max_words) * 2);
+
+		if (max_words * PB_COMPRESSION_BUFFER_BYTE_SIZE > MaxAllocSize)
+			max_words = MaxAllocSize / PB_COMPRESSION_BUFFER_BYTE_SIZE;
+		if (needed_words > max_words)
+			ereport(ERROR,(errmsg("input sequence violates length constraints"),
+					errdetail("Compressed sequence would exceed %lu bytes.", (unsigned long) MaxAllocSize)));
+
+		encoder->stream = repalloc(encoder->stream, max_words * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+		encoder->max_words = (uint32) max_words;
+	}
+
+	needed_entries = (encoder->sequence_length + n_symbols) / PB_INDEX_PART_SIZE;
+	if (needed_entries > encoder->max_entries)
+	{
+		const uint32 max_entries = Max(needed_entries, encoder->max_entries * 2);
+
+		if (encoder->index == NULL)
+			encoder->index = MemoryContextAlloc(encoder->context, max_entries * sizeof(PB_IndexEntry));
+		else
+			encoder->index = repalloc(encoder->index, max_entries * sizeof(PB_IndexEntry));
+		encoder->max_entries = max_entries;
+	}
+}
+
+/**
+ * encode_symbol()
+ * 		Appends a symbol, that the current code set can express, to the
+ * 		stream. Room must have been reserved.
+ */
+static void encode_symbol(PB_StreamEncoder* encoder, uint8 symbol)
+{
+	const PB_CompressionBuffer code = encoder->codes[symbol];
+	const int code_length = encoder->code_lengths[symbol];
+
+	/*
+	 * Index the position before every PB_INDEX_PART_SIZE'th symbol,
+	 * just like encode() does.
+	 */
+	encoder->index_counter--;
+	if (encoder->index_counter < 0)
+	{
+		PB_IndexEntry* entry = &encoder->index[encoder->n_entries];
+
+		encoder->index_counter += PB_INDEX_PART_SIZE;
+		memset(entry, 0, sizeof(PB_IndexEntry));
+		if (encoder->bits_free > 0)
+		{
+			entry->bit = PB_COMPRESSION_BUFFER_BIT_SIZE - encoder->bits_free;
+			entry->block = encoder->n_words;
+		}
+		else
+		{
+			entry->bit = 0;
+			entry->block = encoder->n_words + 1;
+		}
+		encoder->n_entries++;
+	}
+
+	if (code_length <= encoder->bits_free)
+	{
+		encoder->buffer = (encoder->buffer << code_length) | code;
+		encoder->bits_free -= code_length;
+	}
+	else
+	{
+		encoder->buffer = (encoder->buffer << encoder->bits_free) | code >> (code_length - encoder->bits_free);
+		encoder->stream[encoder->n_words] = encoder->buffer;
+		encoder->n_words++;
+		encoder->bits_free = encoder->bits_free - code_length + PB_COMPRESSION_BUFFER_BIT_SIZE;
+		encoder->buffer = code;
+	}
+
+	encoder->sequence_length++;
+}
+
+/**
+ * switch_code_set()
+ * 		Re-encodes the stream with the cheapest remaining candidate, that
+ * 		can express the given symbol.
+ */
+static void switch_code_set(PB_StreamEncoder* encoder, uint8 symbol)
+{
+	const PB_CodeSet* old_codeset = encoder->candidates[encoder->current_candidate];
+	PB_CompressionBuffer* old_stream = encoder->stream;
+	PB_IndexEntry* old_index = encoder->index;
+	const uint64 old_length = encoder->sequence_length;
+
+	const PB_DecodingMap* map;
+	const PB_DecodingMap* swap_map;
+
+	PB_CompressionBuffer* input_pointer;
+	PB_CompressionBuffer buffer = 0;
+	int bits_in_buffer = 0;
+	uint64 i;
+	int candidate;
+
+	for (candidate = encoder->current_candidate + 1; candidate < encoder->n_candidates; candidate++)
+		if (fill_code_table(encoder, candidate, symbol))
+			break;
+
+	if (candidate >= encoder->n_candidates)
+	{
+		ereport(ERROR,(errmsg("input sequence violates alphabet restrictions"),
+				errdetail("Symbol '%c' (%d) at position %lu can not be encoded.",
+						  symbol, symbol, (unsigned long) (old_length + 1))));
+	}
+
+	PB_DEBUG1(errmsg("switch_code_set(): re-encoding %lu symbols with candidate %d",
+					 (unsigned long) old_length, candidate));
+
+	/*
+	 * Flush the buffer into the spare word of the old stream.
+	 */
+	if (encoder->bits_free < PB_COMPRESSION_BUFFER_BIT_SIZE)
+		old_stream[encoder->n_words] = encoder->buffer << encoder->bits_free;
+
+	get_decoding_maps(old_codeset, &map, &swap_map);
+
+	encoder->stream = MemoryContextAlloc(encoder->context,
+										 encoder->max_words * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+	encoder->index = NULL;
+	encoder->max_entries = 0;
+	encoder->n_entries = 0;
+	encoder->index_counter = PB_INDEX_PART_SIZE - 1;
+	encoder->n_words = 0;
+	encoder->buffer = 0;
+	encoder->bits_free = PB_COMPRESSION_BUFFER_BIT_SIZE;
+	encoder->sequence_length = 0;
+
+	reserve(encoder, old_length);
+
+	input_pointer = old_stream;
+	for (i = 0; i < old_length; i++)
+	{
+		PB_PrefixCode val;
+		int length;
+
+		DECODE(input_pointer, buffer, bits_in_buffer, val, length, map);
+		encode_symbol(encoder, map[val].symbol);
+	}
+
+	pfree(old_stream);
+	if (old_index != NULL)
+		pfree(old_index);
+}
+
+/*
+ * public functions
+ */
+
+/**
+ * stream_encoder_create()
+ * 		Creates a stream encoder in the current memory context.
+ *
+ * 	PB_CodeSet** candidates : fixed code sets, cheapest first
+ * 	int n_candidates : number of candidates
+ * 	bool ignore_case : whether lower case symbols are encoded as upper case
+ */
+PB_StreamEncoder* stream_encoder_create(PB_CodeSet** candidates,
+										int n_candidates,
+										bool ignore_case)
+{
+	PB_StreamEncoder* encoder;
+	int i;
+
+	PB_TRACE(errmsg("->stream_encoder_create(): %d candidates", n_candidates));
+
+	if (n_candidates < 1 || n_candidates > PB_STREAM_ENCODER_MAX_CANDIDATES)
+		ereport(ERROR,(errmsg("invalid number of candidate code sets: %d", n_candidates)));
+
+	encoder = palloc0(sizeof(PB_StreamEncoder));
+	encoder->context = CurrentMemoryContext;
+	for (i = 0; i < n_candidates; i++)
+		encoder->candidates[i] = candidates[i];
+	encoder->n_candidates = n_candidates;
+	encoder->ignore_case = ignore_case;
+
+	/*
+	 * The first candidate takes any symbol it can express.
+	 */
+	memset(encoder->codes, 0xFF, sizeof(encoder->codes));
+	fill_code_table(encoder, 0, encoder->candidates[0]->words[0].symbol);
+
+	encoder->buffer = 0;
+	encoder->bits_free = PB_COMPRESSION_BUFFER_BIT_SIZE;
+	encoder->index_counter = PB_INDEX_PART_SIZE - 1;
+	encoder->max_words = PB_STREAM_ENCODER_INITIAL_WORDS;
+	encoder->stream = palloc(encoder->max_words * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+
+	PB_TRACE(errmsg("<-stream_encoder_create()"));
+
+	return encoder;
+}
+
+/**
+ * stream_encoder_append()
+ * 		Appends a chunk of a sequence to a stream encoder.
+ *
+ * 	PB_StreamEncoder* encoder : stream encoder
+ * 	const uint8* input : chunk, not null-terminated
+ * 	uint32 length : length of the chunk
+ */
+void stream_encoder_append(PB_StreamEncoder* encoder,
+						   const uint8* input,
+						   uint32 length)
+{
+	const uint8* input_pointer = input;
+	const uint8* input_end = input + length;
+
+	PB_TRACE(errmsg("->stream_encoder_append(): %u symbols", length));
+
+	if (encoder->sequence_length + length >= PB_MAX_INPUT_SEQUENCE_LENGTH)
+	{
+		ereport(ERROR,(errmsg("input sequence violates length constraints"),
+				errdetail("Maximum is %ld characters. This sequence has %ld characters,",
+						  PB_MAX_INPUT_SEQUENCE_LENGTH, (long) (encoder->sequence_length + length))));
+	}
+
+	reserve(encoder, length);
+
+	while (input_pointer < input_end)
+	{
+		if (encoder->codes[*input_pointer] < 0)
+		{
+			switch_code_set(encoder, *input_pointer);
+			reserve(encoder, input_end - input_pointer);
+		}
+
+		encode_symbol(encoder, *input_pointer);
+		input_pointer++;
+	}
+
+	PB_TRACE(errmsg("<-stream_encoder_append()"));
+}
+
+/**
+ * stream_encoder_finish()
+ * 		Returns the compressed sequence of all chunks appended so far.
+ *
+ * 	const PB_StreamEncoder* encoder : stream encoder
+ */
+PB_CompressedSequence* stream_encoder_finish(const PB_StreamEncoder* encoder)
+{
+	const PB_CodeSet* codeset = encoder->candidates[encoder->current_candidate];
+	const uint64 stream_bits = ((uint64) encoder->n_words) * PB_COMPRESSION_BUFFER_BIT_SIZE +
+							   (PB_COMPRESSION_BUFFER_BIT_SIZE - encoder->bits_free);
+	const uint32 n_entries = codeset->has_equal_length ? 0 : encoder->sequence_length / PB_INDEX_PART_SIZE;
+
+	PB_CompressedSequence* result;
+	uint32 compressed_size;
+
+	PB_TRACE(errmsg("->stream_encoder_finish(): %lu symbols", (unsigned long) encoder->sequence_length));
+
+	compressed_size = get_stream_offset(encoder->sequence_length, codeset, false, 0);
+	compressed_size += PB_ALIGN_BIT_SIZE(stream_bits) / 8;
+
+	result = palloc0(compressed_size);
+	SET_VARSIZE(result, compressed_size);
+	result->sequence_length = encoder->sequence_length;
+	result->is_fixed = true;
+	result->n_symbols = 0;
+	result->n_swapped_symbols = codeset->fixed_id;
+	result->has_equal_length = codeset->has_equal_length;
+	result->uses_rle = false;
+	result->has_index = n_entries > 0;
+
+	/*
+	 * Variable length candidates, e.g. the amino acid code used by
+	 * translate(), need an index.
+	 */
+	if (n_entries > 0)
+		memcpy(((uint8*) result) + PB_COMPRESSED_SEQUENCE_INDEX_OFFSET(result),
+			   encoder->index,
+			   n_entries * sizeof(PB_IndexEntry));
+
+	memcpy(PB_COMPRESSED_SEQUENCE_STREAM_POINTER(result),
+		   encoder->stream,
+		   encoder->n_words * PB_COMPRESSION_BUFFER_BYTE_SIZE);
+
+	if (encoder->bits_free < PB_COMPRESSION_BUFFER_BIT_SIZE)
+		PB_COMPRESSED_SEQUENCE_STREAM_POINTER(result)[encoder->n_words] = encoder->buffer << encoder->bits_free;
+
+	PB_TRACE(errmsg("<-stream_encoder_finish()"));
+
+	return result;
+}
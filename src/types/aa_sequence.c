@@ -15,6 +15,7 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "utils/array.h"
 #include "catalog/pg_type.h"
 #include "access/tuptoaster.h"
@@ -24,6 +25,7 @@
 #include "sequence/code_set_creation.h"
 #include "sequence/compression.h"
 #include "sequence/functions.h"
+#include "sequence/planner_support.h"
 #include "utils/debug.h"
 #include "types/alphabet.h"
 
@@ -42,7 +44,7 @@ static PB_CodeSet aa_iupac = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 0,
+		.fixed_id = (uint8) 0,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 132086782,
@@ -69,7 +71,7 @@ static PB_CodeSet aa_iupac_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 1,
+		.fixed_id = (uint8) 1,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 567308409055968254,
@@ -194,6 +196,9 @@ PB_CompressedSequence* compress_aa_sequence(uint8* input,
 		ereport(ERROR,(errmsg("input sequence violates alphabet restrictions")));
 	}
 
+	info->with_composition = typmod.composition == PB_AA_TYPMOD_COMPOSITION;
+	info->index_shift = typmod.index_shift;
+
 	/*
 	 * Build sequence specific code set if:
 	 * 		-sequence is longer than 512 chars or
@@ -282,6 +287,9 @@ Datum aa_sequence_typmod_in(PG_FUNCTION_ARGS) {
 	bool typeModCaseSensitive = false;
 	bool typeModIupac = false;
 	bool typeModAscii = false;
+	bool typeModComposition = false;
+	int typeModIndexShift = 0;
+	int shift;
 
 	int i;
 
@@ -300,6 +308,10 @@ Datum aa_sequence_typmod_in(PG_FUNCTION_ARGS) {
 			typeModIupac = true;
 		} else if (!strcmp(read_pointer, "ascii")) {
 			typeModAscii = true;
+		} else if (!strcmp(read_pointer, "composition")) {
+			typeModComposition = true;
+		} else if ((shift = get_index_shift(read_pointer)) >= 0) {
+			typeModIndexShift = shift;
 		} else {
 			ereport(ERROR,(errmsg("type modifier invalid"),
 					errdetail("Can not recognize type modifier \"%s\".", read_pointer)));
@@ -333,6 +345,14 @@ Datum aa_sequence_typmod_in(PG_FUNCTION_ARGS) {
 		result.restricting_alphabet = PB_AA_TYPMOD_IUPAC;
 	}
 
+	if (typeModComposition) {
+		result.composition = PB_AA_TYPMOD_COMPOSITION;
+	} else {
+		result.composition = PB_AA_TYPMOD_NO_COMPOSITION;
+	}
+
+	result.index_shift = typeModIndexShift;
+
 	PB_TRACE(errmsg("<-aa_sequence_typmod_in() returning %d", aa_sequence_typmod_to_int(result)));
 
 	PG_RETURN_INT32(aa_sequence_typmod_to_int(result));
@@ -362,6 +382,14 @@ Datum aa_sequence_typmod_out(PG_FUNCTION_ARGS) {
 	}
 	len += 5; /* strlen('ASCII') = 5, strlen('IUPAC') = 5 */
 
+	if (typmod.composition == PB_AA_TYPMOD_COMPOSITION) {
+		len += 12; /* strlen(',COMPOSITION') = 12 */
+	}
+
+	if (typmod.index_shift != 0) {
+		len += 6; /* strlen(',65536') = 6 */
+	}
+
 	result = palloc0(len);
 	out = result;
 
@@ -384,6 +412,15 @@ Datum aa_sequence_typmod_out(PG_FUNCTION_ARGS) {
 		out+=5;
 	}
 
+	if (typmod.composition == PB_AA_TYPMOD_COMPOSITION) {
+		strcpy(out, ",COMPOSITION");
+		out+=12;
+	}
+
+	if (typmod.index_shift != 0) {
+		out += sprintf(out, ",%d", PB_INDEX_PART_SIZE_OF(typmod.index_shift));
+	}
+
 	*out = ')';
 	out++;
 	*out = 0;
@@ -705,18 +742,28 @@ Datum aa_sequence_reverse(PG_FUNCTION_ARGS)
  * get_alphabet_aa_sequence()
  * 		Calculates alphabet from aa sequence.
  *
- * 	PB_CompressedSequence* input : compressed input sequence
+ * 	Varlena* input : possibly toasted input sequence
  */
 PG_FUNCTION_INFO_V1 (get_alphabet_aa_sequence);
 Datum get_alphabet_aa_sequence(PG_FUNCTION_ARGS)
 {
-	PB_CompressedSequence* input =
-			(PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
 	PB_Alphabet* result = get_alphabet_compressed_sequence(input, fixed_aa_codes);
 
 	PG_RETURN_POINTER(result);
 }
 
+/**
+ * entropy_aa()
+ * 		Returns the Shannon entropy of the symbols of an amino acid
+ * 		sequence in bits.
+ */
+PG_FUNCTION_INFO_V1 (entropy_aa);
+Datum entropy_aa(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(sequence_entropy((Varlena*) PG_GETARG_RAW_VARLENA_P(0), fixed_aa_codes));
+}
+
 /**
  * equal_aa()
  * 		Compares two AA sequence for equality
@@ -859,6 +906,22 @@ Datum compare_aa(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/**
+ * sortsupport_aa()
+ * 		Sets up sort support for amino acid sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+PG_FUNCTION_INFO_V1 (sortsupport_aa);
+Datum sortsupport_aa(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	sequence_sortsupport(ssup, fixed_aa_codes, "ACDEFGHIKLMNPQRSTVWY");
+
+	PG_RETURN_VOID();
+}
+
 /**
  * hash_aa()
  * 		Returns a CRC32 for a AA sequence.
@@ -900,6 +963,117 @@ Datum strpos_aa(PG_FUNCTION_ARGS)
 	PG_RETURN_UINT32(result);
 }
 
+/**
+ * contains_aa()
+ * 		Returns true if an amino acid sequence contains a pattern.
+ */
+PG_FUNCTION_INFO_V1 (contains_aa);
+Datum contains_aa(PG_FUNCTION_ARGS)
+{
+	PB_CompressedSequence* seq = (PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	text* search = (text*) PG_GETARG_VARLENA_P(1);
+	bool result;
+
+	PB_TRACE(errmsg("->contains_aa()"));
+
+	result = sequence_strpos(seq, search, fixed_aa_codes) > 0;
+
+	PB_TRACE(errmsg("<-contains_aa()"));
+
+	PG_RETURN_BOOL(result);
+}
+
+/**
+ * planner_support_aa()
+ * 		Planner support for strpos() and contains() of amino acid sequences.
+ */
+PG_FUNCTION_INFO_V1 (planner_support_aa);
+Datum planner_support_aa(PG_FUNCTION_ARGS)
+{
+	return sequence_planner_support(fcinfo, 20, PB_AMINO_ACID_BITS_PER_SYMBOL);
+}
+
+/**
+ * strpos_all_aa()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern. The optional third and fourth argument restrict
+ * 		the search to a window of the sequence.
+ */
+PG_FUNCTION_INFO_V1 (strpos_all_aa);
+Datum strpos_all_aa(PG_FUNCTION_ARGS)
+{
+	FuncCallContext* funcctx;
+	uint32* positions;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		Varlena* seq;
+		text* search;
+		uint32 from = 1;
+		uint32 to = PG_UINT32_MAX;
+
+		PB_TRACE(errmsg("->strpos_all_aa()"));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+		search = (text*) PG_GETARG_TEXT_PP(1);
+
+		if (PG_NARGS() == 4)
+		{
+			from = Max(PG_GETARG_INT32(2), 1);
+			to = Max(PG_GETARG_INT32(3), 0);
+		}
+
+		funcctx->max_calls = sequence_find_all(seq, search, from, to, fixed_aa_codes, &positions);
+		funcctx->user_fctx = positions;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		PB_TRACE(errmsg("<-strpos_all_aa()"));
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	positions = (uint32*) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+		SRF_RETURN_NEXT(funcctx, UInt32GetDatum(positions[funcctx->call_cntr]));
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/**
+ * count_occurrences_aa()
+ * 		Counts all, possibly overlapping, occurrences of a pattern. The
+ * 		optional third and fourth argument restrict the search to a
+ * 		window of the sequence.
+ */
+PG_FUNCTION_INFO_V1 (count_occurrences_aa);
+Datum count_occurrences_aa(PG_FUNCTION_ARGS)
+{
+	Varlena* seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+	text* search = (text*) PG_GETARG_TEXT_PP(1);
+	uint32 from = 1;
+	uint32 to = PG_UINT32_MAX;
+	uint32 result;
+
+	PB_TRACE(errmsg("->count_occurrences_aa()"));
+
+	if (PG_NARGS() == 4)
+	{
+		from = Max(PG_GETARG_INT32(2), 1);
+		to = Max(PG_GETARG_INT32(3), 0);
+	}
+
+	result = sequence_find_all(seq, search, from, to, fixed_aa_codes, NULL);
+
+	PB_TRACE(errmsg("<-count_occurrences_aa()"));
+
+	PG_RETURN_INT64(result);
+}
+
 /**
  * octet_length_aa()
  * 		Returns byte size of datum.
@@ -909,3 +1083,60 @@ Datum octet_length_aa(PG_FUNCTION_ARGS)
 {
 	PG_RETURN_UINT32((uint32) toast_raw_datum_size((Datum) PG_GETARG_RAW_VARLENA_P(0)));
 }
+
+/**
+ * concat_aa()
+ * 		Concatenates two amino acid sequences. If both were compressed with
+ * 		the same case insensitive fixed code, the second one is appended
+ * 		without decoding the first one. Otherwise both are decoded and
+ * 		compressed again with the default type modifier, like text cast
+ * 		to the type, keeping the composition and the index density of
+ * 		the first sequence.
+ *
+ * 	Varlena* seq1 : possibly toasted first sequence
+ * 	Varlena* seq2 : possibly toasted second sequence
+ */
+PG_FUNCTION_INFO_V1 (concat_aa);
+Datum concat_aa(PG_FUNCTION_ARGS)
+{
+	Varlena* seq1 = PG_GETARG_RAW_VARLENA_P(0);
+	Varlena* seq2 = PG_GETARG_RAW_VARLENA_P(1);
+	PB_AaSequenceTypMod typmod = int_to_aa_sequence_typmod(0);
+	PB_CompressedSequence* header;
+
+	PB_SequenceInfo* info;
+	PB_CompressedSequence* result;
+	uint8* input;
+	uint32 length;
+
+	PB_TRACE(errmsg("->concat_aa()"));
+
+	result = sequence_concat(seq1, seq2, fixed_aa_codes);
+	if (result != NULL)
+	{
+		PB_TRACE(errmsg("<-concat_aa(): appended"));
+		PG_RETURN_POINTER(result);
+	}
+
+	/*
+	 * Keep the composition and the index density of the first sequence.
+	 */
+	header = (PB_CompressedSequence*)
+			 PG_DETOAST_DATUM_SLICE(seq1, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+	if (header->has_composition)
+		typmod.composition = PB_AA_TYPMOD_COMPOSITION;
+	typmod.index_shift = header->index_shift;
+	pfree(header);
+
+	input = sequence_concat_decoded(seq1, seq2, fixed_aa_codes, &length);
+
+	info = get_sequence_info_cstring(input, 0);
+	result = compress_aa_sequence(input, typmod, info);
+
+	PB_SEQUENCE_INFO_PFREE(info);
+	pfree(input);
+
+	PB_TRACE(errmsg("<-concat_aa()"));
+
+	PG_RETURN_POINTER(result);
+}
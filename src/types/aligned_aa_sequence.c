@@ -42,7 +42,7 @@ static PB_CodeSet aligned_aa_iupac = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 0,
+		.fixed_id = (uint8) 0,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 132086782,
@@ -64,7 +64,7 @@ static PB_CodeSet aligned_aa_iupac_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 1,
+		.fixed_id = (uint8) 1,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 567308409055968254,
@@ -683,13 +683,12 @@ Datum aligned_aa_sequence_reverse(PG_FUNCTION_ARGS)
  * get_alphabet_aligned_aa_sequence()
  * 		Calculates alphabet from aligned aa sequence.
  *
- * 	PB_CompressedSequence* input : compressed input sequence
+ * 	Varlena* input : possibly toasted input sequence
  */
 PG_FUNCTION_INFO_V1 (get_alphabet_aligned_aa_sequence);
 Datum get_alphabet_aligned_aa_sequence(PG_FUNCTION_ARGS)
 {
-	PB_CompressedSequence* input =
-			(PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
 	PB_Alphabet* result = get_alphabet_compressed_sequence(input, fixed_aligned_aa_codes);
 
 	PG_RETURN_POINTER(result);
@@ -837,6 +836,22 @@ Datum compare_aligned_aa(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/**
+ * sortsupport_aligned_aa()
+ * 		Sets up sort support for aligned amino acid sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+PG_FUNCTION_INFO_V1 (sortsupport_aligned_aa);
+Datum sortsupport_aligned_aa(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	sequence_sortsupport(ssup, fixed_aligned_aa_codes, "ACDEFGHIKLMNPQRSTVWY");
+
+	PG_RETURN_VOID();
+}
+
 /**
  * hash_aligned_aa()
  * 		Returns a CRC32 for a aligned AA sequence.
@@ -887,3 +902,47 @@ Datum octet_length_aligned_aa(PG_FUNCTION_ARGS)
 {
 	PG_RETURN_UINT32((uint32) toast_raw_datum_size((Datum) PG_GETARG_RAW_VARLENA_P(0)));
 }
+
+/**
+ * concat_aligned_aa()
+ * 		Concatenates two aligned amino acid sequences. If both were compressed with
+ * 		the same fixed code, the second one is appended without decoding
+ * 		the first one. Otherwise both are decoded and compressed again
+ * 		without restrictions.
+ *
+ * 	Varlena* seq1 : possibly toasted first sequence
+ * 	Varlena* seq2 : possibly toasted second sequence
+ */
+PG_FUNCTION_INFO_V1 (concat_aligned_aa);
+Datum concat_aligned_aa(PG_FUNCTION_ARGS)
+{
+	Varlena* seq1 = PG_GETARG_RAW_VARLENA_P(0);
+	Varlena* seq2 = PG_GETARG_RAW_VARLENA_P(1);
+	PB_AlignedAaSequenceTypMod typmod = non_restricting_aligned_aa_typmod;
+
+	PB_SequenceInfo* info;
+	PB_CompressedSequence* result;
+	uint8* input;
+	uint32 length;
+
+	PB_TRACE(errmsg("->concat_aligned_aa()"));
+
+	result = sequence_concat(seq1, seq2, fixed_aligned_aa_codes);
+	if (result != NULL)
+	{
+		PB_TRACE(errmsg("<-concat_aligned_aa(): appended"));
+		PG_RETURN_POINTER(result);
+	}
+
+	input = sequence_concat_decoded(seq1, seq2, fixed_aligned_aa_codes, &length);
+
+	info = get_sequence_info_cstring(input, PB_SEQUENCE_INFO_CASE_SENSITIVE);
+	result = compress_aligned_aa_sequence(input, typmod, info);
+
+	PB_SEQUENCE_INFO_PFREE(info);
+	pfree(input);
+
+	PB_TRACE(errmsg("<-concat_aligned_aa()"));
+
+	PG_RETURN_POINTER(result);
+}
@@ -42,7 +42,7 @@ static PB_CodeSet aligned_dna_flc = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 0,
+		.fixed_id = (uint8) 0,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 1048714,
@@ -58,7 +58,7 @@ static PB_CodeSet aligned_dna_flc_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 1,
+		.fixed_id = (uint8) 1,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 4504192333906058,
@@ -75,7 +75,7 @@ static PB_CodeSet aligned_dna_iupac = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 2,
+		.fixed_id = (uint8) 2,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 47999390,
@@ -95,7 +95,7 @@ static PB_CodeSet aligned_dna_iupac_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 3,
+		.fixed_id = (uint8) 3,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 206155810325948830,
@@ -119,7 +119,7 @@ static PB_CodeSet aligned_dna_flc_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 4,
+		.fixed_id = (uint8) 4,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 1048714,
@@ -135,7 +135,7 @@ static PB_CodeSet aligned_dna_flc_cs_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 5,
+		.fixed_id = (uint8) 5,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 4504192333906058,
@@ -152,7 +152,7 @@ static PB_CodeSet aligned_dna_iupac_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 6,
+		.fixed_id = (uint8) 6,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 47999390,
@@ -172,7 +172,7 @@ static PB_CodeSet aligned_dna_iupac_cs_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 7,
+		.fixed_id = (uint8) 7,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 105553116266496,
 		.ascii_bitmap_high = (uint64) 206155810325948830,
@@ -931,13 +931,12 @@ Datum aligned_dna_sequence_reverse_complement(PG_FUNCTION_ARGS)
  * get_alphabet_aligned_dna_sequence()
  * 		Calculates alphabet from aligned DNA sequence.
  *
- * 	PB_CompressedSequence* input : compressed input sequence
+ * 	Varlena* input : possibly toasted input sequence
  */
 PG_FUNCTION_INFO_V1 (get_alphabet_aligned_dna_sequence);
 Datum get_alphabet_aligned_dna_sequence(PG_FUNCTION_ARGS)
 {
-	PB_CompressedSequence* input =
-			(PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
 	PB_Alphabet* result = get_alphabet_compressed_sequence(input, fixed_aligned_dna_codes);
 
 	PG_RETURN_POINTER(result);
@@ -1085,6 +1084,22 @@ Datum compare_aligned_dna(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/**
+ * sortsupport_aligned_dna()
+ * 		Sets up sort support for aligned DNA sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+PG_FUNCTION_INFO_V1 (sortsupport_aligned_dna);
+Datum sortsupport_aligned_dna(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	sequence_sortsupport(ssup, fixed_aligned_dna_codes, "ACGT");
+
+	PG_RETURN_VOID();
+}
+
 /**
  * hash_aligned_dna()
  * 		Returns a CRC32 for a aligned DNA sequence.
@@ -1135,3 +1150,47 @@ Datum octet_length_aligned_dna(PG_FUNCTION_ARGS)
 {
 	PG_RETURN_UINT32((uint32) toast_raw_datum_size((Datum) PG_GETARG_RAW_VARLENA_P(0)));
 }
+
+/**
+ * concat_aligned_dna()
+ * 		Concatenates two aligned DNA sequences. If both were compressed with
+ * 		the same fixed code, the second one is appended without decoding
+ * 		the first one. Otherwise both are decoded and compressed again
+ * 		without restrictions.
+ *
+ * 	Varlena* seq1 : possibly toasted first sequence
+ * 	Varlena* seq2 : possibly toasted second sequence
+ */
+PG_FUNCTION_INFO_V1 (concat_aligned_dna);
+Datum concat_aligned_dna(PG_FUNCTION_ARGS)
+{
+	Varlena* seq1 = PG_GETARG_RAW_VARLENA_P(0);
+	Varlena* seq2 = PG_GETARG_RAW_VARLENA_P(1);
+	PB_AlignedDnaSequenceTypMod typmod = non_restricting_aligned_dna_typmod;
+
+	PB_SequenceInfo* info;
+	PB_CompressedSequence* result;
+	uint8* input;
+	uint32 length;
+
+	PB_TRACE(errmsg("->concat_aligned_dna()"));
+
+	result = sequence_concat(seq1, seq2, fixed_aligned_dna_codes);
+	if (result != NULL)
+	{
+		PB_TRACE(errmsg("<-concat_aligned_dna(): appended"));
+		PG_RETURN_POINTER(result);
+	}
+
+	input = sequence_concat_decoded(seq1, seq2, fixed_aligned_dna_codes, &length);
+
+	info = get_sequence_info_cstring(input, PB_SEQUENCE_INFO_CASE_SENSITIVE);
+	result = compress_aligned_dna_sequence(input, typmod, info);
+
+	PB_SEQUENCE_INFO_PFREE(info);
+	pfree(input);
+
+	PB_TRACE(errmsg("<-concat_aligned_dna()"));
+
+	PG_RETURN_POINTER(result);
+}
@@ -21,6 +21,7 @@
 #include "sequence/sequence.h"
 #include "sequence/stats.h"
 #include "sequence/decompression_iteration.h"
+#include "sequence/functions.h"
 
 /**
  * parse_alphabet_from_text()
@@ -527,24 +528,31 @@ Datum get_alphabet_text_sequence (PG_FUNCTION_ARGS)
 }
 
 /**
- * Creates an alphabet from compressed sequence.
+ * Creates an alphabet from compressed sequence. The symbols are
+ * counted by sequence_count_symbols(), which reads the composition
+ * of the sequence instead of decoding it, if it is included.
  *
- * PB_CompressedSequence* input : the input sequence
+ * Varlena* raw_input : the possibly toasted input sequence
  */
-PB_Alphabet* get_alphabet_compressed_sequence (PB_CompressedSequence* input, PB_CodeSet** fixed_codesets)
+PB_Alphabet* get_alphabet_compressed_sequence (Varlena* raw_input, PB_CodeSet** fixed_codesets)
 {
 	PB_Alphabet* result;
 	PB_SequenceInfo* info;
 	PB_Symbol* symbols;
 	PB_SymbolProbability* probabilities;
 	PB_SymbolProbability sequence_length;
+	uint64 counts[PB_SOURCE_ALPHABET_SIZE];
+	uint64 total = 0;
 	int i;
-	uint8 c;
+
+	sequence_count_symbols(raw_input, 0, PG_UINT32_MAX, fixed_codesets, counts);
 
 	info = palloc0(sizeof(PB_SequenceInfo));
-	PB_BEGIN_DECODE((Varlena*) input, 0, input->sequence_length, fixed_codesets, c) {
-		info->frequencies[c]++;
-	} PB_END_DECODE
+	for (i = 0; i < PB_SOURCE_ALPHABET_SIZE; i++)
+	{
+		info->frequencies[i] = (uint32) counts[i];
+		total += counts[i];
+	}
 
 	collect_alphabet((uint32*) &(info->frequencies),&(info->n_symbols),&(info->symbols), NULL, NULL);
 
@@ -552,7 +560,7 @@ PB_Alphabet* get_alphabet_compressed_sequence (PB_CompressedSequence* input, PB_
 
 	symbols = PB_ALPHABET_SYMBOL_POINTER(result);
 	probabilities = PB_ALPHABET_SYMBOL_PROBABILITY_POINTER(result);
-	sequence_length = (PB_SymbolProbability) input->sequence_length;
+	sequence_length = (PB_SymbolProbability) total;
 
 	for (i = 0; i < info->n_symbols; i++)
 	{
@@ -14,10 +14,14 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
 
 #include "sequence/sequence.h"
 #include "sequence/decompression_iteration.h"
 #include "sequence/stats.h"
+#include "sequence/stream_encoder.h"
+#include "types/dna_sequence.h"
+#include "types/genetic_code.h"
 #include "types/rna_sequence.h"
 #include "types/aa_sequence.h"
 #include "utils/debug.h"
@@ -25,36 +29,90 @@
 Datum transcribe_dna(PG_FUNCTION_ARGS);
 Datum reverse_transcribe_rna(PG_FUNCTION_ARGS);
 Datum translate_rna(PG_FUNCTION_ARGS);
+Datum translate_rna_by_id(PG_FUNCTION_ARGS);
+Datum translate_dna(PG_FUNCTION_ARGS);
+Datum translate_dna_by_id(PG_FUNCTION_ARGS);
+Datum six_frame_translate_rna(PG_FUNCTION_ARGS);
+Datum six_frame_translate_rna_by_id(PG_FUNCTION_ARGS);
+
+/*
+ * Number of amino acids collected before they are handed over to the
+ * stream encoder.
+ */
+#define PB_TRANSLATION_CHUNK_SIZE	1024
+
+/*
+ * Output of a translation.
+ */
+typedef struct {
+	PB_StreamEncoder* encoder;
+	uint32 n_pending;
+	uint8 pending[PB_TRANSLATION_CHUNK_SIZE];
+} PB_TranslationOutput;
+
+/*
+ * State of six_frame_translate() between calls.
+ */
+typedef struct {
+	uint8* sequence;
+	uint32 length;
+	const PB_GeneticCode* code;
+} PB_SixFrameTranslation;
+
+/*
+ * Fixed code id of the transcription of a sequence with a fixed DNA code
+ * and of the reverse transcription of a sequence with a fixed RNA code.
+ * DNA and RNA share the order of their fixed codes, see
+ * get_fixed_dna_code(), so each id maps to the complement code with
+ * the same properties.
+ */
+static const uint8 transcribed_fixed_ids[] = {4, 5, 6, 7, 0, 1, 2, 3};
+
+/*
+ * Symbols of transcribed DNA, 0 for symbols, that are kept.
+ */
+static const uint8 transcription_map[PB_SOURCE_ALPHABET_SIZE] = {
+		['A'] = 'U', ['T'] = 'A', ['C'] = 'G', ['G'] = 'C',
+		['R'] = 'Y', ['Y'] = 'R', ['M'] = 'K', ['K'] = 'M',
+		['D'] = 'H', ['H'] = 'D', ['V'] = 'B', ['B'] = 'V',
+		['a'] = 'u', ['t'] = 'a', ['c'] = 'g', ['g'] = 'c',
+		['r'] = 'y', ['y'] = 'r', ['m'] = 'k', ['k'] = 'm',
+		['d'] = 'h', ['h'] = 'd', ['v'] = 'b', ['b'] = 'v'
+};
+
+/*
+ * Symbols of reverse transcribed RNA, 0 for symbols, that are kept.
+ */
+static const uint8 reverse_transcription_map[PB_SOURCE_ALPHABET_SIZE] = {
+		['A'] = 'T', ['U'] = 'A', ['C'] = 'G', ['G'] = 'C',
+		['R'] = 'Y', ['Y'] = 'R', ['M'] = 'K', ['K'] = 'M',
+		['D'] = 'H', ['H'] = 'D', ['V'] = 'B', ['B'] = 'V',
+		['a'] = 't', ['u'] = 'a', ['c'] = 'g', ['g'] = 'c',
+		['r'] = 'y', ['y'] = 'r', ['m'] = 'k', ['k'] = 'm',
+		['d'] = 'h', ['h'] = 'd', ['v'] = 'b', ['b'] = 'v'
+};
 
 /**
- * transcribe_dna()
- * 		Transcribes DNA to RNA.
+ * relabel_nucleotides()
+ * 		Returns a copy of a compressed sequence, in which every nucleotide
+ * 		is replaced by another one. The stream is copied as it is, only
+ * 		the header or the codewords change, so the cost does not depend
+ * 		on decoding the sequence.
  *
- * 	PB_CompressedSequence* input : compressed input sequence
+ * 	Sequences with a fixed code get the fixed code of the other type with
+ * 	the same id as their complement code. Sequence specific codes are
+ * 	relabeled codeword by codeword.
+ *
+ * 	Datum input : compressed input sequence
+ * 	const uint8* symbol_map : replacement of each symbol, 0 to keep it
  */
-PG_FUNCTION_INFO_V1 (transcribe_dna);
-Datum transcribe_dna(PG_FUNCTION_ARGS)
+static PB_CompressedSequence* relabel_nucleotides(Datum input, const uint8* symbol_map)
 {
-	PB_CompressedSequence* input = (PB_CompressedSequence*)
-			PG_GETARG_VARLENA_P(0);
-	PB_CompressedSequence* result;
-
-	uint32 mem_size = VARSIZE(input);
-
-	PB_TRACE(errmsg("->transcribe_dna()"));
-
-	/*
-	 * Make a copy of the original.
-	 */
-	result = palloc0(mem_size);
-	memcpy(result, input, mem_size);
+	PB_CompressedSequence* result = (PB_CompressedSequence*) PG_DETOAST_DATUM_COPY(input);
 
 	if (result->is_fixed)
 	{
-		/*
-		 * Transcribed DNA is complement RNA
-		 */
-		result->n_swapped_symbols = result->n_swapped_symbols ^ 0x4;
+		result->n_swapped_symbols = transcribed_fixed_ids[result->n_swapped_symbols];
 	}
 	else
 	{
@@ -62,87 +120,31 @@ Datum transcribe_dna(PG_FUNCTION_ARGS)
 		int i;
 
 		for (i = 0; i < result->n_symbols; i++)
-		{
-			uint8 symbol = codewords[i].symbol;
-			switch (symbol)
-			{
-			case 'A':
-				symbol = 'U';
-				break;
-			case 'T':
-				symbol = 'A';
-				break;
-			case 'C':
-				symbol = 'G';
-				break;
-			case 'G':
-				symbol = 'C';
-				break;
-			case 'R':
-				symbol = 'Y';
-				break;
-			case 'Y':
-				symbol = 'R';
-				break;
-			case 'M':
-				symbol = 'K';
-				break;
-			case 'K':
-				symbol = 'M';
-				break;
-			case 'D':
-				symbol = 'H';
-				break;
-			case 'H':
-				symbol = 'D';
-				break;
-			case 'V':
-				symbol = 'B';
-				break;
-			case 'B':
-				symbol = 'V';
-				break;
-			case 'a':
-				symbol = 'u';
-				break;
-			case 't':
-				symbol = 'a';
-				break;
-			case 'c':
-				symbol = 'g';
-				break;
-			case 'g':
-				symbol = 'c';
-				break;
-			case 'r':
-				symbol = 'y';
-				break;
-			case 'y':
-				symbol = 'r';
-				break;
-			case 'm':
-				symbol = 'k';
-				break;
-			case 'k':
-				symbol = 'm';
-				break;
-			case 'd':
-				symbol = 'h';
-				break;
-			case 'h':
-				symbol = 'd';
-				break;
-			case 'v':
-				symbol = 'b';
-				break;
-			case 'b':
-				symbol = 'v';
-				break;
-			}
-			codewords[i].symbol = symbol;
-		}
+			if (symbol_map[codewords[i].symbol] != 0)
+				codewords[i].symbol = symbol_map[codewords[i].symbol];
 	}
 
+	return result;
+}
+
+/**
+ * transcribe_dna()
+ * 		Transcribes DNA to RNA.
+ *
+ * 	PB_CompressedSequence* input : compressed input sequence
+ */
+PG_FUNCTION_INFO_V1 (transcribe_dna);
+Datum transcribe_dna(PG_FUNCTION_ARGS)
+{
+	PB_CompressedSequence* result;
+
+	PB_TRACE(errmsg("->transcribe_dna()"));
+
+	/*
+	 * Transcribed DNA is complement RNA
+	 */
+	result = relabel_nucleotides(PG_GETARG_DATUM(0), transcription_map);
+
 	PB_TRACE(errmsg("<-transcribe_dna()"));
 
 	PG_RETURN_POINTER(result);
@@ -157,117 +159,294 @@ Datum transcribe_dna(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1 (reverse_transcribe_rna);
 Datum reverse_transcribe_rna(PG_FUNCTION_ARGS)
 {
-	PB_CompressedSequence* input = (PB_CompressedSequence*)
-			PG_GETARG_VARLENA_P(0);
 	PB_CompressedSequence* result;
 
-	uint32 mem_size = VARSIZE(input);
-
 	PB_TRACE(errmsg("->reverse_transcribe_rna()"));
 
 	/*
-	 * Make a copy of the original.
+	 * Reverse transcribed RNA is complement DNA.
 	 */
-	result = palloc0(mem_size);
-	memcpy(result, input, mem_size);
+	result = relabel_nucleotides(PG_GETARG_DATUM(0), reverse_transcription_map);
 
-	if (result->is_fixed)
+	PB_TRACE(errmsg("<-reverse_transcribe_rna()"));
+
+	PG_RETURN_POINTER(result);
+}
+
+/**
+ * begin_translation()
+ * 		Prepares the output of a translation. Amino acids are collected
+ * 		in chunks and streamed into an encoder with the fixed IUPAC
+ * 		amino acid code, so that the translation is never materialized
+ * 		as a whole and needs no statistics pass.
+ *
+ * 	PB_TranslationOutput* output : output to initialize
+ */
+static void begin_translation(PB_TranslationOutput* output)
+{
+	output->encoder = stream_encoder_create(get_fixed_aa_codes(), 1, true);
+	output->n_pending = 0;
+}
+
+/**
+ * emit_amino_acid()
+ * 		Appends an amino acid to the output of a translation.
+ *
+ * 	PB_TranslationOutput* output : output of the translation
+ * 	uint8 amino_acid : next amino acid
+ */
+static void emit_amino_acid(PB_TranslationOutput* output, uint8 amino_acid)
+{
+	output->pending[output->n_pending] = amino_acid;
+	output->n_pending++;
+
+	if (output->n_pending == PB_TRANSLATION_CHUNK_SIZE)
+	{
+		stream_encoder_append(output->encoder, output->pending, output->n_pending);
+		output->n_pending = 0;
+	}
+}
+
+/**
+ * finish_translation()
+ * 		Returns the translated amino acid sequence.
+ *
+ * 	PB_TranslationOutput* output : output of the translation
+ */
+static PB_CompressedSequence* finish_translation(PB_TranslationOutput* output)
+{
+	if (output->n_pending > 0)
+		stream_encoder_append(output->encoder, output->pending, output->n_pending);
+
+	return stream_encoder_finish(output->encoder);
+}
+
+/**
+ * get_packed_codon_mask()
+ * 		Returns the mask, that maps packed codons of a code set to packed
+ * 		codons of A, C, G, T/U, or (-1), if the code set does not store
+ * 		the four nucleotides in two bits each. Complemented code sets
+ * 		store U, G, C, A, so all bits of their codons are inverted.
+ *
+ * 	PB_CodeSet* codeset : code set of a sequence
+ */
+static int get_packed_codon_mask(PB_CodeSet* codeset)
+{
+	const uint8* sets = get_nucleotide_sets();
+	bool is_forward = true;
+	bool is_complement = true;
+	int i;
+
+	if (!codeset->is_fixed ||
+		!codeset->has_equal_length ||
+		codeset->uses_rle ||
+		codeset->n_swapped_symbols != 0 ||
+		codeset->n_symbols != 4 ||
+		codeset->max_codeword_length != 2)
+		return (-1);
+
+	for (i = 0; i < 4; i++)
 	{
-		/*
-		 * Reverse transcribed RNA is complement DNA.
-		 */
-		result->n_swapped_symbols = result->n_swapped_symbols ^ 0x4;
+		const int code = codeset->words[i].code >> (PB_PREFIX_CODE_BIT_SIZE - 2);
+		const uint8 set = sets[codeset->words[i].symbol];
+
+		is_forward = is_forward && set == "\4\2\10\1"[code];
+		is_complement = is_complement && set == "\1\10\2\4"[code];
 	}
+
+	if (is_forward)
+		return 0;
+	else if (is_complement)
+		return 0x3F;
 	else
+		return (-1);
+}
+
+/**
+ * translate_packed_codons()
+ * 		Translates a sequence with a packed two-bit nucleotide code. The
+ * 		stream is read 6 bits at a time and each packed codon is looked
+ * 		up directly, without decoding single nucleotides.
+ *
+ * 	Varlena* input : possibly toasted nucleotide sequence
+ * 	PB_CompressedSequence* input_header : detoasted header of input
+ * 	int mask : packed codon mask of the code of input
+ * 	const PB_GeneticCode* code : genetic code
+ * 	PB_TranslationOutput* output : output of the translation
+ */
+static void translate_packed_codons(Varlena* input,
+									PB_CompressedSequence* input_header,
+									int mask,
+									const PB_GeneticCode* code,
+									PB_TranslationOutput* output)
+{
+	const uint32 n_codons = input_header->sequence_length / 3;
+	const int raw_size = toast_raw_datum_size((Datum) input);
+	const int stream_offset = PB_COMPRESSED_SEQUENCE_STREAM_OFFSET(input_header) - VARHDRSZ;
+
+	int slice_size;
+	Varlena* slice;
+
+	PB_CompressionBuffer* input_pointer;
+	PB_CompressionBuffer buffer = 0;
+	int bits_in_buffer = 0;
+	uint32 i;
+
+	if (n_codons == 0)
+		return;
+
+	slice_size = ((uint64) n_codons * 6 / PB_COMPRESSION_BUFFER_BIT_SIZE + 1) * PB_COMPRESSION_BUFFER_BYTE_SIZE;
+	if (slice_size + stream_offset > raw_size)
+		slice_size = raw_size - stream_offset;
+
+	slice = (Varlena*) PG_DETOAST_DATUM_SLICE(input, stream_offset, slice_size);
+	input_pointer = (PB_CompressionBuffer*) VARDATA_ANY(slice);
+
+	for (i = 0; i < n_codons; i++)
 	{
-		PB_Codeword* codewords = PB_COMPRESSED_SEQUENCE_SYMBOL_POINTER(result);
-		int i;
+		int codon;
 
-		for (i = 0; i < result->n_symbols; i++)
+		READ_N_BITS(input_pointer, buffer, bits_in_buffer, codon, 6);
+
+		if (code->packed_codons[codon ^ mask] == '*')
+			break;
+
+		emit_amino_acid(output, code->packed_codons[codon ^ mask]);
+	}
+
+	pfree(slice);
+}
+
+/**
+ * translate_decoded_codons()
+ * 		Translates a sequence with any code. Nucleotides are taken from
+ * 		the multi-symbol decoder and their nucleotide sets form the index
+ * 		of the codon.
+ *
+ * 	Varlena* input : possibly toasted nucleotide sequence
+ * 	uint32 length : length of input
+ * 	PB_CodeSet** fixed_codesets : fixed codes of the type of input
+ * 	const PB_GeneticCode* code : genetic code
+ * 	PB_TranslationOutput* output : output of the translation
+ */
+static void translate_decoded_codons(Varlena* input,
+									 uint32 length,
+									 PB_CodeSet** fixed_codesets,
+									 const PB_GeneticCode* code,
+									 PB_TranslationOutput* output)
+{
+	const uint8* sets = get_nucleotide_sets();
+	uint8 c = 0;
+	int codon = 0;
+	int pos = 0;
+
+	length = length - length % 3;
+	if (length == 0)
+		return;
+
+	PB_BEGIN_DECODE(input, 0, length, fixed_codesets, (c)) {
+		codon = ((codon << 4) | sets[c]) & (PB_GENETIC_CODE_N_CODONS - 1);
+
+		pos++;
+		if (pos == 3)
 		{
-			uint8 symbol = codewords[i].symbol;
-			switch (symbol)
-			{
-			case 'A':
-				symbol = 'T';
-				break;
-			case 'U':
-				symbol = 'A';
-				break;
-			case 'C':
-				symbol = 'G';
-				break;
-			case 'G':
-				symbol = 'C';
-				break;
-			case 'R':
-				symbol = 'Y';
-				break;
-			case 'Y':
-				symbol = 'R';
-				break;
-			case 'M':
-				symbol = 'K';
-				break;
-			case 'K':
-				symbol = 'M';
-				break;
-			case 'D':
-				symbol = 'H';
+			if (code->codons[codon] == '*')
 				break;
-			case 'H':
-				symbol = 'D';
-				break;
-			case 'V':
-				symbol = 'B';
-				break;
-			case 'B':
-				symbol = 'V';
-				break;
-			case 'a':
-				symbol = 't';
-				break;
-			case 'u':
-				symbol = 'a';
-				break;
-			case 'c':
-				symbol = 'g';
-				break;
-			case 'g':
-				symbol = 'c';
-				break;
-			case 'r':
-				symbol = 'y';
-				break;
-			case 'y':
-				symbol = 'r';
-				break;
-			case 'm':
-				symbol = 'k';
-				break;
-			case 'k':
-				symbol = 'm';
-				break;
-			case 'd':
-				symbol = 'h';
-				break;
-			case 'h':
-				symbol = 'd';
-				break;
-			case 'v':
-				symbol = 'b';
-				break;
-			case 'b':
-				symbol = 'v';
-				break;
-			}
-			codewords[i].symbol = symbol;
+
+			emit_amino_acid(output, code->codons[codon]);
+			pos = 0;
+		}
+	} PB_END_DECODE
+}
+
+/**
+ * translate_sequence()
+ * 		Translates a compressed RNA or DNA sequence up to the first stop
+ * 		codon. Ambiguous codons are translated to X.
+ *
+ * 	Varlena* input : possibly toasted nucleotide sequence
+ * 	PB_CodeSet** fixed_codesets : fixed codes of the type of input
+ * 	const PB_GeneticCode* code : genetic code
+ */
+static PB_CompressedSequence* translate_sequence(Varlena* input,
+												 PB_CodeSet** fixed_codesets,
+												 const PB_GeneticCode* code)
+{
+	PB_CompressedSequence* input_header = (PB_CompressedSequence*)
+			PG_DETOAST_DATUM_SLICE(input, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+	PB_TranslationOutput* output = palloc(sizeof(PB_TranslationOutput));
+	PB_CompressedSequence* result;
+	int mask = (-1);
+
+	begin_translation(output);
+
+	if (input_header->is_fixed)
+		mask = get_packed_codon_mask(fixed_codesets[input_header->n_swapped_symbols]);
+
+	if (mask >= 0)
+		translate_packed_codons(input, input_header, mask, code, output);
+	else
+		translate_decoded_codons(input, input_header->sequence_length, fixed_codesets, code, output);
+
+	result = finish_translation(output);
+
+	pfree(output);
+	pfree(input_header);
+
+	return result;
+}
+
+/**
+ * translate_frame()
+ * 		Translates a frame of a decoded RNA sequence up to the first
+ * 		stop codon. The reverse complement of a frame is translated by
+ * 		reading it backwards and complementing each nucleotide.
+ *
+ * 	uint8* input : first nucleotide of the frame
+ * 	uint32 length : number of nucleotides
+ * 	bool reverse_complement : read backwards from input and complement
+ * 	const PB_GeneticCode* code : genetic code
+ */
+static PB_CompressedSequence* translate_frame(uint8* input,
+											  uint32 length,
+											  bool reverse_complement,
+											  const PB_GeneticCode* code)
+{
+	const uint8* sets = get_nucleotide_sets();
+	const int step = reverse_complement ? (-1) : 1;
+	PB_TranslationOutput* output = palloc(sizeof(PB_TranslationOutput));
+	PB_CompressedSequence* result;
+	uint32 i;
+
+	begin_translation(output);
+
+	for (i = 0; i + 3 <= length; i += 3)
+	{
+		int first = sets[input[0]];
+		int second = sets[input[step]];
+		int third = sets[input[2 * step]];
+		uint8 amino_acid;
+
+		input += 3 * step;
+
+		if (reverse_complement)
+		{
+			first = PB_COMPLEMENT_NUCLEOTIDE_SET(first);
+			second = PB_COMPLEMENT_NUCLEOTIDE_SET(second);
+			third = PB_COMPLEMENT_NUCLEOTIDE_SET(third);
 		}
+
+		amino_acid = code->codons[PB_CODON_INDEX(first, second, third)];
+		if (amino_acid == '*')
+			break;
+
+		emit_amino_acid(output, amino_acid);
 	}
 
-	PB_TRACE(errmsg("<-reverse_transcribe_rna()"));
+	result = finish_translation(output);
+	pfree(output);
 
-	PG_RETURN_POINTER(result);
+	return result;
 }
 
 /**
@@ -282,88 +461,194 @@ Datum reverse_transcribe_rna(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1 (translate_rna);
 Datum translate_rna(PG_FUNCTION_ARGS)
 {
-	PB_CompressedSequence* input = (PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
 	text* table_input = (text*) PG_GETARG_VARLENA_P(1);
+	PB_CompressedSequence* result;
+
+	PB_TRACE(errmsg("->translate_rna()"));
 
-	uint8* raw_output = palloc0(input->sequence_length / 3 + 1);
+	result = translate_sequence(input, get_fixed_rna_codes(), get_genetic_code_from_table(table_input));
 
+	PB_TRACE(errmsg("<-translate_rna()"));
+
+	PG_RETURN_POINTER(result);
+}
+
+/**
+ * translate_rna_by_id()
+ * 		Translate an RNA sequence to AA sequence with a genetic code
+ * 		of the registry.
+ *
+ * 	PB_CompressedSequence* input : RNA sequence
+ * 	int32 id : NCBI translation table id
+ */
+PG_FUNCTION_INFO_V1 (translate_rna_by_id);
+Datum translate_rna_by_id(PG_FUNCTION_ARGS)
+{
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
 	PB_CompressedSequence* result;
 
-	PB_TRACE(errmsg("->translate_rna()"));
+	PB_TRACE(errmsg("->translate_rna_by_id()"));
 
-	if (VARSIZE(table_input) - VARHDRSZ != 64)
-		ereport(ERROR, (errmsg("translation table has invalid size"),
-						errdetail("The length of the this translation table is %u.", (VARSIZE(table_input) - VARHDRSZ)),
-						errhint("A translation table must be of length 64.")));
+	result = translate_sequence(input, get_fixed_rna_codes(), get_genetic_code(PG_GETARG_INT32(1)));
 
-	/*
-	 * Translate, write output as cstring
-	 */
-	{
-		uint8 c = 0;
-		int codon = 0;
-		int pos = 0;
+	PB_TRACE(errmsg("<-translate_rna_by_id()"));
+
+	PG_RETURN_POINTER(result);
+}
 
-		uint8* output_pointer = raw_output;
-		uint8* transl_table = (uint8*) VARDATA(table_input);
+/**
+ * translate_dna()
+ * 		Translate a DNA sequence to AA sequence. T is read as U, so
+ * 		the result is the same as translate(transcribe(complement())).
+ *
+ * 	The translation table must be a 64 chars long text.
+ *
+ * 	PB_CompressedSequence* input : DNA sequence
+ * 	text* table_input : translation table
+ */
+PG_FUNCTION_INFO_V1 (translate_dna);
+Datum translate_dna(PG_FUNCTION_ARGS)
+{
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
+	text* table_input = (text*) PG_GETARG_VARLENA_P(1);
+	PB_CompressedSequence* result;
 
-		PB_BEGIN_DECODE((Varlena*) input, 0, input->sequence_length, get_fixed_rna_codes(), (c)) {
-			codon *= 4;
+	PB_TRACE(errmsg("->translate_dna()"));
 
-			switch (TO_UPPER(c)) {
-			case 'U':
-				break;
-			case 'C':
-				codon += 1;
-				break;
-			case 'A':
-				codon += 2;
-				break;
-			case 'G':
-				codon += 3;
-				break;
-			default:
-				codon = 64;
-			}
-
-			pos++;
-			if (pos % 3 == 0)
-			{
-				if (codon < 64)
-				{
-					uint8 out = transl_table[codon];
-					if (out == '*')
-						out = '\0';
-
-					*output_pointer = out;
-				}
-				else
-					*output_pointer = 'X';
-
-				output_pointer++;
-				codon = 0;
-			}
-
-			PB_DEBUG2(errmsg("pos:%d c:%c codon:%d", pos, c, codon));
-		} PB_END_DECODE
-
-		*output_pointer = '\0';
-	}
+	result = translate_sequence(input, get_fixed_dna_codes(), get_genetic_code_from_table(table_input));
 
-	/*
-	 * Compress raw output
-	 */
+	PB_TRACE(errmsg("<-translate_dna()"));
+
+	PG_RETURN_POINTER(result);
+}
+
+/**
+ * translate_dna_by_id()
+ * 		Translate a DNA sequence to AA sequence with a genetic code
+ * 		of the registry.
+ *
+ * 	PB_CompressedSequence* input : DNA sequence
+ * 	int32 id : NCBI translation table id
+ */
+PG_FUNCTION_INFO_V1 (translate_dna_by_id);
+Datum translate_dna_by_id(PG_FUNCTION_ARGS)
+{
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
+	PB_CompressedSequence* result;
+
+	PB_TRACE(errmsg("->translate_dna_by_id()"));
+
+	result = translate_sequence(input, get_fixed_dna_codes(), get_genetic_code(PG_GETARG_INT32(1)));
+
+	PB_TRACE(errmsg("<-translate_dna_by_id()"));
+
+	PG_RETURN_POINTER(result);
+}
+
+/**
+ * six_frame_translate()
+ * 		Translates the three reading frames of a RNA sequence and of its
+ * 		reverse complement, alternating between both strands like
+ * 		six_frame().
+ *
+ * 	The sequence is decoded once. Frames of the reverse complement are
+ * 	translated by reading the decoded sequence backwards, starting
+ * 	offset nucleotides before its end, so that no intermediate RNA
+ * 	sequences are built.
+ *
+ * 	FunctionCallInfo fcinfo : arguments of the SQL function
+ * 	bool by_id : whether the second argument is an NCBI translation
+ * 				 table id instead of a translation table
+ */
+static Datum six_frame_translate(FunctionCallInfo fcinfo, bool by_id)
+{
+	FuncCallContext* funcctx;
+	PB_SixFrameTranslation* state;
+	PB_CompressedSequence* result;
+	uint32 offset;
+
+	if (SRF_IS_FIRSTCALL())
 	{
-		PB_SequenceInfo* info = get_sequence_info_cstring(raw_output, PB_SEQUENCE_INFO_CASE_INSENSITIVE | PB_SEQUENCE_INFO_WITHOUT_RLE);
-		PB_AaSequenceTypMod typmod;
+		MemoryContext oldcontext;
+		Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
+		PB_CompressedSequence* input_header;
+
+		PB_TRACE(errmsg("->six_frame_translate()"));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		input_header = (PB_CompressedSequence*)
+				PG_DETOAST_DATUM_SLICE(input, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+
+		state = palloc0(sizeof(PB_SixFrameTranslation));
+		if (by_id)
+			state->code = get_genetic_code(PG_GETARG_INT32(1));
+		else
+			state->code = get_genetic_code_from_table((text*) PG_GETARG_VARLENA_P(1));
 
-		typmod.case_sensitive = PB_AA_TYPMOD_CASE_INSENSITIVE;
-		typmod.restricting_alphabet = PB_AA_TYPMOD_IUPAC;
+		state->length = input_header->sequence_length;
+		state->sequence = palloc(state->length + 1);
 
-		result = compress_aa_sequence(raw_output, typmod, info);
+		if (state->length > 0)
+			decompress_rna_sequence((PB_CompressedSequence*) input, state->sequence, 0, state->length);
+
+		pfree(input_header);
+
+		funcctx->max_calls = 6;
+		funcctx->user_fctx = state;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		PB_TRACE(errmsg("<-six_frame_translate()"));
 	}
 
-	PB_TRACE(errmsg("<-translate_rna()"));
+	funcctx = SRF_PERCALL_SETUP();
+	state = (PB_SixFrameTranslation*) funcctx->user_fctx;
 
-	PG_RETURN_POINTER(result);
+	if (funcctx->call_cntr >= funcctx->max_calls)
+		SRF_RETURN_DONE(funcctx);
+
+	offset = Min(funcctx->call_cntr / 2, state->length);
+
+	if (funcctx->call_cntr % 2 == 0)
+		result = translate_frame(state->sequence + offset,
+								 state->length - offset,
+								 false,
+								 state->code);
+	else
+		result = translate_frame(state->sequence + Max(state->length - offset, 1) - 1,
+								 state->length - offset,
+								 true,
+								 state->code);
+
+	SRF_RETURN_NEXT(funcctx, PointerGetDatum(result));
+}
+
+/**
+ * six_frame_translate_rna()
+ * 		Translates all six reading frames of a RNA sequence.
+ *
+ * 	PB_CompressedSequence* input : RNA sequence
+ * 	text* table_input : translation table
+ */
+PG_FUNCTION_INFO_V1 (six_frame_translate_rna);
+Datum six_frame_translate_rna(PG_FUNCTION_ARGS)
+{
+	return six_frame_translate(fcinfo, false);
+}
+
+/**
+ * six_frame_translate_rna_by_id()
+ * 		Translates all six reading frames of a RNA sequence with a
+ * 		genetic code of the registry.
+ *
+ * 	PB_CompressedSequence* input : RNA sequence
+ * 	int32 id : NCBI translation table id
+ */
+PG_FUNCTION_INFO_V1 (six_frame_translate_rna_by_id);
+Datum six_frame_translate_rna_by_id(PG_FUNCTION_ARGS)
+{
+	return six_frame_translate(fcinfo, true);
 }
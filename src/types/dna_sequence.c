@@ -15,6 +15,7 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "utils/array.h"
 #include "catalog/pg_type.h"
 #include "access/tuptoaster.h"
@@ -23,7 +24,10 @@
 #include "sequence/stats.h"
 #include "sequence/code_set_creation.h"
 #include "sequence/compression.h"
+#include "sequence/stream_encoder.h"
 #include "sequence/functions.h"
+#include "sequence/kmer_index.h"
+#include "sequence/planner_support.h"
 #include "utils/debug.h"
 #include "types/alphabet.h"
 
@@ -41,7 +45,7 @@ static PB_CodeSet dna_flc = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 0,
+		.fixed_id = (uint8) 0,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 1048714,
@@ -57,7 +61,7 @@ static PB_CodeSet dna_flc_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 1,
+		.fixed_id = (uint8) 1,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 4504192333906058,
@@ -74,7 +78,7 @@ static PB_CodeSet dna_iupac = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 2,
+		.fixed_id = (uint8) 2,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 47999390,
@@ -93,7 +97,7 @@ static PB_CodeSet dna_iupac_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 3,
+		.fixed_id = (uint8) 3,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 206155810325948830,
@@ -116,7 +120,7 @@ static PB_CodeSet dna_flc_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 4,
+		.fixed_id = (uint8) 4,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 1048714,
@@ -132,7 +136,7 @@ static PB_CodeSet dna_flc_cs_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 5,
+		.fixed_id = (uint8) 5,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 4504192333906058,
@@ -149,7 +153,7 @@ static PB_CodeSet dna_iupac_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 6,
+		.fixed_id = (uint8) 6,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 47999390,
@@ -168,7 +172,7 @@ static PB_CodeSet dna_iupac_cs_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 7,
+		.fixed_id = (uint8) 7,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 206155810325948830,
@@ -194,6 +198,15 @@ static PB_CodeSet* fixed_dna_codes[] = {
 		&dna_iupac_cs_complement
 };
 
+/*
+ * Candidate code sets of dna_sequence_agg(), cheapest first.
+ */
+static PB_CodeSet* stream_dna_codes[] = {
+		&dna_flc,
+		&dna_flc_cs,
+		&dna_iupac_cs
+};
+
 PB_DnaSequenceTypMod non_restricting_dna_typmod = {
 	.case_sensitive = PB_DNA_TYPMOD_CASE_SENSITIVE,
 	.restricting_alphabet = PB_DNA_TYPMOD_ASCII,
@@ -312,6 +325,9 @@ PB_CompressedSequence* compress_dna_sequence(uint8* input,
 		ereport(ERROR,(errmsg("input sequence violates alphabet restrictions")));
 	}
 
+	info->with_composition = typmod.composition == PB_DNA_TYPMOD_COMPOSITION;
+	info->index_shift = typmod.index_shift;
+
 	/*
 	 * Choose code set.
 	 */
@@ -375,6 +391,42 @@ PB_CompressedSequence* compress_dna_sequence(uint8* input,
 	return result;
 }
 
+/**
+ * compress_dna_sequence_single_pass()
+ * 		Compress a DNA sequence with the four-letter code without
+ * 		collecting sequence info first.
+ *
+ * 	This only applies to type modifiers, that make compress_dna_sequence()
+ * 	choose a built-in code set regardless of the sequence length. The
+ * 	four-letter code is the cheapest of them, so whenever it can express
+ * 	the sequence, it would have been chosen anyway. Returns NULL if the
+ * 	type modifier or the sequence does not qualify; compress_dna_sequence()
+ * 	has to be used then.
+ *
+ * 	uint8* input : unterminated or null-terminated input sequence
+ * 	int64 length : length of the input sequence
+ * 	PB_DnaSequenceTypMod typmod : target type modifier
+ */
+PB_CompressedSequence* compress_dna_sequence_single_pass(uint8* input,
+														 int64 length,
+														 PB_DnaSequenceTypMod typmod)
+{
+	if (length >= PB_MAX_INPUT_SEQUENCE_LENGTH)
+		return NULL;
+
+	if (typmod.restricting_alphabet != PB_DNA_TYPMOD_FLC &&
+		(typmod.compression_strategy != PB_DNA_TYPMOD_SHORT ||
+		 typmod.restricting_alphabet == PB_DNA_TYPMOD_ASCII))
+		return NULL;
+
+	return encode_fixed(input,
+						(uint32) length,
+						&dna_flc,
+						typmod.case_sensitive != PB_DNA_TYPMOD_CASE_SENSITIVE,
+						typmod.composition == PB_DNA_TYPMOD_COMPOSITION,
+						typmod.index_shift);
+}
+
 /**
  * decompress_dna_sequence()
  * 		Decompress a DNA sequence
@@ -418,6 +470,9 @@ Datum dna_sequence_typmod_in(PG_FUNCTION_ARGS)
 	bool typeModDefault = false;
 	bool typeModShortRead = false;
 	bool typeModRef = false;
+	bool typeModComposition = false;
+	int typeModIndexShift = 0;
+	int shift;
 
 	int i;
 
@@ -445,6 +500,10 @@ Datum dna_sequence_typmod_in(PG_FUNCTION_ARGS)
 			typeModShortRead = true;
 		} else if (!strcmp(read_pointer, "reference")) {
 			typeModRef = true;
+		} else if (!strcmp(read_pointer, "composition")) {
+			typeModComposition = true;
+		} else if ((shift = get_index_shift(read_pointer)) >= 0) {
+			typeModIndexShift = shift;
 		} else {
 			ereport(ERROR,(errmsg("type modifier invalid"),
 					errdetail("Can not recognize type modifier \"%s\".", read_pointer)));
@@ -495,6 +554,14 @@ Datum dna_sequence_typmod_in(PG_FUNCTION_ARGS)
 		result.restricting_alphabet = PB_DNA_TYPMOD_IUPAC;
 	}
 
+	if (typeModComposition) {
+		result.composition = PB_DNA_TYPMOD_COMPOSITION;
+	} else {
+		result.composition = PB_DNA_TYPMOD_NO_COMPOSITION;
+	}
+
+	result.index_shift = typeModIndexShift;
+
 	PB_TRACE(errmsg("<-dna_sequence_typmod_in() returning %d", dna_sequence_typmod_to_int(result)));
 
 	PG_RETURN_INT32(dna_sequence_typmod_to_int(result));
@@ -529,7 +596,7 @@ Datum dna_sequence_typmod_out(PG_FUNCTION_ARGS)
 	if (typmod.compression_strategy == PB_DNA_TYPMOD_SHORT) {
 		len += 11; /* strlen('SHORT_READ,') = 11 */
 	} else if (typmod.compression_strategy == PB_DNA_TYPMOD_REFERENCE) {
-		len += 9; /* strlen('REFERENCE,') = 9 */
+		len += 10; /* strlen('REFERENCE,') = 10 */
 	} else {
 		len += 8; /* strlen('DEFAULT,') = 8 */
 	}
@@ -540,6 +607,14 @@ Datum dna_sequence_typmod_out(PG_FUNCTION_ARGS)
 		len += 5; /* strlen('IUPAC') = 5, strlen('ASCII') = 5  */
 	}
 
+	if (typmod.composition == PB_DNA_TYPMOD_COMPOSITION) {
+		len += 12; /* strlen(',COMPOSITION') = 12 */
+	}
+
+	if (typmod.index_shift != 0) {
+		len += 6; /* strlen(',65536') = 6 */
+	}
+
 	result = palloc0(len);
 	out = result;
 
@@ -559,7 +634,7 @@ Datum dna_sequence_typmod_out(PG_FUNCTION_ARGS)
 		out+=11;
 	} else if (typmod.compression_strategy == PB_DNA_TYPMOD_REFERENCE) {
 		strcpy(out, "REFERENCE,");
-		out+=19;
+		out+=10;
 	} else {
 		strcpy(out, "DEFAULT,");
 		out+=8;
@@ -576,6 +651,15 @@ Datum dna_sequence_typmod_out(PG_FUNCTION_ARGS)
 		out+=5;
 	}
 
+	if (typmod.composition == PB_DNA_TYPMOD_COMPOSITION) {
+		strcpy(out, ",COMPOSITION");
+		out+=12;
+	}
+
+	if (typmod.index_shift != 0) {
+		out += sprintf(out, ",%d", PB_INDEX_PART_SIZE_OF(typmod.index_shift));
+	}
+
 	*out = ')';
 	out++;
 	*out = 0;
@@ -628,11 +712,16 @@ Datum dna_sequence_in (PG_FUNCTION_ARGS)
 	if (typmod.case_sensitive == PB_DNA_TYPMOD_CASE_SENSITIVE)
 		mode |= PB_SEQUENCE_INFO_CASE_SENSITIVE;
 
-	info = get_sequence_info_cstring(input, mode);
+	result = compress_dna_sequence_single_pass(input, strlen((char*) input), typmod);
 
-	result = compress_dna_sequence(input, typmod, info);
+	if (result == NULL)
+	{
+		info = get_sequence_info_cstring(input, mode);
 
-	PB_SEQUENCE_INFO_PFREE(info);
+		result = compress_dna_sequence(input, typmod, info);
+
+		PB_SEQUENCE_INFO_PFREE(info);
+	}
 
 	PB_TRACE(errmsg("<-dna_sequence_in()"));
 
@@ -672,17 +761,103 @@ Datum dna_sequence_in_varlena (PG_FUNCTION_ARGS)
 	if (typmod.case_sensitive == PB_DNA_TYPMOD_CASE_SENSITIVE)
 		mode |= PB_SEQUENCE_INFO_CASE_SENSITIVE;
 
-	info = get_sequence_info_text(input, mode);
+	result = compress_dna_sequence_single_pass((uint8*) VARDATA(input), VARSIZE(input) - VARHDRSZ, typmod);
 
-	result = compress_dna_sequence((uint8*) VARDATA(input), typmod, info);
+	if (result == NULL)
+	{
+		info = get_sequence_info_text(input, mode);
 
-	PB_SEQUENCE_INFO_PFREE(info);
+		result = compress_dna_sequence((uint8*) VARDATA(input), typmod, info);
+
+		PB_SEQUENCE_INFO_PFREE(info);
+	}
 
 	PB_TRACE(errmsg("<-dna_sequence_in_varlena()"));
 
 	PG_RETURN_POINTER(result);
 }
 
+/**
+ * dna_sequence_agg_transfn()
+ * 		Appends a chunk of a sequence to the stream encoder of
+ * 		dna_sequence_agg().
+ *
+ * 	The sequence is encoded case sensitive with the cheapest of the
+ * 	four-letter codes and the IUPAC code, that can express all chunks.
+ * 	Only the compressed stream is kept between calls. NULL chunks are
+ * 	skipped, the encoder is created with the first other chunk, so
+ * 	that the aggregate of NULLs only is NULL.
+ *
+ * 	PB_StreamEncoder* state : stream encoder, NULL before the first chunk
+ * 	text* chunk : next chunk of the sequence
+ */
+PG_FUNCTION_INFO_V1 (dna_sequence_agg_transfn);
+Datum dna_sequence_agg_transfn (PG_FUNCTION_ARGS)
+{
+	MemoryContext agg_context;
+	PB_StreamEncoder* encoder;
+	text* chunk;
+
+	PB_TRACE(errmsg("->dna_sequence_agg_transfn()"));
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		ereport(ERROR,(errmsg("dna_sequence_agg_transfn() called in non-aggregate context")));
+
+	if (PG_ARGISNULL(1))
+	{
+		PB_TRACE(errmsg("<-dna_sequence_agg_transfn(): NULL chunk skipped"));
+
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		MemoryContext old_context = MemoryContextSwitchTo(agg_context);
+
+		encoder = stream_encoder_create(stream_dna_codes,
+										sizeof(stream_dna_codes) / sizeof(PB_CodeSet*),
+										false);
+
+		MemoryContextSwitchTo(old_context);
+	}
+	else
+		encoder = (PB_StreamEncoder*) PG_GETARG_POINTER(0);
+
+	chunk = PG_GETARG_TEXT_PP(1);
+	stream_encoder_append(encoder, (uint8*) VARDATA_ANY(chunk), VARSIZE_ANY_EXHDR(chunk));
+
+	PB_TRACE(errmsg("<-dna_sequence_agg_transfn()"));
+
+	PG_RETURN_POINTER(encoder);
+}
+
+/**
+ * dna_sequence_agg_finalfn()
+ * 		Returns the sequence compressed by dna_sequence_agg(), or NULL
+ * 		if all chunks were NULL.
+ *
+ * 	PB_StreamEncoder* state : stream encoder, NULL if no chunk was given
+ */
+PG_FUNCTION_INFO_V1 (dna_sequence_agg_finalfn);
+Datum dna_sequence_agg_finalfn (PG_FUNCTION_ARGS)
+{
+	PB_CompressedSequence* result;
+
+	PB_TRACE(errmsg("->dna_sequence_agg_finalfn()"));
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	result = stream_encoder_finish((PB_StreamEncoder*) PG_GETARG_POINTER(0));
+
+	PB_TRACE(errmsg("<-dna_sequence_agg_finalfn()"));
+
+	PG_RETURN_POINTER(result);
+}
+
 /**
  * dna_sequence_cast()
  * 		Decompress a given sequence and compress it again
@@ -775,7 +950,7 @@ Datum dna_sequence_out_varlena (PG_FUNCTION_ARGS)
 
 	PB_TRACE(errmsg("->dna_sequence_out_varlena()"));
 
-	result = palloc0(input->sequence_length + VARHDRSZ);
+	result = palloc(input->sequence_length + VARHDRSZ);
 	SET_VARSIZE (result, input->sequence_length + VARHDRSZ);
 	decompress_dna_sequence(input,(uint8*)VARDATA_ANY(result),0,input->sequence_length);
 
@@ -1051,18 +1226,55 @@ Datum dna_sequence_reverse_complement(PG_FUNCTION_ARGS)
  * get_alphabet_dna_sequence()
  * 		Calculates alphabet from DNA sequence.
  *
- * 	PB_CompressedSequence* input : compressed input sequence
+ * 	Varlena* input : possibly toasted input sequence
  */
 PG_FUNCTION_INFO_V1 (get_alphabet_dna_sequence);
 Datum get_alphabet_dna_sequence(PG_FUNCTION_ARGS)
 {
-	PB_CompressedSequence* input =
-			(PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
 	PB_Alphabet* result = get_alphabet_compressed_sequence(input, fixed_dna_codes);
 
 	PG_RETURN_POINTER(result);
 }
 
+/**
+ * gc_content_dna()
+ * 		Returns the fraction of G and C in a DNA sequence or in
+ * 		a range of it, given by start and length like substr().
+ */
+PG_FUNCTION_INFO_V1 (gc_content_dna);
+Datum gc_content_dna(PG_FUNCTION_ARGS)
+{
+	uint32 start;
+	uint32 length;
+
+	sequence_range_args(fcinfo, 1, &start, &length);
+
+	PG_RETURN_FLOAT4(sequence_gc_content((Varlena*) PG_GETARG_RAW_VARLENA_P(0), start, length, fixed_dna_codes));
+}
+
+/**
+ * base_counts_dna()
+ * 		Returns each symbol of a DNA sequence or of a range of it
+ * 		with its number of occurrences.
+ */
+PG_FUNCTION_INFO_V1 (base_counts_dna);
+Datum base_counts_dna(PG_FUNCTION_ARGS)
+{
+	return sequence_symbol_counts(fcinfo, fixed_dna_codes);
+}
+
+/**
+ * entropy_dna()
+ * 		Returns the Shannon entropy of the symbols of a DNA
+ * 		sequence in bits.
+ */
+PG_FUNCTION_INFO_V1 (entropy_dna);
+Datum entropy_dna(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(sequence_entropy((Varlena*) PG_GETARG_RAW_VARLENA_P(0), fixed_dna_codes));
+}
+
 /**
  * equal_dna()
  * 		Compares two DNA sequence for equality
@@ -1205,6 +1417,22 @@ Datum compare_dna(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/**
+ * sortsupport_dna()
+ * 		Sets up sort support for DNA sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+PG_FUNCTION_INFO_V1 (sortsupport_dna);
+Datum sortsupport_dna(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	sequence_sortsupport(ssup, fixed_dna_codes, "ACGT");
+
+	PG_RETURN_VOID();
+}
+
 /**
  * hash_dna()
  * 		Returns a CRC32 for a DNA sequence.
@@ -1246,6 +1474,167 @@ Datum strpos_dna(PG_FUNCTION_ARGS)
 	PG_RETURN_UINT32(result);
 }
 
+/**
+ * strpos_all_dna()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern. The optional third and fourth argument restrict
+ * 		the search to a window of the sequence.
+ */
+PG_FUNCTION_INFO_V1 (strpos_all_dna);
+Datum strpos_all_dna(PG_FUNCTION_ARGS)
+{
+	FuncCallContext* funcctx;
+	uint32* positions;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		Varlena* seq;
+		text* search;
+		uint32 from = 1;
+		uint32 to = PG_UINT32_MAX;
+
+		PB_TRACE(errmsg("->strpos_all_dna()"));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+		search = (text*) PG_GETARG_TEXT_PP(1);
+
+		if (PG_NARGS() == 4)
+		{
+			from = Max(PG_GETARG_INT32(2), 1);
+			to = Max(PG_GETARG_INT32(3), 0);
+		}
+
+		funcctx->max_calls = sequence_find_all(seq, search, from, to, fixed_dna_codes, &positions);
+		funcctx->user_fctx = positions;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		PB_TRACE(errmsg("<-strpos_all_dna()"));
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	positions = (uint32*) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+		SRF_RETURN_NEXT(funcctx, UInt32GetDatum(positions[funcctx->call_cntr]));
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/**
+ * count_occurrences_dna()
+ * 		Counts all, possibly overlapping, occurrences of a pattern. The
+ * 		optional third and fourth argument restrict the search to a
+ * 		window of the sequence.
+ */
+PG_FUNCTION_INFO_V1 (count_occurrences_dna);
+Datum count_occurrences_dna(PG_FUNCTION_ARGS)
+{
+	Varlena* seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+	text* search = (text*) PG_GETARG_TEXT_PP(1);
+	uint32 from = 1;
+	uint32 to = PG_UINT32_MAX;
+	uint32 result;
+
+	PB_TRACE(errmsg("->count_occurrences_dna()"));
+
+	if (PG_NARGS() == 4)
+	{
+		from = Max(PG_GETARG_INT32(2), 1);
+		to = Max(PG_GETARG_INT32(3), 0);
+	}
+
+	result = sequence_find_all(seq, search, from, to, fixed_dna_codes, NULL);
+
+	PB_TRACE(errmsg("<-count_occurrences_dna()"));
+
+	PG_RETURN_INT64(result);
+}
+
+/**
+ * contains_dna()
+ * 		Returns true if a DNA sequence contains a pattern.
+ */
+PG_FUNCTION_INFO_V1 (contains_dna);
+Datum contains_dna(PG_FUNCTION_ARGS)
+{
+	PB_CompressedSequence* seq = (PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	text* search = (text*) PG_GETARG_VARLENA_P(1);
+	bool result;
+
+	PB_TRACE(errmsg("->contains_dna()"));
+
+	result = sequence_strpos(seq, search, fixed_dna_codes) > 0;
+
+	PB_TRACE(errmsg("<-contains_dna()"));
+
+	PG_RETURN_BOOL(result);
+}
+
+/**
+ * planner_support_dna()
+ * 		Planner support for strpos() and contains() of DNA sequences.
+ */
+PG_FUNCTION_INFO_V1 (planner_support_dna);
+Datum planner_support_dna(PG_FUNCTION_ARGS)
+{
+	return sequence_planner_support(fcinfo, 4, PB_NUCLEOTIDE_BITS_PER_SYMBOL);
+}
+
+/**
+ * contains_sel_dna()
+ * 		Restriction selectivity of the @> operator of DNA sequences.
+ */
+PG_FUNCTION_INFO_V1 (contains_sel_dna);
+Datum contains_sel_dna(PG_FUNCTION_ARGS)
+{
+	return sequence_contains_sel(fcinfo, 4, PB_NUCLEOTIDE_BITS_PER_SYMBOL);
+}
+
+/**
+ * gin_extract_value_dna_k8()
+ * 		Extracts the 8-mers of a DNA sequence for a GIN index.
+ */
+PG_FUNCTION_INFO_V1 (gin_extract_value_dna_k8);
+Datum gin_extract_value_dna_k8(PG_FUNCTION_ARGS)
+{
+	return kmer_gin_extract_value(fcinfo, 8, fixed_dna_codes);
+}
+
+/**
+ * gin_extract_query_dna_k8()
+ * 		Extracts the 8-mers of a pattern for a GIN index scan.
+ */
+PG_FUNCTION_INFO_V1 (gin_extract_query_dna_k8);
+Datum gin_extract_query_dna_k8(PG_FUNCTION_ARGS)
+{
+	return kmer_gin_extract_query(fcinfo, 8);
+}
+
+/**
+ * gin_extract_value_dna_k12()
+ * 		Extracts the 12-mers of a DNA sequence for a GIN index.
+ */
+PG_FUNCTION_INFO_V1 (gin_extract_value_dna_k12);
+Datum gin_extract_value_dna_k12(PG_FUNCTION_ARGS)
+{
+	return kmer_gin_extract_value(fcinfo, 12, fixed_dna_codes);
+}
+
+/**
+ * gin_extract_query_dna_k12()
+ * 		Extracts the 12-mers of a pattern for a GIN index scan.
+ */
+PG_FUNCTION_INFO_V1 (gin_extract_query_dna_k12);
+Datum gin_extract_query_dna_k12(PG_FUNCTION_ARGS)
+{
+	return kmer_gin_extract_query(fcinfo, 12);
+}
+
 /**
  * octet_length_dna()
  * 		Returns byte size of datum.
@@ -1255,3 +1644,60 @@ Datum octet_length_dna(PG_FUNCTION_ARGS)
 {
 	PG_RETURN_UINT32((uint32) toast_raw_datum_size((Datum) PG_GETARG_RAW_VARLENA_P(0)));
 }
+
+/**
+ * concat_dna()
+ * 		Concatenates two DNA sequences. If both were compressed with
+ * 		the same case insensitive fixed code, the second one is appended
+ * 		without decoding the first one. Otherwise both are decoded and
+ * 		compressed again with the default type modifier, like text cast
+ * 		to the type, keeping the composition and the index density of
+ * 		the first sequence.
+ *
+ * 	Varlena* seq1 : possibly toasted first sequence
+ * 	Varlena* seq2 : possibly toasted second sequence
+ */
+PG_FUNCTION_INFO_V1 (concat_dna);
+Datum concat_dna(PG_FUNCTION_ARGS)
+{
+	Varlena* seq1 = PG_GETARG_RAW_VARLENA_P(0);
+	Varlena* seq2 = PG_GETARG_RAW_VARLENA_P(1);
+	PB_DnaSequenceTypMod typmod = int_to_dna_sequence_typmod(0);
+	PB_CompressedSequence* header;
+
+	PB_SequenceInfo* info;
+	PB_CompressedSequence* result;
+	uint8* input;
+	uint32 length;
+
+	PB_TRACE(errmsg("->concat_dna()"));
+
+	result = sequence_concat(seq1, seq2, fixed_dna_codes);
+	if (result != NULL)
+	{
+		PB_TRACE(errmsg("<-concat_dna(): appended"));
+		PG_RETURN_POINTER(result);
+	}
+
+	/*
+	 * Keep the composition and the index density of the first sequence.
+	 */
+	header = (PB_CompressedSequence*)
+			 PG_DETOAST_DATUM_SLICE(seq1, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+	if (header->has_composition)
+		typmod.composition = PB_DNA_TYPMOD_COMPOSITION;
+	typmod.index_shift = header->index_shift;
+	pfree(header);
+
+	input = sequence_concat_decoded(seq1, seq2, fixed_dna_codes, &length);
+
+	info = get_sequence_info_cstring(input, 0);
+	result = compress_dna_sequence(input, typmod, info);
+
+	PB_SEQUENCE_INFO_PFREE(info);
+	pfree(input);
+
+	PB_TRACE(errmsg("<-concat_dna()"));
+
+	PG_RETURN_POINTER(result);
+}
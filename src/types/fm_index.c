@@ -0,0 +1,176 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   src/types/fm_index.c
+*
+*-------------------------------------------------------------------------
+*/
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "access/tuptoaster.h"
+#include "utils/memutils.h"
+
+#include "sequence/sequence.h"
+#include "sequence/compression.h"
+#include "sequence/fm_index.h"
+#include "utils/debug.h"
+#include "types/dna_sequence.h"
+
+#include "types/fm_index.h"
+
+/**
+ * fm_index_in()
+ * 		Builds an FM-index from a cstring.
+ *
+ * 	char* input : sequence to index
+ */
+PG_FUNCTION_INFO_V1 (fm_index_in);
+Datum fm_index_in(PG_FUNCTION_ARGS)
+{
+	char* input = PG_GETARG_CSTRING(0);
+	PB_FMIndex* result;
+
+	PB_TRACE(errmsg("->fm_index_in()"));
+
+	result = fm_index_create((uint8*) input, strlen(input));
+
+	PB_TRACE(errmsg("<-fm_index_in()"));
+
+	PG_RETURN_POINTER(result);
+}
+
+/**
+ * fm_index_out()
+ * 		Restores the indexed sequence.
+ *
+ * 	PB_FMIndex* input : FM-index
+ */
+PG_FUNCTION_INFO_V1 (fm_index_out);
+Datum fm_index_out(PG_FUNCTION_ARGS)
+{
+	PB_FMIndex* input = (PB_FMIndex*) PG_GETARG_VARLENA_P(0);
+	char* result;
+
+	PB_TRACE(errmsg("->fm_index_out()"));
+
+	result = fm_index_to_cstring(input);
+
+	PB_TRACE(errmsg("<-fm_index_out()"));
+
+	PG_RETURN_CSTRING(result);
+}
+
+/**
+ * fm_index_dna()
+ * 		Builds an FM-index from a DNA sequence.
+ *
+ * 	Varlena* seq : possibly toasted DNA sequence
+ */
+PG_FUNCTION_INFO_V1 (fm_index_dna);
+Datum fm_index_dna(PG_FUNCTION_ARGS)
+{
+	Varlena* seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+	PB_CompressedSequence* header;
+	PB_FMIndex* result;
+	uint8* decoded;
+	uint32 length;
+
+	PB_TRACE(errmsg("->fm_index_dna()"));
+
+	header = (PB_CompressedSequence*)
+			 PG_DETOAST_DATUM_SLICE(seq, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+	length = header->sequence_length;
+	pfree(header);
+
+	decoded = MemoryContextAllocHuge(CurrentMemoryContext, (Size) length + 1);
+	decode(seq, decoded, 0, length, get_fixed_dna_codes());
+
+	result = fm_index_create(decoded, length);
+	pfree(decoded);
+
+	PB_TRACE(errmsg("<-fm_index_dna()"));
+
+	PG_RETURN_POINTER(result);
+}
+
+/**
+ * count_fm_index()
+ * 		Counts all, possibly overlapping, occurrences of a pattern.
+ */
+PG_FUNCTION_INFO_V1 (count_fm_index);
+Datum count_fm_index(PG_FUNCTION_ARGS)
+{
+	Varlena* index = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+	text* pattern = (text*) PG_GETARG_TEXT_PP(1);
+	uint32 result;
+
+	PB_TRACE(errmsg("->count_fm_index()"));
+
+	result = fm_index_find(index, pattern, NULL);
+
+	PB_TRACE(errmsg("<-count_fm_index()"));
+
+	PG_RETURN_INT64(result);
+}
+
+/**
+ * locate_fm_index()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern in ascending order.
+ */
+PG_FUNCTION_INFO_V1 (locate_fm_index);
+Datum locate_fm_index(PG_FUNCTION_ARGS)
+{
+	FuncCallContext* funcctx;
+	uint32* positions;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		Varlena* index;
+		text* pattern;
+
+		PB_TRACE(errmsg("->locate_fm_index()"));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		index = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+		pattern = (text*) PG_GETARG_TEXT_PP(1);
+
+		funcctx->max_calls = fm_index_find(index, pattern, &positions);
+		funcctx->user_fctx = positions;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		PB_TRACE(errmsg("<-locate_fm_index()"));
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	positions = (uint32*) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+		SRF_RETURN_NEXT(funcctx, UInt32GetDatum(positions[funcctx->call_cntr]));
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/**
+ * length_fm_index()
+ * 		Returns the length of the indexed sequence. Reads the header only.
+ */
+PG_FUNCTION_INFO_V1 (length_fm_index);
+Datum length_fm_index(PG_FUNCTION_ARGS)
+{
+	PB_FMIndex* header = (PB_FMIndex*)
+			PG_DETOAST_DATUM_SLICE(PG_GETARG_RAW_VARLENA_P(0), 0, offsetof(PB_FMIndex, data) - VARHDRSZ);
+
+	PG_RETURN_INT32(header->sequence_length);
+}
@@ -0,0 +1,333 @@
+/*-------------------------------------------------------------------------
+*
+* Copyright (c) 2013, Max Planck Institute for Marine Microbiology
+*
+* This software is released under the PostgreSQL License
+*
+* Author: Michael Schneider <mschneid@mpi-bremen.de>
+*
+* IDENTIFICATION
+*   src/types/genetic_code.c
+*
+*-------------------------------------------------------------------------
+*/
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+
+#include "sequence/sequence.h"
+#include "utils/debug.h"
+
+#include "types/genetic_code.h"
+
+/**
+ * Section 1 - static fields
+ */
+
+/*
+ * A translation table of the NCBI registry.
+ */
+typedef struct {
+	int32 id;
+	const char* amino_acids;
+} PB_GeneticCodeDefinition;
+
+/*
+ * All genetic codes of NCBI, see
+ * https://www.ncbi.nlm.nih.gov/Taxonomy/Utils/wprintgc.cgi
+ */
+static const PB_GeneticCodeDefinition genetic_code_definitions[] = {
+		/* Standard */
+		{1, "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Vertebrate Mitochondrial */
+		{2, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG"},
+		/* Yeast Mitochondrial */
+		{3, "FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Mold, Protozoan, Coelenterate Mitochondrial and Mycoplasma/Spiroplasma */
+		{4, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Invertebrate Mitochondrial */
+		{5, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG"},
+		/* Ciliate, Dasycladacean and Hexamita Nuclear */
+		{6, "FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Echinoderm and Flatworm Mitochondrial */
+		{9, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG"},
+		/* Euplotid Nuclear */
+		{10, "FFLLSSSSYY**CCCWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Bacterial, Archaeal and Plant Plastid */
+		{11, "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Alternative Yeast Nuclear */
+		{12, "FFLLSSSSYY**CC*WLLLSPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Ascidian Mitochondrial */
+		{13, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSGGVVVVAAAADDEEGGGG"},
+		/* Alternative Flatworm Mitochondrial */
+		{14, "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG"},
+		/* Blepharisma Nuclear */
+		{15, "FFLLSSSSYY*QCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Chlorophycean Mitochondrial */
+		{16, "FFLLSSSSYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Trematode Mitochondrial */
+		{21, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNNKSSSSVVVVAAAADDEEGGGG"},
+		/* Scenedesmus obliquus Mitochondrial */
+		{22, "FFLLSS*SYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Thraustochytrium Mitochondrial */
+		{23, "FF*LSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Pterobranchia Mitochondrial */
+		{24, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG"},
+		/* Candidate Division SR1 and Gracilibacteria */
+		{25, "FFLLSSSSYY**CCGWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Pachysolen tannophilus Nuclear */
+		{26, "FFLLSSSSYY**CC*WLLLAPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Karyorelict Nuclear */
+		{27, "FFLLSSSSYYQQCCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Condylostoma Nuclear */
+		{28, "FFLLSSSSYYQQCCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Mesodinium Nuclear */
+		{29, "FFLLSSSSYYYYCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Peritrich Nuclear */
+		{30, "FFLLSSSSYYEECC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Blastocrithidia Nuclear */
+		{31, "FFLLSSSSYYEECCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Balanophoraceae Plastid */
+		{32, "FFLLSSSSYY*WCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},
+		/* Cephalodiscidae Mitochondrial */
+		{33, "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG"}
+};
+
+#define PB_N_GENETIC_CODES	(sizeof(genetic_code_definitions) / sizeof(PB_GeneticCodeDefinition))
+
+/*
+ * Genetic codes of the registry, built on first use.
+ */
+static PB_GeneticCode* genetic_codes[PB_N_GENETIC_CODES];
+
+static const uint8 nucleotide_sets[PB_SOURCE_ALPHABET_SIZE] = {
+		['U'] = PB_NUCLEOTIDE_SET_U,
+		['T'] = PB_NUCLEOTIDE_SET_U,
+		['C'] = PB_NUCLEOTIDE_SET_C,
+		['A'] = PB_NUCLEOTIDE_SET_A,
+		['G'] = PB_NUCLEOTIDE_SET_G,
+		['R'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_G,
+		['Y'] = PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_U,
+		['S'] = PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_C,
+		['W'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_U,
+		['K'] = PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U,
+		['M'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C,
+		['B'] = PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U,
+		['D'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U,
+		['H'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_U,
+		['V'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_G,
+		['N'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U,
+		['u'] = PB_NUCLEOTIDE_SET_U,
+		['t'] = PB_NUCLEOTIDE_SET_U,
+		['c'] = PB_NUCLEOTIDE_SET_C,
+		['a'] = PB_NUCLEOTIDE_SET_A,
+		['g'] = PB_NUCLEOTIDE_SET_G,
+		['r'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_G,
+		['y'] = PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_U,
+		['s'] = PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_C,
+		['w'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_U,
+		['k'] = PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U,
+		['m'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C,
+		['b'] = PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U,
+		['d'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U,
+		['h'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_U,
+		['v'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_G,
+		['n'] = PB_NUCLEOTIDE_SET_A | PB_NUCLEOTIDE_SET_C | PB_NUCLEOTIDE_SET_G | PB_NUCLEOTIDE_SET_U
+};
+
+/*
+ * Nucleotide sets of the 2-bit FLC codes 0 to 3.
+ */
+static const uint8 packed_nucleotide_sets[4] = {
+		PB_NUCLEOTIDE_SET_A,
+		PB_NUCLEOTIDE_SET_C,
+		PB_NUCLEOTIDE_SET_G,
+		PB_NUCLEOTIDE_SET_U
+};
+
+/*
+ * Section 2 - static functions
+ */
+
+/**
+ * translate_nucleotide_sets()
+ * 		Returns the amino acid, that all codons of three nucleotide sets
+ * 		translate to, or X if they differ or a set is empty.
+ *
+ * 	const uint8* amino_acids : translation table
+ * 	int first, second, third : nucleotide sets
+ */
+static uint8 translate_nucleotide_sets(const uint8* amino_acids, int first, int second, int third)
+{
+	uint8 result = '\0';
+	int i, j, k;
+
+	if (first == 0 || second == 0 || third == 0)
+		return 'X';
+
+	for (i = 0; i < 4; i++)
+	{
+		if ((first & (1 << i)) == 0)
+			continue;
+
+		for (j = 0; j < 4; j++)
+		{
+			if ((second & (1 << j)) == 0)
+				continue;
+
+			for (k = 0; k < 4; k++)
+			{
+				uint8 amino_acid;
+
+				if ((third & (1 << k)) == 0)
+					continue;
+
+				amino_acid = amino_acids[(i << 4) | (j << 2) | k];
+				if (result == '\0')
+					result = amino_acid;
+				else if (result != amino_acid)
+					return 'X';
+			}
+		}
+	}
+
+	return result;
+}
+
+/**
+ * build_genetic_code()
+ * 		Fills the lookup tables of a genetic code from a translation table.
+ *
+ * 	PB_GeneticCode* code : genetic code to fill
+ * 	int32 id : NCBI translation table id, 0 for custom tables
+ * 	const uint8* amino_acids : translation table of 64 chars
+ */
+static void build_genetic_code(PB_GeneticCode* code, int32 id, const uint8* amino_acids)
+{
+	int i;
+
+	code->id = id;
+	memcpy(code->amino_acids, amino_acids, 64);
+
+	for (i = 0; i < PB_GENETIC_CODE_N_CODONS; i++)
+		code->codons[i] = translate_nucleotide_sets(amino_acids, i >> 8, (i >> 4) & 0xF, i & 0xF);
+
+	for (i = 0; i < 64; i++)
+		code->packed_codons[i] = code->codons[PB_CODON_INDEX(packed_nucleotide_sets[i >> 4],
+															 packed_nucleotide_sets[(i >> 2) & 0x3],
+															 packed_nucleotide_sets[i & 0x3])];
+}
+
+/**
+ * get_registered_genetic_code()
+ * 		Returns the genetic code of an entry of the registry and builds
+ * 		it, if necessary.
+ *
+ * 	int entry : index into genetic_code_definitions
+ */
+static const PB_GeneticCode* get_registered_genetic_code(int entry)
+{
+	if (genetic_codes[entry] == NULL)
+	{
+		PB_GeneticCode* code = MemoryContextAlloc(TopMemoryContext, sizeof(PB_GeneticCode));
+
+		PB_DEBUG1(errmsg("get_registered_genetic_code(): building table %d", genetic_code_definitions[entry].id));
+
+		build_genetic_code(code,
+						   genetic_code_definitions[entry].id,
+						   (const uint8*) genetic_code_definitions[entry].amino_acids);
+		genetic_codes[entry] = code;
+	}
+
+	return genetic_codes[entry];
+}
+
+/**
+ * find_genetic_code()
+ * 		Returns the registry entry of an NCBI translation table id or
+ * 		raises an error.
+ *
+ * 	int32 id : NCBI translation table id
+ */
+static int find_genetic_code(int32 id)
+{
+	int i;
+
+	for (i = 0; i < PB_N_GENETIC_CODES; i++)
+		if (genetic_code_definitions[i].id == id)
+			return i;
+
+	ereport(ERROR, (errmsg("translation table %d does not exist", id)));
+
+	return (-1);
+}
+
+/*
+ * Section 3 - public functions
+ */
+
+/**
+ * get_nucleotide_sets()
+ * 		Returns the nucleotide set of every symbol.
+ */
+const uint8* get_nucleotide_sets(void)
+{
+	return nucleotide_sets;
+}
+
+/**
+ * get_genetic_code()
+ * 		Returns the genetic code of an NCBI translation table id.
+ *
+ * 	int32 id : NCBI translation table id
+ */
+const PB_GeneticCode* get_genetic_code(int32 id)
+{
+	return get_registered_genetic_code(find_genetic_code(id));
+}
+
+/**
+ * get_genetic_code_from_table()
+ * 		Returns the genetic code of a 64 chars long translation table.
+ *
+ * 	text* table_input : translation table
+ */
+const PB_GeneticCode* get_genetic_code_from_table(text* table_input)
+{
+	const uint8* amino_acids = (uint8*) VARDATA(table_input);
+	PB_GeneticCode* result;
+	int i;
+
+	if (VARSIZE(table_input) - VARHDRSZ != 64)
+		ereport(ERROR, (errmsg("translation table has invalid size"),
+						errdetail("The length of the this translation table is %u.", (VARSIZE(table_input) - VARHDRSZ)),
+						errhint("A translation table must be of length 64.")));
+
+	for (i = 0; i < PB_N_GENETIC_CODES; i++)
+		if (memcmp(genetic_code_definitions[i].amino_acids, amino_acids, 64) == 0)
+			return get_registered_genetic_code(i);
+
+	result = palloc(sizeof(PB_GeneticCode));
+	build_genetic_code(result, 0, amino_acids);
+
+	return result;
+}
+
+/*
+ * Section 4 - SQL functions
+ */
+
+/**
+ * get_transl_table()
+ * 		Returns the translation table of an NCBI translation table id.
+ *
+ * 	int32 id : NCBI translation table id
+ */
+PG_FUNCTION_INFO_V1 (get_transl_table);
+Datum get_transl_table(PG_FUNCTION_ARGS)
+{
+	const int entry = find_genetic_code(PG_GETARG_INT32(0));
+
+	PG_RETURN_TEXT_P(cstring_to_text_with_len(genetic_code_definitions[entry].amino_acids, 64));
+}
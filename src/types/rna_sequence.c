@@ -15,6 +15,7 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "utils/array.h"
 #include "catalog/pg_type.h"
 #include "access/tuptoaster.h"
@@ -24,6 +25,7 @@
 #include "sequence/code_set_creation.h"
 #include "sequence/compression.h"
 #include "sequence/functions.h"
+#include "sequence/planner_support.h"
 #include "utils/debug.h"
 #include "types/alphabet.h"
 
@@ -41,7 +43,7 @@ static PB_CodeSet rna_flc = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 0,
+		.fixed_id = (uint8) 0,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 2097290,
@@ -57,7 +59,7 @@ static PB_CodeSet rna_flc_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 1,
+		.fixed_id = (uint8) 1,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 9007791962325130,
@@ -74,7 +76,7 @@ static PB_CodeSet rna_iupac = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 2,
+		.fixed_id = (uint8) 2,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 49047966,
@@ -93,7 +95,7 @@ static PB_CodeSet rna_iupac_cs = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 3,
+		.fixed_id = (uint8) 3,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 210659409954367902,
@@ -116,7 +118,7 @@ static PB_CodeSet rna_flc_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 4,
+		.fixed_id = (uint8) 4,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 2097290,
@@ -132,7 +134,7 @@ static PB_CodeSet rna_flc_cs_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 5,
+		.fixed_id = (uint8) 5,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 9007791962325130,
@@ -149,7 +151,7 @@ static PB_CodeSet rna_iupac_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) true,
-		.fixed_id = (bool) 6,
+		.fixed_id = (uint8) 6,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 49047966,
@@ -168,7 +170,7 @@ static PB_CodeSet rna_iupac_cs_complement = {
 		.is_fixed = (bool) true,
 		.uses_rle = (bool) false,
 		.ignore_case = (bool) false,
-		.fixed_id = (bool) 7,
+		.fixed_id = (uint8) 7,
 		.swap_savings = (uint64) 0,
 		.ascii_bitmap_low = (uint64) 0,
 		.ascii_bitmap_high = (uint64) 210659409954367902,
@@ -302,6 +304,9 @@ PB_CompressedSequence* compress_rna_sequence(uint8* input,
 		ereport(ERROR,(errmsg("input sequence violates alphabet restrictions")));
 	}
 
+	info->with_composition = typmod.composition == PB_RNA_TYPMOD_COMPOSITION;
+	info->index_shift = typmod.index_shift;
+
 	/*
 	 * Choose code set.
 	 */
@@ -312,9 +317,10 @@ PB_CompressedSequence* compress_rna_sequence(uint8* input,
 		uint8 fixed_code_id;
 
 		/*
-		 * Choose applicable pre-built code set.
+		 * Choose applicable pre-built code set. Without the FLC type
+		 * modifier the sequence might need the IUPAC code.
 		 */
-		if (typmod.restricting_alphabet == PB_RNA_TYPMOD_IUPAC) {
+		if (typmod.restricting_alphabet != PB_RNA_TYPMOD_FLC) {
 			if (typmod.case_sensitive == PB_RNA_TYPMOD_CASE_SENSITIVE) {
 				fixed_code_id = 3;
 			} else {
@@ -404,6 +410,9 @@ Datum rna_sequence_typmod_in(PG_FUNCTION_ARGS) {
 	bool typeModIupac = false;
 	bool typeModFlc = false;
 	bool typeModAscii = false;
+	bool typeModComposition = false;
+	int typeModIndexShift = 0;
+	int shift;
 
 	int i;
 
@@ -424,6 +433,10 @@ Datum rna_sequence_typmod_in(PG_FUNCTION_ARGS) {
 			typeModFlc = true;
 		} else if (!strcmp(read_pointer, "ascii")) {
 			typeModAscii = true;
+		} else if (!strcmp(read_pointer, "composition")) {
+			typeModComposition = true;
+		} else if ((shift = get_index_shift(read_pointer)) >= 0) {
+			typeModIndexShift = shift;
 		} else {
 			ereport(ERROR,(errmsg("type modifier invalid"),
 					errdetail("Can not recognize type modifier \"%s\".", read_pointer)));
@@ -459,6 +472,14 @@ Datum rna_sequence_typmod_in(PG_FUNCTION_ARGS) {
 		result.restricting_alphabet = PB_RNA_TYPMOD_IUPAC;
 	}
 
+	if (typeModComposition) {
+		result.composition = PB_RNA_TYPMOD_COMPOSITION;
+	} else {
+		result.composition = PB_RNA_TYPMOD_NO_COMPOSITION;
+	}
+
+	result.index_shift = typeModIndexShift;
+
 	PB_TRACE(errmsg("<-rna_sequence_typmod_in() returning %d", rna_sequence_typmod_to_int(result)));
 
 	PG_RETURN_INT32(rna_sequence_typmod_to_int(result));
@@ -493,6 +514,14 @@ Datum rna_sequence_typmod_out(PG_FUNCTION_ARGS) {
 		len += 5; /* strlen('IUPAC') = 5, strlen('ASCII') = 5  */
 	}
 
+	if (typmod.composition == PB_RNA_TYPMOD_COMPOSITION) {
+		len += 12; /* strlen(',COMPOSITION') = 12 */
+	}
+
+	if (typmod.index_shift != 0) {
+		len += 6; /* strlen(',65536') = 6 */
+	}
+
 	result = palloc0(len);
 	out = result;
 
@@ -518,6 +547,15 @@ Datum rna_sequence_typmod_out(PG_FUNCTION_ARGS) {
 		out+=5;
 	}
 
+	if (typmod.composition == PB_RNA_TYPMOD_COMPOSITION) {
+		strcpy(out, ",COMPOSITION");
+		out+=12;
+	}
+
+	if (typmod.index_shift != 0) {
+		out += sprintf(out, ",%d", PB_INDEX_PART_SIZE_OF(typmod.index_shift));
+	}
+
 	*out = ')';
 	out++;
 	*out = 0;
@@ -706,7 +744,7 @@ Datum rna_sequence_out_varlena (PG_FUNCTION_ARGS)
 
 	PB_TRACE(errmsg("->rna_sequence_out_varlena()"));
 
-	result = palloc0(input->sequence_length + VARHDRSZ);
+	result = palloc(input->sequence_length + VARHDRSZ);
 	SET_VARSIZE (result, input->sequence_length + VARHDRSZ);
 	decompress_rna_sequence(input, (uint8*) VARDATA_ANY(result), 0, input->sequence_length);
 
@@ -976,22 +1014,172 @@ Datum rna_sequence_reverse_complement(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(result);
 }
 
+/*
+ * State of rna_sequence_six_frame() between calls.
+ */
+typedef struct {
+	PB_CompressedSequence* sequence;
+	uint8* forward;
+	uint8* reverse;
+	uint32 length;
+	PB_RnaSequenceTypMod typmod;
+} PB_SixFrameState;
+
+/**
+ * compress_frame()
+ * 		Compresses a frame of a decoded sequence.
+ *
+ * 	uint8* input : null-terminated frame
+ * 	PB_RnaSequenceTypMod typmod : target type modifier
+ */
+static PB_CompressedSequence* compress_frame(uint8* input, PB_RnaSequenceTypMod typmod)
+{
+	PB_SequenceInfo* info;
+	PB_CompressedSequence* result;
+
+	info = get_sequence_info_cstring(input, PB_SEQUENCE_INFO_CASE_SENSITIVE);
+	result = compress_rna_sequence(input, typmod, info);
+
+	PB_SEQUENCE_INFO_PFREE(info);
+
+	return result;
+}
+
+/**
+ * rna_sequence_six_frame()
+ * 		Returns the three reading frames of a RNA sequence and of its
+ * 		reverse complement, alternating between both strands.
+ *
+ * 	The sequence is decoded once and reversed once. The first frame is
+ * 	the sequence itself, the other forward frames are suffixes of the
+ * 	decoded sequence. The frames of the reverse complement are suffixes
+ * 	of the reversed sequence, which are compressed and then complemented
+ * 	by relabeling their code.
+ *
+ * 	PB_CompressedSequence* input : compressed input sequence
+ */
+PG_FUNCTION_INFO_V1 (rna_sequence_six_frame);
+Datum rna_sequence_six_frame(PG_FUNCTION_ARGS)
+{
+	FuncCallContext* funcctx;
+	PB_SixFrameState* state;
+	PB_CompressedSequence* result;
+	uint32 offset;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		uint32 i;
+
+		PB_TRACE(errmsg("->rna_sequence_six_frame()"));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		state = palloc0(sizeof(PB_SixFrameState));
+		state->sequence = (PB_CompressedSequence*) PG_DETOAST_DATUM_COPY(PG_GETARG_DATUM(0));
+		state->length = state->sequence->sequence_length;
+
+		/*
+		 * Frames are compressed without restrictions and keep the
+		 * composition and the index density of the sequence.
+		 */
+		state->typmod = non_restricting_rna_typmod;
+		if (state->sequence->has_composition)
+			state->typmod.composition = PB_RNA_TYPMOD_COMPOSITION;
+		state->typmod.index_shift = state->sequence->index_shift;
+
+		state->forward = palloc(state->length + 1);
+		state->reverse = palloc(state->length + 1);
+		decompress_rna_sequence(state->sequence, state->forward, 0, state->length);
+
+		for (i = 0; i < state->length; i++)
+			state->reverse[i] = state->forward[state->length - 1 - i];
+		state->forward[state->length] = '\0';
+		state->reverse[state->length] = '\0';
+
+		funcctx->max_calls = 6;
+		funcctx->user_fctx = state;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		PB_TRACE(errmsg("<-rna_sequence_six_frame()"));
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = (PB_SixFrameState*) funcctx->user_fctx;
+
+	if (funcctx->call_cntr >= funcctx->max_calls)
+		SRF_RETURN_DONE(funcctx);
+
+	offset = Min(funcctx->call_cntr / 2, state->length);
+
+	if (funcctx->call_cntr == 0)
+		result = state->sequence;
+	else if (funcctx->call_cntr % 2 == 0)
+		result = compress_frame(state->forward + offset, state->typmod);
+	else
+	{
+		result = compress_frame(state->reverse + offset, state->typmod);
+		complement_rna(result);
+	}
+
+	SRF_RETURN_NEXT(funcctx, PointerGetDatum(result));
+}
+
 /**
  * get_alphabet_rna_sequence()
  * 		Calculates alphabet from RNA sequence.
  *
- * 	PB_CompressedSequence* input : compressed input sequence
+ * 	Varlena* input : possibly toasted input sequence
  */
 PG_FUNCTION_INFO_V1 (get_alphabet_rna_sequence);
 Datum get_alphabet_rna_sequence(PG_FUNCTION_ARGS)
 {
-	PB_CompressedSequence* input =
-			(PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	Varlena* input = PG_GETARG_RAW_VARLENA_P(0);
 	PB_Alphabet* result = get_alphabet_compressed_sequence(input, fixed_rna_codes);
 
 	PG_RETURN_POINTER(result);
 }
 
+/**
+ * gc_content_rna()
+ * 		Returns the fraction of G and C in an RNA sequence or in
+ * 		a range of it, given by start and length like substr().
+ */
+PG_FUNCTION_INFO_V1 (gc_content_rna);
+Datum gc_content_rna(PG_FUNCTION_ARGS)
+{
+	uint32 start;
+	uint32 length;
+
+	sequence_range_args(fcinfo, 1, &start, &length);
+
+	PG_RETURN_FLOAT4(sequence_gc_content((Varlena*) PG_GETARG_RAW_VARLENA_P(0), start, length, fixed_rna_codes));
+}
+
+/**
+ * base_counts_rna()
+ * 		Returns each symbol of an RNA sequence or of a range of it
+ * 		with its number of occurrences.
+ */
+PG_FUNCTION_INFO_V1 (base_counts_rna);
+Datum base_counts_rna(PG_FUNCTION_ARGS)
+{
+	return sequence_symbol_counts(fcinfo, fixed_rna_codes);
+}
+
+/**
+ * entropy_rna()
+ * 		Returns the Shannon entropy of the symbols of an RNA
+ * 		sequence in bits.
+ */
+PG_FUNCTION_INFO_V1 (entropy_rna);
+Datum entropy_rna(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(sequence_entropy((Varlena*) PG_GETARG_RAW_VARLENA_P(0), fixed_rna_codes));
+}
+
 /**
  * equal_rna()
  * 		Compares two RNA sequence for equality
@@ -1134,6 +1322,22 @@ Datum compare_rna(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/**
+ * sortsupport_rna()
+ * 		Sets up sort support for RNA sequences.
+ *
+ * 	SortSupport ssup : sort support to set up
+ */
+PG_FUNCTION_INFO_V1 (sortsupport_rna);
+Datum sortsupport_rna(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	sequence_sortsupport(ssup, fixed_rna_codes, "ACGU");
+
+	PG_RETURN_VOID();
+}
+
 /**
  * hash_rna()
  * 		Returns a CRC32 for a RNA sequence.
@@ -1175,6 +1379,117 @@ Datum strpos_rna(PG_FUNCTION_ARGS)
 	PG_RETURN_UINT32(result);
 }
 
+/**
+ * contains_rna()
+ * 		Returns true if an RNA sequence contains a pattern.
+ */
+PG_FUNCTION_INFO_V1 (contains_rna);
+Datum contains_rna(PG_FUNCTION_ARGS)
+{
+	PB_CompressedSequence* seq = (PB_CompressedSequence*) PG_GETARG_VARLENA_P(0);
+	text* search = (text*) PG_GETARG_VARLENA_P(1);
+	bool result;
+
+	PB_TRACE(errmsg("->contains_rna()"));
+
+	result = sequence_strpos(seq, search, fixed_rna_codes) > 0;
+
+	PB_TRACE(errmsg("<-contains_rna()"));
+
+	PG_RETURN_BOOL(result);
+}
+
+/**
+ * planner_support_rna()
+ * 		Planner support for strpos() and contains() of RNA sequences.
+ */
+PG_FUNCTION_INFO_V1 (planner_support_rna);
+Datum planner_support_rna(PG_FUNCTION_ARGS)
+{
+	return sequence_planner_support(fcinfo, 4, PB_NUCLEOTIDE_BITS_PER_SYMBOL);
+}
+
+/**
+ * strpos_all_rna()
+ * 		Returns the positions of all, possibly overlapping, occurrences
+ * 		of a pattern. The optional third and fourth argument restrict
+ * 		the search to a window of the sequence.
+ */
+PG_FUNCTION_INFO_V1 (strpos_all_rna);
+Datum strpos_all_rna(PG_FUNCTION_ARGS)
+{
+	FuncCallContext* funcctx;
+	uint32* positions;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		Varlena* seq;
+		text* search;
+		uint32 from = 1;
+		uint32 to = PG_UINT32_MAX;
+
+		PB_TRACE(errmsg("->strpos_all_rna()"));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+		search = (text*) PG_GETARG_TEXT_PP(1);
+
+		if (PG_NARGS() == 4)
+		{
+			from = Max(PG_GETARG_INT32(2), 1);
+			to = Max(PG_GETARG_INT32(3), 0);
+		}
+
+		funcctx->max_calls = sequence_find_all(seq, search, from, to, fixed_rna_codes, &positions);
+		funcctx->user_fctx = positions;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		PB_TRACE(errmsg("<-strpos_all_rna()"));
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	positions = (uint32*) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+		SRF_RETURN_NEXT(funcctx, UInt32GetDatum(positions[funcctx->call_cntr]));
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/**
+ * count_occurrences_rna()
+ * 		Counts all, possibly overlapping, occurrences of a pattern. The
+ * 		optional third and fourth argument restrict the search to a
+ * 		window of the sequence.
+ */
+PG_FUNCTION_INFO_V1 (count_occurrences_rna);
+Datum count_occurrences_rna(PG_FUNCTION_ARGS)
+{
+	Varlena* seq = (Varlena*) PG_GETARG_RAW_VARLENA_P(0);
+	text* search = (text*) PG_GETARG_TEXT_PP(1);
+	uint32 from = 1;
+	uint32 to = PG_UINT32_MAX;
+	uint32 result;
+
+	PB_TRACE(errmsg("->count_occurrences_rna()"));
+
+	if (PG_NARGS() == 4)
+	{
+		from = Max(PG_GETARG_INT32(2), 1);
+		to = Max(PG_GETARG_INT32(3), 0);
+	}
+
+	result = sequence_find_all(seq, search, from, to, fixed_rna_codes, NULL);
+
+	PB_TRACE(errmsg("<-count_occurrences_rna()"));
+
+	PG_RETURN_INT64(result);
+}
+
 /**
  * octet_length_rna()
  * 		Returns byte size of datum.
@@ -1185,3 +1500,59 @@ Datum octet_length_rna(PG_FUNCTION_ARGS)
 	PG_RETURN_UINT32((uint32) toast_raw_datum_size((Datum) PG_GETARG_RAW_VARLENA_P(0)));
 }
 
+/**
+ * concat_rna()
+ * 		Concatenates two RNA sequences. If both were compressed with
+ * 		the same case insensitive fixed code, the second one is appended
+ * 		without decoding the first one. Otherwise both are decoded and
+ * 		compressed again with the default type modifier, like text cast
+ * 		to the type, keeping the composition and the index density of
+ * 		the first sequence.
+ *
+ * 	Varlena* seq1 : possibly toasted first sequence
+ * 	Varlena* seq2 : possibly toasted second sequence
+ */
+PG_FUNCTION_INFO_V1 (concat_rna);
+Datum concat_rna(PG_FUNCTION_ARGS)
+{
+	Varlena* seq1 = PG_GETARG_RAW_VARLENA_P(0);
+	Varlena* seq2 = PG_GETARG_RAW_VARLENA_P(1);
+	PB_RnaSequenceTypMod typmod = int_to_rna_sequence_typmod(0);
+	PB_CompressedSequence* header;
+
+	PB_SequenceInfo* info;
+	PB_CompressedSequence* result;
+	uint8* input;
+	uint32 length;
+
+	PB_TRACE(errmsg("->concat_rna()"));
+
+	result = sequence_concat(seq1, seq2, fixed_rna_codes);
+	if (result != NULL)
+	{
+		PB_TRACE(errmsg("<-concat_rna(): appended"));
+		PG_RETURN_POINTER(result);
+	}
+
+	/*
+	 * Keep the composition and the index density of the first sequence.
+	 */
+	header = (PB_CompressedSequence*)
+			 PG_DETOAST_DATUM_SLICE(seq1, 0, sizeof(PB_CompressedSequence) - VARHDRSZ);
+	if (header->has_composition)
+		typmod.composition = PB_RNA_TYPMOD_COMPOSITION;
+	typmod.index_shift = header->index_shift;
+	pfree(header);
+
+	input = sequence_concat_decoded(seq1, seq2, fixed_rna_codes, &length);
+
+	info = get_sequence_info_cstring(input, 0);
+	result = compress_rna_sequence(input, typmod, info);
+
+	PB_SEQUENCE_INFO_PFREE(info);
+	pfree(input);
+
+	PB_TRACE(errmsg("<-concat_rna()"));
+
+	PG_RETURN_POINTER(result);
+}
@@ -465,6 +465,12 @@ DROP TABLE aa_sequence_test_ascii_cs;
 
 SELECT test_set, test_type, count(*) FROM aa_sequence_errors GROUP BY test_set, test_type;
 
+/* index density */
+SELECT seq::text = s, substr(seq, 70001, 50) = substr(s, 70001, 50) FROM (SELECT s, s::aa_sequence('index=1024') AS seq FROM (SELECT generate_sequence(aa_iupac(), 150000) AS s) AS q1) AS q2; /* t t */
+CREATE TABLE aa_sequence_typmod_test (seq aa_sequence(composition, 'index=1024'));
+SELECT format_type(atttypid, atttypmod) FROM pg_attribute WHERE attrelid = 'aa_sequence_typmod_test'::regclass AND attname = 'seq';
+DROP TABLE aa_sequence_typmod_test;
+
 /*
 *SET client_min_messages=DEBUG1;
 *SELECT show_counts();
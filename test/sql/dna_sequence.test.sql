@@ -1409,6 +1409,154 @@ DROP TABLE dna_sequence_test_reference;
 
 SELECT test_set, test_type, count(*) FROM dna_sequence_errors GROUP BY test_set, test_type;
 
+SELECT hits > 0 FROM decoding_map_cache_stats(); /* t */
+SELECT fixed_entries > 0 FROM decoding_map_cache_stats(); /* t */
+
+/* streaming aggregate */
+CREATE TABLE dna_sequence_agg_test AS
+  SELECT n, CASE WHEN n = 70 THEN generate_sequence('{A,C,G,T,N,a}'::alphabet, 1000)
+                 ELSE generate_sequence('{A,C,G,T}'::alphabet, 1000) END AS chunk
+  FROM generate_series(1, 100) AS n;
+
+SELECT compressed::text = raw, substr(compressed, 70000, 100) = substr(raw, 70000, 100) FROM (
+  SELECT dna_sequence_agg(chunk ORDER BY n) AS compressed, string_agg(chunk, '' ORDER BY n) AS raw
+  FROM dna_sequence_agg_test
+) AS a; /* t t */
+
+DROP TABLE dna_sequence_agg_test;
+
+SELECT dna_sequence_agg(chunk) IS NULL FROM (VALUES (NULL::text), (NULL::text)) AS a (chunk); /* t */
+SELECT dna_sequence_agg(chunk ORDER BY n)::text FROM (VALUES (1, NULL::text), (2, 'ACGT'), (3, NULL)) AS a (n, chunk); /* ACGT */
+
+/* equality of sequences with same and different codes */
+SELECT seq::dna_sequence = seq::dna_sequence,
+       seq::dna_sequence(SHORT,FLC,CASE_SENSITIVE) = seq::dna_sequence(DEFAULT,IUPAC,CASE_SENSITIVE),
+       (seq || 'A')::dna_sequence = (seq || 'C')::dna_sequence
+FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 100000) AS seq) AS a; /* t t f */
+
+/* ordering of sequences with same and different codes */
+SELECT seq::dna_sequence < (seq || 'A')::dna_sequence,
+       (seq || 'C')::dna_sequence > (seq || 'A')::dna_sequence(DEFAULT,IUPAC,CASE_SENSITIVE),
+       ('G' || seq)::dna_sequence > ('T' || seq)::dna_sequence
+FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 100000) AS seq) AS a; /* t t f */
+
+/* sort support */
+CREATE TABLE dna_sequence_sort_test AS
+  SELECT generate_sequence('{A,C,G,T,N}'::alphabet, (random() * 60)::integer + 1) AS seq
+  FROM generate_series(1, 2000);
+
+SELECT count(*) FROM (
+  SELECT rank() OVER (ORDER BY seq::dna_sequence) AS a, rank() OVER (ORDER BY seq COLLATE "C") AS b
+  FROM dna_sequence_sort_test
+) AS a WHERE a <> b; /* 0 */
+
+DROP TABLE dna_sequence_sort_test;
+
+/* hash values are stable */
+SELECT sequence_hash_version(), hash_dna('ACGTACGTACGTN'::dna_sequence); /* 1 -922584314 */
+
+/* strpos with patterns longer than 64 symbols */
+SELECT strpos(seq::dna_sequence, substr(seq, 50001, 300)), strpos(seq::dna_sequence, substr(seq, 1, 299) || 'N')
+FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 100000) AS seq) AS a; /* 50001 0 */
+SELECT strpos(seq::dna_sequence, substr(seq, 99873, 128)), strpos(seq::dna_sequence, substr(seq, 50001, 129) || translate(substr(seq, 50130, 1), 'ACGT', 'CATG')), strpos(seq::dna_sequence, repeat('ACGT', 30))
+FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 100000) AS seq) AS a; /* 99873 0 0 */
+
+/* all occurrences */
+SELECT strpos_all('ACGACGACG'::dna_sequence, 'ACG'); /* 1 4 7 */
+SELECT count_occurrences('AAAAA'::dna_sequence, 'AA'), count_occurrences('AAAAA'::dna_sequence, 'AA', 2, 4); /* 4 2 */
+
+/* k-mer index */
+CREATE TABLE dna_sequence_kmer_test AS
+  SELECT generate_sequence('{A,C,G,T}'::alphabet, 200)::dna_sequence AS seq
+  FROM generate_series(1, 500);
+CREATE INDEX dna_sequence_kmer_test_idx ON dna_sequence_kmer_test USING gin (seq);
+ANALYZE dna_sequence_kmer_test;
+SET enable_seqscan = off;
+
+SELECT (SELECT count(*) FROM dna_sequence_kmer_test WHERE seq @> 'ACGTACGTAC') =
+       (SELECT count(*) FROM dna_sequence_kmer_test WHERE strpos(seq, 'ACGTACGTAC') > 0),
+       (SELECT count(*) FROM dna_sequence_kmer_test WHERE seq @> 'ACG') =
+       (SELECT count(*) FROM dna_sequence_kmer_test WHERE strpos(seq, 'ACG') > 0); /* t t */
+
+/* contains() uses the k-mer index, its estimate depends on the pattern length */
+EXPLAIN (COSTS OFF) SELECT * FROM dna_sequence_kmer_test WHERE contains(seq, 'ACGTACGTAC');
+CREATE FUNCTION dna_sequence_kmer_test_rows(query text) RETURNS float8 AS $$
+DECLARE
+  plan json;
+BEGIN
+  EXECUTE 'EXPLAIN (FORMAT JSON) ' || query INTO plan;
+  RETURN (plan->0->'Plan'->>'Plan Rows')::float8;
+END;
+$$ LANGUAGE plpgsql;
+SELECT dna_sequence_kmer_test_rows('SELECT * FROM dna_sequence_kmer_test WHERE contains(seq, ''ACG'')') > 400,
+       dna_sequence_kmer_test_rows('SELECT * FROM dna_sequence_kmer_test WHERE contains(seq, ''ACGTACGTACGTACGT'')') = 1; /* t t */
+DROP FUNCTION dna_sequence_kmer_test_rows(text);
+
+RESET enable_seqscan;
+DROP TABLE dna_sequence_kmer_test;
+
+/* k-mer index with the longest k-mers over short rows */
+CREATE TABLE dna_sequence_kmer12_test AS
+  SELECT generate_sequence('{A,C,G,T}'::alphabet, 150)::dna_sequence AS seq
+  FROM generate_series(1, 2000);
+CREATE INDEX dna_sequence_kmer12_test_idx ON dna_sequence_kmer12_test USING gin (seq dna_sequence_kmer12_ops);
+SET enable_seqscan = off;
+SELECT (SELECT count(*) FROM dna_sequence_kmer12_test WHERE seq @> p) = (SELECT count(*) FROM dna_sequence_kmer12_test WHERE strpos(seq, p) > 0),
+       (SELECT count(*) FROM dna_sequence_kmer12_test WHERE seq @> p) > 0
+FROM (SELECT substr(seq::text, 51, 30) AS p FROM dna_sequence_kmer12_test LIMIT 1) AS q; /* t t */
+RESET enable_seqscan;
+DROP TABLE dna_sequence_kmer12_test;
+
+/* contains function */
+SELECT contains('ACGTACGTNACGT'::dna_sequence, 'GTNAC'), contains('ACGTACGTNACGT'::dna_sequence, 'GTTAC'), contains('ACGTACGTNACGT'::dna_sequence, ''); /* t f f */
+
+/* fm_index */
+SELECT length(fm_index('ACGTACGTNACGTA'::dna_sequence)), count(fm_index('ACGTACGTNACGTA'::dna_sequence), 'ACGTA'), count(fm_index('ACGTACGTNACGTA'::dna_sequence), 'ACGTT'); /* 14 2 0 */
+SELECT array_agg(p) FROM locate(fm_index('ACGTACGTNACGTA'::dna_sequence), 'CGT') AS p; /* {2,6,11} */
+SELECT fm_index('ACGTACGTNACGTA'::dna_sequence)::text = 'ACGTACGTNACGTA'; /* t */
+
+/* fm_index of a toasted sequence */
+CREATE TABLE dna_sequence_fm_index_test (seq dna_sequence, idx fm_index);
+ALTER TABLE dna_sequence_fm_index_test ALTER COLUMN seq SET STORAGE EXTERNAL, ALTER COLUMN idx SET STORAGE EXTERNAL;
+INSERT INTO dna_sequence_fm_index_test SELECT seq, fm_index(seq) FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 100000)::dna_sequence AS seq) AS q;
+SELECT pg_relation_size(reltoastrelid) > 0 FROM pg_class WHERE relname = 'dna_sequence_fm_index_test'; /* t */
+SELECT p, count(idx, p) = count_occurrences(seq, p), ARRAY(SELECT locate(idx, p)) = ARRAY(SELECT strpos_all(seq, p)) FROM dna_sequence_fm_index_test, unnest(ARRAY['A', 'CG', 'ACGTA', 'GATTACA', 'ACGTACGTACGTACGT', 'N']) AS p;
+DROP TABLE dna_sequence_fm_index_test;
+
+/* composition functions */
+SELECT gc_content('ACGTGGCCNA'::dna_sequence), entropy('ACGT'::dna_sequence); /* 0.6 2 */
+SELECT * FROM base_counts('ACGTGGCCNA'::dna_sequence);
+SELECT abs(gc_content(seq) - gc_content(get_alphabet(seq))) < 0.0001 FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 100000)::dna_sequence AS seq) AS q; /* t */
+
+/* composition of ranges */
+SELECT * FROM base_counts(repeat('AACG', 50000)::dna_sequence(composition), 65530, 131080);
+SELECT gc_content(seq, 70001, 200000) = gc_content(substr(seq, 70001, 200000)::dna_sequence), gc_content(complement(seq), 70001, 200000) = gc_content(seq, 70001, 200000) FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 300000)::dna_sequence(composition) AS seq) AS q; /* t t */
+
+SELECT * FROM base_counts('ACGTGGCCNA'::dna_sequence(composition));
+SELECT get_alphabet(seq)::text = get_alphabet(seq::text::dna_sequence)::text, gc_content(complement(seq)) = gc_content(seq) FROM (SELECT generate_sequence('{A,C,G,T,N}'::alphabet, 100000)::dna_sequence(composition) AS seq) AS q; /* t t */
+SELECT substr(seq, 70001, 200) = substr(seq::text, 70001, 200), substr(seq, 299990, 20) = substr(seq::text, 299990, 20) FROM (SELECT generate_sequence('{A,C,G,T,N}'::alphabet, 300000)::dna_sequence(reference, 512) AS seq) AS q; /* t t */
+SELECT substr(repeat('ACGTTGCA', 10000)::dna_sequence(reference, 'index=4096'), 5000, 10);
+SELECT 'ACGT'::dna_sequence(1000);
+SELECT gc_content(seq, 70001, 200000) = gc_content(substr(seq, 70001, 200000)::dna_sequence), octet_length(seq) - octet_length(seq::text::dna_sequence(composition)) < 4000 FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 300000)::dna_sequence(composition, 512) AS seq) AS q; /* t t */
+/* concatenation */
+SELECT ('acgtn'::dna_sequence || 'ACGT'::dna_sequence)::text;
+SELECT (a || b)::text = a::text || b::text, substr(a || b, 79990, 20) = substr(a::text || b::text, 79990, 20) FROM (SELECT repeat('ACGTTGCA', 10000)::dna_sequence(flc) AS a, generate_sequence('{A,C,G,T}'::alphabet, 70001)::dna_sequence(flc) AS b) AS q; /* t t */
+SELECT (a || b)::text = a::text || b::text, substr(a || b, 65530, 20) = substr(a::text || b::text, 65530, 20) FROM (SELECT generate_sequence('{A,C,G,T,N}'::alphabet, 65000)::dna_sequence(iupac, short) AS a, generate_sequence('{A,C,G,T,N,R}'::alphabet, 70000)::dna_sequence(iupac, short) AS b) AS q; /* t t */
+/* translation */
+SELECT translate('ATGGCCattGTAATGGGCCGCTGA'::dna_sequence)::text;
+SELECT translate(seq, t)::text = translate(transcribe(complement(seq)), t)::text, translate(seq, t)::text = translate(seq::text::dna_sequence(iupac), t)::text, char_length(translate(seq, t)) = 66667 FROM (SELECT generate_sequence('{A,C,G,T}'::alphabet, 200001)::dna_sequence(flc) AS seq, replace(standard_code(), '*', 'X') AS t) AS q; /* t t t */
+SELECT translate('ATGTGAAGG'::dna_sequence, 1)::text, translate('ATGTGAAGG'::dna_sequence, 2)::text;
+/* transcription by relabeling */
+SELECT transcribe('ACGTNacgt'::dna_sequence)::text, reverse_transcribe('ACGUNacgu'::rna_sequence)::text, transcribe('ACGT'::dna_sequence(flc))::text;
+
+/* ranges starting in the last part of a run-length encoded sequence */
+SELECT substr(seq::dna_sequence(reference), 209901, 100) = substr(seq, 209901, 100), substr(seq::dna_sequence(reference), 196600, 20) = substr(seq, 196600, 20) FROM (SELECT repeat('NNNNNNNNNNACGT', 15000) AS seq) AS q; /* t t */
+
+/* type modifier output */
+CREATE TABLE dna_sequence_typmod_test (seq dna_sequence(reference));
+SELECT format_type(atttypid, atttypmod) FROM pg_attribute WHERE attrelid = 'dna_sequence_typmod_test'::regclass AND attname = 'seq';
+DROP TABLE dna_sequence_typmod_test;
+
 /*
 *SET client_min_messages=DEBUG1;
 *SELECT show_counts();
@@ -756,6 +756,28 @@ DROP TABLE rna_sequence_test_ascii_cs;
 
 SELECT test_set, test_type, count(*) FROM rna_sequence_errors GROUP BY test_set, test_type;
 
+/* six frames */
+SELECT s::text FROM six_frame('AUGGCCauuGUAAUGGG'::rna_sequence) AS s;
+SELECT s::text FROM six_frame_translate('AUGGCCAUUGUAAUGGGCCGCUGAAAGGGUGCCCGAUAG'::rna_sequence) AS s;
+
+/* translation */
+SELECT translate('AUGGCCauuGUAnNUGGGUAA'::rna_sequence)::text;
+SELECT translate(complement(seq), t)::text = translate(complement(seq)::text::rna_sequence, t)::text, char_length(translate(complement(seq), t)) = 66667 FROM (SELECT generate_sequence('{A,C,G,U}'::alphabet, 200001)::rna_sequence(FLC,CASE_INSENSITIVE) AS seq, replace(standard_code(), '*', 'X') AS t) AS q; /* t t */
+SELECT translate('AUGGCNUAYCARYUNMGNUUR'::rna_sequence, 1)::text;
+SELECT translate('AUGNNNUGAAUA'::rna_sequence, vertebrate_mitochondrial_code())::text, translate('AUGNNNUGAAUA'::rna_sequence, 2)::text;
+SELECT s::text FROM six_frame_translate('AUGGCCAUUGUAAUGGGCCGCUGAAAGGGUGCCCGAUAG'::rna_sequence, 11) AS s;
+SELECT s::text FROM six_frame_translate('AUGGCCUAGGUAAUGUAGCCCUAA'::rna_sequence, 32) AS s;
+SELECT translate('AUG'::rna_sequence, 7);
+
+/* short IUPAC input with the ASCII type modifier */
+SELECT 'ACGUNRY'::rna_sequence(ascii)::text; /* ACGUNRY */
+
+/* index density */
+SELECT seq::text = s, substr(seq, 70001, 50) = substr(s, 70001, 50) FROM (SELECT s, s::rna_sequence(4096) AS seq FROM (SELECT generate_sequence('{A,C,G,U,N}'::alphabet, 200000) AS s) AS q1) AS q2; /* t t */
+CREATE TABLE rna_sequence_typmod_test (seq rna_sequence(flc, 4096));
+SELECT format_type(atttypid, atttypmod) FROM pg_attribute WHERE attrelid = 'rna_sequence_typmod_test'::regclass AND attname = 'seq';
+DROP TABLE rna_sequence_typmod_test;
+
 /*
 *SET client_min_messages=DEBUG1;
 *SELECT show_counts();